@@ -0,0 +1,35 @@
+#include <benchmark/benchmark.h>
+#include <cpu6502/batch.hpp>
+
+namespace {
+constexpr u32 JOBS = 4096;
+constexpr u32 COPIES = 67;
+// LDX $10; LDA $11; LDY $20,X; STA $0300; STY $0301; NOP: six instructions and 20 cycles, so a job runs about 400
+// instructions.
+constexpr u32 JOB_CYCLES = COPIES * 20;
+
+void LoadJobProgram(Memory &memory) {
+    memory.WriteWord(0xFFFC, 0x8000);
+    const Byte pattern[] = {0xA6, 0x10, 0xA5, 0x11, 0xB4, 0x20, 0x8D, 0x00, 0x03, 0x8C, 0x01, 0x03, 0xEA};
+    for (u32 i = 0; i < COPIES; ++i)
+        memory.WriteBlock(static_cast<Word>(0x8000 + i * sizeof(pattern)), pattern, sizeof(pattern));
+}
+
+// Throughput of JOBS jobs with two patches each on state.range(0) worker threads; 0 uses every hardware thread.
+void BM_Batch(benchmark::State &state) {
+    Memory image;
+    LoadJobProgram(image);
+    BatchRunner runner(image);
+    runner.Reserve(JOBS, 2 * JOBS);
+    for (u32 job = 0; job < JOBS; ++job)
+        runner.AddJob({{0x10, static_cast<Byte>(job % 32)}, {0x11, static_cast<Byte>(job)}});
+    runner.AddCapture(0x0300, 2);
+    for (auto _ : state) {
+        runner.Run(JOB_CYCLES, static_cast<unsigned>(state.range(0)));
+        benchmark::DoNotOptimize(runner.Result(JOBS - 1).A);
+    }
+    state.counters["jobs_per_sec"] =
+        benchmark::Counter(static_cast<double>(state.iterations()) * JOBS, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Batch)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(0)->UseRealTime();
+} // namespace
@@ -0,0 +1,218 @@
+#include <benchmark/benchmark.h>
+#include <cpu6502/block_cache.hpp>
+#include <cpu6502/config.hpp>
+#include <cpu6502/debugger.hpp>
+#include <cpu6502/jit.hpp>
+#include <cpu6502/profiler.hpp>
+#include <cpu6502/trace.hpp>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr Word PROGRAM = 0x8000;
+// Copies of the pattern run per Execute call.
+constexpr u32 REPEATS = 256;
+
+// One instruction pattern, repeated back to back from PROGRAM.
+struct Workload {
+    const char *name;
+    std::vector<Byte> pattern;
+    u32 instructions;
+    u32 cycles;
+};
+
+// X and Y are 0x10 when a workload starts. The pointers at $20 and $30 point to $3000, the one at $22 to $30F8, and
+// the _cross variants index across into page $31.
+const std::vector<Workload> &AddressingModes() {
+    static const std::vector<Workload> modes = {
+        {"lda_imm", {0xA9, 0x05}, 1, 2},
+        {"lda_zp", {0xA5, 0x10}, 1, 3},
+        {"lda_zp_x", {0xB5, 0x10}, 1, 4},
+        {"ldx_zp_y", {0xB6, 0x10}, 1, 4},
+        {"lda_abs", {0xAD, 0x00, 0x30}, 1, 4},
+        {"lda_abs_x", {0xBD, 0x00, 0x30}, 1, 4},
+        {"lda_abs_x_cross", {0xBD, 0xF8, 0x30}, 1, 5},
+        {"lda_abs_y", {0xB9, 0x00, 0x30}, 1, 4},
+        {"lda_abs_y_cross", {0xB9, 0xF8, 0x30}, 1, 5},
+        {"lda_ind_x", {0xA1, 0x10}, 1, 6},
+        {"lda_ind_y", {0xB1, 0x20}, 1, 5},
+        {"lda_ind_y_cross", {0xB1, 0x22}, 1, 6},
+        {"sta_zp", {0x85, 0x40}, 1, 3},
+        {"sta_abs", {0x8D, 0x00, 0x02}, 1, 4},
+        {"sta_abs_x", {0x9D, 0x00, 0x02}, 1, 5},
+        {"sta_abs_y", {0x99, 0x00, 0x02}, 1, 5},
+        {"sta_ind_y", {0x91, 0x20}, 1, 6},
+        {"nop", {0xEA}, 1, 2},
+    };
+    return modes;
+}
+
+// Straight-line loop bodies standing in for typical code: a table copy, zero-page bookkeeping and pointer walks.
+const std::vector<Workload> &Programs() {
+    static const std::vector<Workload> programs = {
+        // LDA $3000,X; STA $0200,X; LDA $3000,Y; STA $0200,Y
+        {"copy", {0xBD, 0x00, 0x30, 0x9D, 0x00, 0x02, 0xB9, 0x00, 0x30, 0x99, 0x00, 0x02}, 4, 18},
+        // LDA $10; LDX $11; STA $12; STX $13; LDY #$01; STY $14
+        {"zero_page", {0xA5, 0x10, 0xA6, 0x11, 0x85, 0x12, 0x86, 0x13, 0xA0, 0x01, 0x84, 0x14}, 6, 17},
+        // LDA ($20),Y; STA ($24),Y; LDA ($10,X); NOP
+        {"pointers", {0xB1, 0x20, 0x91, 0x24, 0xA1, 0x10, 0xEA}, 4, 19},
+    };
+    return programs;
+}
+
+void LoadWorkload(Memory &memory, const Workload &workload) {
+    memory.WriteWord(0xFFFC, PROGRAM);
+    memory.WriteWord(0x0020, 0x3000);
+    memory.WriteWord(0x0022, 0x30F8);
+    memory.WriteWord(0x0024, 0x0400);
+    memory.WriteWord(0x0030, 0x3000);
+    const auto size = static_cast<Word>(workload.pattern.size());
+    for (u32 i = 0; i < REPEATS; ++i)
+        memory.WriteBlock(static_cast<Word>(PROGRAM + i * size), workload.pattern.data(), size);
+}
+
+// Reports emulated clock rate (cycles per second, so 1M/s is 1 MHz) and host time per emulated instruction.
+void SetRateCounters(benchmark::State &state, const u64 instructions, const u64 cycles) {
+    state.SetItemsProcessed(static_cast<std::int64_t>(instructions));
+    state.counters["emulated_hz"] = benchmark::Counter(static_cast<double>(cycles), benchmark::Counter::kIsRate);
+    state.counters["host_time_per_instr"] = benchmark::Counter(
+        static_cast<double>(instructions), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+// Runs REPEATS copies of the workload per iteration, starting from Reset. Instruction observers and profilers, when
+// given, are attached for the whole run. A debugged run attaches a debugger with a breakpoint and a watchpoint on
+// pages the workload never touches.
+template <typename Policy>
+void RunWorkload(benchmark::State &state, const Workload &workload, InstructionObserver *observer = nullptr,
+                 Profiler *profiler = nullptr, const bool debugged = false) {
+    Memory memory;
+    LoadWorkload(memory, workload);
+    BasicCPU<Policy> cpu(memory);
+    if constexpr (Policy::TRACE)
+        cpu.SetObserver(observer);
+    if constexpr (Policy::PROFILE)
+        cpu.SetProfiler(profiler);
+    Debugger debugger(memory);
+    if (debugged) {
+        cpu.SetDebugger(&debugger);
+        debugger.AddBreakpoint(0xF000);
+        debugger.AddWatchpoint(0xE000, 0xE0FF, true, true);
+    }
+    const u32 budget = (Policy::COUNT_CYCLES ? workload.cycles : workload.instructions) * REPEATS;
+    for (auto _ : state) {
+        cpu.Reset();
+        cpu.X = 0x10;
+        cpu.Y = 0x10;
+        cpu.Execute(budget);
+        benchmark::DoNotOptimize(cpu.A);
+    }
+    const auto iterations = static_cast<u64>(state.iterations());
+    SetRateCounters(state, iterations * REPEATS * workload.instructions, iterations * REPEATS * workload.cycles);
+}
+
+void BM_AddressingMode(benchmark::State &state, const Workload &workload) {
+    RunWorkload<CycleAccuratePolicy>(state, workload);
+}
+
+void BM_Program(benchmark::State &state, const Workload &workload) { RunWorkload<CycleAccuratePolicy>(state, workload); }
+
+void BM_ProgramFunctional(benchmark::State &state, const Workload &workload) {
+    RunWorkload<FunctionalPolicy>(state, workload);
+}
+
+// A TracingCPU without an observer should run as fast as CPU.
+void BM_ProgramTracingDisabled(benchmark::State &state, const Workload &workload) {
+    RunWorkload<TracingPolicy>(state, workload);
+}
+
+void BM_ProgramTraceRing(benchmark::State &state, const Workload &workload) {
+    TraceRing ring(1 << 16);
+    RunWorkload<TracingPolicy>(state, workload, &ring);
+}
+
+void BM_ProgramProfiled(benchmark::State &state, const Workload &workload) {
+    Profiler profiler;
+    RunWorkload<ProfilingPolicy>(state, workload, nullptr, &profiler);
+}
+
+// Costs the page flag test before every instruction.
+void BM_ProgramDebugged(benchmark::State &state, const Workload &workload) {
+    RunWorkload<CycleAccuratePolicy>(state, workload, nullptr, nullptr, true);
+}
+
+// Runs the workload like RunWorkload, through an engine that keeps its decoded or compiled blocks across iterations.
+template <typename Engine> void RunEngine(benchmark::State &state, const Workload &workload) {
+    Memory memory;
+    LoadWorkload(memory, workload);
+    CPU cpu(memory);
+    Engine engine(cpu);
+    if constexpr (std::is_same_v<Engine, Jit>) {
+        if (!engine.Available()) {
+            state.SkipWithError("the JIT backend is not available on this host");
+            return;
+        }
+    }
+    for (auto _ : state) {
+        cpu.Reset();
+        cpu.X = 0x10;
+        cpu.Y = 0x10;
+        engine.Execute(workload.cycles * REPEATS);
+        benchmark::DoNotOptimize(cpu.A);
+    }
+    const auto iterations = static_cast<u64>(state.iterations());
+    SetRateCounters(state, iterations * REPEATS * workload.instructions, iterations * REPEATS * workload.cycles);
+    if constexpr (std::is_same_v<Engine, Jit>)
+        state.counters["native_runs"] = static_cast<double>(engine.NativeBlockRuns());
+}
+
+void BM_BlockCache(benchmark::State &state, const Workload &workload) { RunEngine<BlockCache>(state, workload); }
+
+void BM_Jit(benchmark::State &state, const Workload &workload) { RunEngine<Jit>(state, workload); }
+
+void BM_CPUReset(benchmark::State &state) {
+    Memory memory;
+    memory.WriteWord(0xFFFC, PROGRAM);
+    CPU cpu(memory);
+    for (auto _ : state) {
+        cpu.Reset();
+        benchmark::DoNotOptimize(cpu.PC);
+    }
+}
+BENCHMARK(BM_CPUReset);
+
+const char *DispatchEngine() {
+#if CPU6502_DISPATCH_SWITCH
+    return "switch";
+#elif CPU6502_DISPATCH_TABLE
+    return "table";
+#else
+    return "threaded";
+#endif
+}
+
+[[maybe_unused]] const bool registered = [] {
+    benchmark::AddCustomContext("cpu6502_version", CPU6502_VERSION);
+    benchmark::AddCustomContext("cpu6502_dispatch", DispatchEngine());
+    for (const Workload &mode : AddressingModes())
+        benchmark::RegisterBenchmark((std::string("BM_AddressingMode/") + mode.name).c_str(), BM_AddressingMode, mode);
+    using Runner = void (*)(benchmark::State &, const Workload &);
+    const std::pair<const char *, Runner> runners[] = {
+        {"BM_Program/", BM_Program},
+        {"BM_BlockCache/", BM_BlockCache},
+        {"BM_Jit/", BM_Jit},
+        {"BM_ProgramFunctional/", BM_ProgramFunctional},
+        {"BM_ProgramTracingDisabled/", BM_ProgramTracingDisabled},
+        {"BM_ProgramTraceRing/", BM_ProgramTraceRing},
+        {"BM_ProgramProfiled/", BM_ProgramProfiled},
+        {"BM_ProgramDebugged/", BM_ProgramDebugged},
+    };
+    for (const auto &[prefix, runner] : runners) {
+        for (const Workload &program : Programs())
+            benchmark::RegisterBenchmark((std::string(prefix) + program.name).c_str(), runner, program);
+    }
+    return true;
+}();
+} // namespace
@@ -0,0 +1,76 @@
+#include <benchmark/benchmark.h>
+#include <cpu6502/scheduler.hpp>
+#include <functional>
+
+namespace {
+constexpr u32 CYCLES = 1 << 16;
+
+// Timer whose IRQ is acknowledged by any write to its page.
+class Timer final : public BusDevice {
+public:
+    CPU *cpu = nullptr;
+
+    Byte Read(Word) override { return 0x00; }
+    void Write(Word, Byte) override { cpu->SetIRQ(false); }
+};
+
+// LDA $3000,X; STA $0200,X; LDA $10; NOP, repeated from $8000 with interrupts enabled. The IRQ handler at $FF00
+// acknowledges the timer and returns: LDA #$01; STA $D000; RTI.
+void LoadInterruptProgram(Memory &memory) {
+    memory.WriteWord(0xFFFC, 0x8000);
+    memory.WriteWord(0xFFFE, 0xFF00);
+    const Byte pattern[] = {0xBD, 0x00, 0x30, 0x9D, 0x00, 0x02, 0xA5, 0x10, 0xEA};
+    for (u32 addr = 0x8000; addr + sizeof(pattern) < 0xD000; addr += sizeof(pattern))
+        memory.WriteBlock(static_cast<Word>(addr), pattern, sizeof(pattern));
+    const Byte handler[] = {0xA9, 0x01, 0x8D, 0x00, 0xD0, 0x40};
+    memory.WriteBlock(0xFF00, handler, sizeof(handler));
+}
+
+void SetClockRate(benchmark::State &state) {
+    state.counters["emulated_hz"] = benchmark::Counter(static_cast<double>(state.iterations()) * CYCLES,
+                                                       benchmark::Counter::kIsRate);
+}
+
+// The interrupt lines stay idle, so this is the cost the pending-work check adds to plain code.
+void BM_InterruptFree(benchmark::State &state) {
+    Memory memory;
+    LoadInterruptProgram(memory);
+    CPU cpu(memory);
+    for (auto _ : state) {
+        cpu.Reset();
+        cpu.SetStatusRegister(0x00);
+        cpu.Execute(CYCLES);
+        benchmark::DoNotOptimize(cpu.A);
+    }
+    SetClockRate(state);
+}
+BENCHMARK(BM_InterruptFree);
+
+// A scheduled timer raises IRQ every state.range(0) cycles; each one costs the 7-cycle entry and a 12-cycle handler.
+void BM_InterruptTimer(benchmark::State &state) {
+    Memory memory;
+    LoadInterruptProgram(memory);
+    Timer timer;
+    memory.MapDevice(0xD0, 0xD0, &timer);
+    CPU cpu(memory);
+    timer.cpu = &cpu;
+    const auto period = static_cast<u64>(state.range(0));
+    u64 interrupts = 0;
+    for (auto _ : state) {
+        cpu.Reset();
+        cpu.SetStatusRegister(0x00);
+        Scheduler scheduler;
+        std::function<void(u64)> tick = [&](const u64 due) {
+            cpu.SetIRQ(true);
+            ++interrupts;
+            scheduler.Schedule(due + period, tick);
+        };
+        scheduler.Schedule(period, tick);
+        scheduler.Run(cpu, CYCLES);
+        benchmark::DoNotOptimize(cpu.A);
+    }
+    SetClockRate(state);
+    state.counters["interrupts"] = benchmark::Counter(static_cast<double>(interrupts), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_InterruptTimer)->Arg(64)->Arg(512)->Arg(4096);
+} // namespace
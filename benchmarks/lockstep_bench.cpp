@@ -0,0 +1,61 @@
+#include <benchmark/benchmark.h>
+#include <cpu6502/lockstep.hpp>
+#include <memory>
+
+namespace {
+// LDA $10; LDX $11; LDY #$01; LDA $3000,X; STA $0200,Y; NOP, repeated from $8000: 19 cycles per copy. X differs
+// per lane, so the indexed load gathers.
+constexpr Word PROGRAM_END = 0xF000;
+constexpr u32 COPIES = (PROGRAM_END - 0x8000) / 13;
+constexpr u32 CYCLES = COPIES * 19;
+
+void LoadLane(Memory &memory, const unsigned lane) {
+    memory.WriteWord(0xFFFC, 0x8000);
+    const Byte pattern[] = {0xA5, 0x10, 0xA6, 0x11, 0xA0, 0x01, 0xBD, 0x00, 0x30, 0x99, 0x00, 0x02, 0xEA};
+    for (u32 i = 0; i < COPIES; ++i)
+        memory.WriteBlock(static_cast<Word>(0x8000 + i * sizeof(pattern)), pattern, sizeof(pattern));
+    memory.WriteByte(0x0010, static_cast<Byte>(lane));
+    memory.WriteByte(0x0011, static_cast<Byte>(lane * 5));
+}
+
+void SetClockRate(benchmark::State &state, const u32 lanes) {
+    state.counters["emulated_hz"] = benchmark::Counter(static_cast<double>(state.iterations()) * lanes * CYCLES,
+                                                       benchmark::Counter::kIsRate);
+}
+
+// The same program through CPU::Execute, which the lane clock rates compare against.
+void BM_LockstepBaseline(benchmark::State &state) {
+    Memory memory;
+    LoadLane(memory, 0);
+    CPU cpu(memory);
+    for (auto _ : state) {
+        cpu.Reset();
+        cpu.Execute(CYCLES);
+        benchmark::DoNotOptimize(cpu.A);
+    }
+    SetClockRate(state, 1);
+}
+BENCHMARK(BM_LockstepBaseline);
+
+// Clock rate summed over state.range(0) lanes. Reloading the lanes between iterations is not timed.
+void BM_Lockstep(benchmark::State &state) {
+    const auto lanes = static_cast<unsigned>(state.range(0));
+    Lockstep lockstep(lanes);
+    auto memory = std::make_unique<Memory>();
+    CPU cpu(*memory);
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (unsigned lane = 0; lane < lanes; ++lane) {
+            LoadLane(*memory, lane);
+            cpu.Reset();
+            lockstep.Load(lane, cpu, *memory);
+        }
+        state.ResumeTiming();
+        lockstep.Execute(CYCLES);
+        benchmark::DoNotOptimize(lockstep.ReadByte(0, 0x0210));
+    }
+    SetClockRate(state, lanes);
+    state.counters["scalar_fallbacks"] = static_cast<double>(lockstep.ScalarFallbacks());
+}
+BENCHMARK(BM_Lockstep)->Arg(1)->Arg(8)->Arg(32);
+} // namespace
@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+#include <cpu6502/machine.hpp>
+
+namespace {
+// Bytes touched per iteration by the access benchmarks: 16 pages, so page-table lookups dominate over cache misses.
+constexpr u32 SPAN = 16 * PAGE_BYTES;
+constexpr Word BASE = 0x2000;
+
+void BM_MemoryReadByte(benchmark::State &state) {
+    Memory memory;
+    for (u32 i = 0; i < SPAN; ++i)
+        memory.WriteByte(static_cast<Word>(BASE + i), static_cast<Byte>(i));
+    for (auto _ : state) {
+        u32 sum = 0;
+        for (u32 i = 0; i < SPAN; ++i)
+            sum += memory.ReadByte(static_cast<Word>(BASE + i));
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * SPAN);
+}
+BENCHMARK(BM_MemoryReadByte);
+
+void BM_MemoryReadWord(benchmark::State &state) {
+    Memory memory;
+    for (u32 i = 0; i < SPAN; ++i)
+        memory.WriteByte(static_cast<Word>(BASE + i), static_cast<Byte>(i));
+    for (auto _ : state) {
+        u32 sum = 0;
+        for (u32 i = 0; i < SPAN; i += 2)
+            sum += memory.ReadWord(static_cast<Word>(BASE + i));
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * SPAN / 2);
+}
+BENCHMARK(BM_MemoryReadWord);
+
+void BM_MemoryWriteByte(benchmark::State &state) {
+    Memory memory;
+    for (auto _ : state) {
+        for (u32 i = 0; i < SPAN; ++i)
+            memory.WriteByte(static_cast<Word>(BASE + i), static_cast<Byte>(i));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * SPAN);
+}
+BENCHMARK(BM_MemoryWriteByte);
+
+void BM_MemoryWriteWord(benchmark::State &state) {
+    Memory memory;
+    for (auto _ : state) {
+        for (u32 i = 0; i < SPAN; i += 2)
+            memory.WriteWord(static_cast<Word>(BASE + i), static_cast<Word>(i));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * SPAN / 2);
+}
+BENCHMARK(BM_MemoryWriteWord);
+
+// Forks a memory with every page populated, writes one byte into the fork and drops it.
+void BM_MemoryForkWriteDiscard(benchmark::State &state) {
+    Memory memory;
+    for (u32 page = 0; page < PAGE_COUNT; ++page)
+        memory.WriteByte(static_cast<Word>(page * PAGE_BYTES), static_cast<Byte>(page));
+    for (auto _ : state) {
+        Memory fork = memory.Fork();
+        fork.WriteByte(0x0200, 0x42);
+        benchmark::DoNotOptimize(fork);
+    }
+}
+BENCHMARK(BM_MemoryForkWriteDiscard);
+
+// The search workload Machine forks are made for: fork a prepared machine, run a short program, throw it away.
+void BM_MachineForkRunDiscard(benchmark::State &state) {
+    Machine machine;
+    // LDA $10; STA $0200; LDX #$07; STX $0300; NOP
+    const Byte program[] = {0xA5, 0x10, 0x8D, 0x00, 0x02, 0xA2, 0x07, 0x8E, 0x00, 0x03, 0xEA};
+    machine.memory.WriteBlock(0x8000, program, sizeof(program));
+    machine.memory.WriteWord(0xFFFC, 0x8000);
+    machine.cpu.Reset();
+    for (auto _ : state) {
+        Machine fork = machine.Fork();
+        fork.cpu.Execute(15);
+        benchmark::DoNotOptimize(fork.cpu.X);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MachineForkRunDiscard);
+} // namespace
@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+#include <cpu6502/rewind.hpp>
+
+namespace {
+constexpr u32 CYCLES = 1 << 14;
+
+// STA $0200; STA $0300; ... STA $7F00, repeated from $8000, so every checkpoint interval dirties up to 126 pages.
+void LoadStoreProgram(Memory &memory) {
+    memory.WriteWord(0xFFFC, 0x8000);
+    u32 addr = 0x8000;
+    while (addr + 3 <= 0xD000) {
+        for (u32 page = 0x02; page < 0x80 && addr + 3 <= 0xD000; ++page, addr += 3) {
+            const Byte store[] = {0x8D, 0x00, static_cast<Byte>(page)};
+            memory.WriteBlock(static_cast<Word>(addr), store, sizeof(store));
+        }
+    }
+}
+
+void SetClockRate(benchmark::State &state) {
+    state.counters["emulated_hz"] = benchmark::Counter(static_cast<double>(state.iterations()) * CYCLES,
+                                                       benchmark::Counter::kIsRate);
+}
+
+void BM_RewindOff(benchmark::State &state) {
+    Memory memory;
+    LoadStoreProgram(memory);
+    CPU cpu(memory);
+    cpu.Reset();
+    for (auto _ : state) {
+        cpu.PC = 0x8000;
+        cpu.Execute(CYCLES);
+        benchmark::DoNotOptimize(cpu.A);
+    }
+    SetClockRate(state);
+}
+BENCHMARK(BM_RewindOff);
+
+// Steady-state cost of checkpointing every state.range(0) cycles: the page-table fork per checkpoint plus one page
+// copy for the first store to each page after it. Old checkpoints are dropped at the default journal limit.
+void BM_Rewind(benchmark::State &state) {
+    Memory memory;
+    LoadStoreProgram(memory);
+    CPU cpu(memory);
+    cpu.Reset();
+    Rewind rewind(cpu, static_cast<u32>(state.range(0)));
+    // Restarts by moving PC only, as Reset would set the cycle count back before the recorded history.
+    for (auto _ : state) {
+        cpu.PC = 0x8000;
+        rewind.Execute(CYCLES);
+        benchmark::DoNotOptimize(cpu.A);
+    }
+    SetClockRate(state);
+    state.counters["journal_bytes"] = static_cast<double>(rewind.JournalBytes());
+}
+BENCHMARK(BM_Rewind)->Arg(1 << 12)->Arg(1 << 16)->Arg(1 << 20);
+
+// Latency of one reverse step, which replays up to an interval twice, and of seeking back to the end.
+void BM_RewindStepBack(benchmark::State &state) {
+    Memory memory;
+    LoadStoreProgram(memory);
+    CPU cpu(memory);
+    Rewind rewind(cpu, static_cast<u32>(state.range(0)));
+    cpu.Reset();
+    rewind.Execute(CYCLES - 1);
+    const u32 end = cpu.cycles;
+    for (auto _ : state) {
+        rewind.StepBack();
+        rewind.SeekCycle(end);
+    }
+}
+BENCHMARK(BM_RewindStepBack)->Arg(1 << 10)->Arg(1 << 12);
+} // namespace
@@ -0,0 +1,45 @@
+#include <benchmark/benchmark.h>
+#include <cpu6502/stepped.hpp>
+
+namespace {
+// LDA $3000,X; STA $0200,X; LDA ($20),Y; NOP, repeated from $8000.
+void LoadSteppedProgram(Memory &memory) {
+    memory.WriteWord(0xFFFC, 0x8000);
+    memory.WriteWord(0x0020, 0x3000);
+    const Byte pattern[] = {0xBD, 0x00, 0x30, 0x9D, 0x00, 0x02, 0xB1, 0x20, 0xEA};
+    for (u32 addr = 0x8000; addr + sizeof(pattern) < 0xFF00; addr += sizeof(pattern))
+        memory.WriteBlock(static_cast<Word>(addr), pattern, sizeof(pattern));
+}
+
+constexpr u32 CYCLES = 4096;
+
+// Same workload through the interpreter, for comparison.
+void BM_SteppedBaseline(benchmark::State &state) {
+    Memory memory;
+    LoadSteppedProgram(memory);
+    CPU cpu(memory);
+    for (auto _ : state) {
+        cpu.Reset();
+        cpu.Execute(CYCLES);
+        benchmark::DoNotOptimize(cpu.A);
+    }
+    state.counters["emulated_hz"] = benchmark::Counter(static_cast<double>(state.iterations()) * CYCLES,
+                                                       benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_SteppedBaseline);
+
+void BM_SteppedExecute(benchmark::State &state) {
+    Memory memory;
+    LoadSteppedProgram(memory);
+    CPU cpu(memory);
+    SteppedCPU stepped(cpu);
+    for (auto _ : state) {
+        cpu.Reset();
+        stepped.Execute(CYCLES);
+        benchmark::DoNotOptimize(cpu.A);
+    }
+    state.counters["emulated_hz"] = benchmark::Counter(static_cast<double>(state.iterations()) * CYCLES,
+                                                       benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_SteppedExecute);
+} // namespace
@@ -0,0 +1,334 @@
+// Differential fuzz target: decodes an input into a program, a memory image and a starting state, runs it through
+// CPU::Execute and through a second engine, and compares registers, status, cycles and all of memory. The first
+// divergence is minimized, reported on stderr and turned into a crash so the fuzzer keeps the input.
+//
+// Input layout: engine, budget (2 bytes), flags, A, X, Y, instruction count, then the instructions and finally
+// (address low, address high, value) memory patches. Opcode bytes are mapped onto the implemented opcodes.
+
+#include <cpu6502/block_cache.hpp>
+#include <cpu6502/jit.hpp>
+#include <cpu6502/lockstep.hpp>
+#include <cpu6502/opcodes.hpp>
+#if CPU6502_FUZZ_STEPPED
+#include <cpu6502/stepped.hpp>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr Word PROGRAM = 0x8000;
+constexpr u32 MAX_BUDGET = 2048;
+constexpr std::size_t MAX_INSTRUCTIONS = 64;
+
+enum class Engine : Byte {
+    BlockCache,
+    Jit,
+    Lockstep,
+#if CPU6502_FUZZ_STEPPED
+    Stepped,
+#endif
+    Count,
+};
+
+const char *EngineName(const Engine engine) {
+    switch (engine) {
+    case Engine::BlockCache:
+        return "BlockCache";
+    case Engine::Jit:
+        return "Jit";
+    case Engine::Lockstep:
+        return "Lockstep";
+#if CPU6502_FUZZ_STEPPED
+    case Engine::Stepped:
+        return "SteppedCPU";
+#endif
+    default:
+        return "?";
+    }
+}
+
+enum Flags : Byte {
+    IRQ = 0x01,
+    NMI = 0x02,
+    CLEAR_I = 0x04,
+    // Lockstep runs 1 + (flags >> 3 & 3) lanes, lane n with X advanced by n.
+    LANE_SHIFT = 3,
+};
+
+struct Patch {
+    Word address;
+    Byte value;
+};
+
+struct Case {
+    Engine engine;
+    u32 budget;
+    Byte flags;
+    Byte a;
+    Byte x;
+    Byte y;
+    std::vector<Byte> program;
+    std::vector<Patch> patches;
+};
+
+struct State {
+    Word pc;
+    Word sp;
+    Byte a;
+    Byte x;
+    Byte y;
+    Byte p;
+    u32 cycles;
+    std::unique_ptr<Memory> memory;
+};
+
+const std::vector<Byte> &ImplementedOpcodes() {
+    static const std::vector<Byte> opcodes = [] {
+        std::vector<Byte> implemented;
+        for (u32 code = 0; code < 256; ++code) {
+            if (IsImplemented(static_cast<Byte>(code)))
+                implemented.push_back(static_cast<Byte>(code));
+        }
+        return implemented;
+    }();
+    return opcodes;
+}
+
+std::optional<Case> Decode(const std::uint8_t *data, const std::size_t size) {
+    if (size < 8)
+        return std::nullopt;
+    Case c;
+    c.engine = static_cast<Engine>(data[0] % static_cast<Byte>(Engine::Count));
+    c.budget = 1 + (data[1] | data[2] << 8) % MAX_BUDGET;
+    c.flags = data[3];
+    c.a = data[4];
+    c.x = data[5];
+    c.y = data[6];
+    std::size_t at = 8;
+    const std::vector<Byte> &opcodes = ImplementedOpcodes();
+    for (std::size_t count = data[7] % MAX_INSTRUCTIONS; count > 0 && at < size; --count) {
+        const Byte opcode = opcodes[data[at++] % opcodes.size()];
+        c.program.push_back(opcode);
+        for (Byte i = 1; i < OPCODES[opcode].length; ++i)
+            c.program.push_back(at < size ? data[at++] : Byte{0});
+    }
+    for (; at + 3 <= size; at += 3)
+        c.patches.push_back({static_cast<Word>(data[at] | data[at + 1] << 8), data[at + 2]});
+    return c;
+}
+
+// Reset vector at the program, BRK and interrupts back to it, then the patches.
+std::unique_ptr<Memory> BuildMemory(const Case &c) {
+    auto memory = std::make_unique<Memory>();
+    memory->WriteWord(0xFFFC, PROGRAM);
+    memory->WriteWord(0xFFFE, PROGRAM);
+    memory->WriteWord(0xFFFA, PROGRAM);
+    memory->WriteBlock(PROGRAM, c.program.data(), c.program.size());
+    for (const Patch &patch : c.patches)
+        memory->WriteByte(patch.address, patch.value);
+    return memory;
+}
+
+void Prepare(CPU &cpu, const Case &c, const unsigned lane, const bool interrupts) {
+    cpu.Reset();
+    cpu.A = c.a;
+    cpu.X = static_cast<Byte>(c.x + lane);
+    cpu.Y = c.y;
+    if (c.flags & CLEAR_I)
+        cpu.SetStatusRegister(static_cast<Byte>(cpu.StatusRegister() & ~0x04));
+    if (interrupts && (c.flags & IRQ))
+        cpu.SetIRQ(true);
+    if (interrupts && (c.flags & NMI))
+        cpu.TriggerNMI();
+}
+
+State Capture(const CPU &cpu, std::unique_ptr<Memory> memory) {
+    return {cpu.PC, cpu.SP, cpu.A, cpu.X, cpu.Y, cpu.StatusRegister(), cpu.cycles, std::move(memory)};
+}
+
+unsigned Lanes(const Case &c) { return c.engine == Engine::Lockstep ? 1 + (c.flags >> LANE_SHIFT & 3) : 1; }
+
+// Lockstep machines carry no interrupt inputs, so their cases never raise any.
+bool Interrupts(const Case &c) { return c.engine != Engine::Lockstep; }
+
+State RunReference(const Case &c, const unsigned lane) {
+    auto memory = BuildMemory(c);
+    CPU cpu(*memory);
+    Prepare(cpu, c, lane, Interrupts(c));
+    cpu.Execute(c.budget);
+    return Capture(cpu, std::move(memory));
+}
+
+std::vector<State> RunEngine(const Case &c) {
+    std::vector<State> states;
+    if (c.engine == Engine::Lockstep) {
+        const unsigned lanes = Lanes(c);
+        Lockstep lockstep(lanes);
+        for (unsigned lane = 0; lane < lanes; ++lane) {
+            const auto memory = BuildMemory(c);
+            CPU cpu(*memory);
+            Prepare(cpu, c, lane, false);
+            lockstep.Load(lane, cpu, *memory);
+        }
+        lockstep.Execute(c.budget);
+        for (unsigned lane = 0; lane < lanes; ++lane) {
+            auto memory = std::make_unique<Memory>();
+            CPU cpu(*memory);
+            lockstep.Store(lane, cpu, *memory);
+            states.push_back(Capture(cpu, std::move(memory)));
+        }
+        return states;
+    }
+    auto memory = BuildMemory(c);
+    CPU cpu(*memory);
+    Prepare(cpu, c, 0, true);
+    switch (c.engine) {
+    case Engine::BlockCache: {
+        BlockCache cache(cpu);
+        cache.Execute(c.budget);
+        break;
+    }
+    case Engine::Jit: {
+        // Compiles every block on its first entry so short programs still reach native code.
+        Jit jit(cpu, 1);
+        jit.Execute(c.budget);
+        break;
+    }
+#if CPU6502_FUZZ_STEPPED
+    case Engine::Stepped: {
+        SteppedCPU stepped(cpu);
+        stepped.Execute(c.budget);
+        break;
+    }
+#endif
+    default:
+        break;
+    }
+    states.push_back(Capture(cpu, std::move(memory)));
+    return states;
+}
+
+std::string Compare(const State &expected, const State &actual) {
+    char line[96];
+    auto field = [&](const char *name, const unsigned want, const unsigned got) {
+        std::snprintf(line, sizeof(line), "%s: reference $%X, engine $%X", name, want, got);
+        return std::string(line);
+    };
+    if (expected.pc != actual.pc)
+        return field("PC", expected.pc, actual.pc);
+    if (expected.sp != actual.sp)
+        return field("SP", expected.sp, actual.sp);
+    if (expected.a != actual.a)
+        return field("A", expected.a, actual.a);
+    if (expected.x != actual.x)
+        return field("X", expected.x, actual.x);
+    if (expected.y != actual.y)
+        return field("Y", expected.y, actual.y);
+    if (expected.p != actual.p)
+        return field("P", expected.p, actual.p);
+    if (expected.cycles != actual.cycles)
+        return field("cycles", expected.cycles, actual.cycles);
+    for (u32 addr = 0; addr < MAX_MEM; ++addr) {
+        const auto address = static_cast<Word>(addr);
+        const Byte want = expected.memory->ReadByte(address);
+        const Byte got = actual.memory->ReadByte(address);
+        if (want != got) {
+            std::snprintf(line, sizeof(line), "memory[$%04X]: reference $%02X, engine $%02X", addr, want, got);
+            return line;
+        }
+    }
+    return "";
+}
+
+// Empty when every lane matches the reference.
+std::string Divergence(const Case &c) {
+    const std::vector<State> states = RunEngine(c);
+    for (unsigned lane = 0; lane < states.size(); ++lane) {
+        std::string difference = Compare(RunReference(c, lane), states[lane]);
+        if (!difference.empty())
+            return states.size() > 1 ? "lane " + std::to_string(lane) + ": " + difference : difference;
+    }
+    return "";
+}
+
+// Greedy shrinking that keeps the case diverging: the smallest budget, then no patches, then NOPs for instructions,
+// then no trailing NOPs. Every step edits the case in place and undoes the edit when the divergence goes away.
+Case Minimize(Case c) {
+    const u32 budget = c.budget;
+    u32 low = 1;
+    u32 high = budget;
+    while (low < high) {
+        c.budget = low + (high - low) / 2;
+        if (!Divergence(c).empty())
+            high = c.budget;
+        else
+            low = c.budget + 1;
+    }
+    c.budget = high;
+    if (Divergence(c).empty())
+        c.budget = budget;
+    for (std::size_t i = c.patches.size(); i-- > 0;) {
+        const auto at = c.patches.begin() + static_cast<std::ptrdiff_t>(i);
+        const Patch patch = *at;
+        c.patches.erase(at);
+        if (Divergence(c).empty())
+            c.patches.insert(c.patches.begin() + static_cast<std::ptrdiff_t>(i), patch);
+    }
+    for (std::size_t at = 0; at < c.program.size(); at += OPCODES[c.program[at]].length) {
+        if (c.program[at] == 0xEA)
+            continue;
+        const Byte length = OPCODES[c.program[at]].length;
+        Byte original[3]{};
+        for (Byte i = 0; i < length; ++i) {
+            original[i] = c.program[at + i];
+            c.program[at + i] = 0xEA;
+        }
+        if (Divergence(c).empty())
+            for (Byte i = 0; i < length; ++i)
+                c.program[at + i] = original[i];
+    }
+    while (!c.program.empty() && c.program.back() == 0xEA) {
+        c.program.pop_back();
+        if (Divergence(c).empty()) {
+            c.program.push_back(0xEA);
+            break;
+        }
+    }
+    return c;
+}
+
+[[noreturn]] void Report(const Case &c, const std::string &difference) {
+    std::fprintf(stderr, "\n==== %s diverges from CPU::Execute: %s\n", EngineName(c.engine), difference.c_str());
+    std::fprintf(stderr, "budget %u, A $%02X X $%02X Y $%02X, %s%s%s%u lane(s)\n", c.budget, c.a, c.x, c.y,
+                 c.flags & CLEAR_I ? "I clear, " : "", Interrupts(c) && (c.flags & IRQ) ? "IRQ, " : "",
+                 Interrupts(c) && (c.flags & NMI) ? "NMI, " : "", Lanes(c));
+    const auto memory = BuildMemory(c);
+    std::string text;
+    for (std::size_t at = 0; at < c.program.size();) {
+        const auto pc = static_cast<Word>(PROGRAM + at);
+        at += Disassemble(*memory, pc, text);
+        std::fprintf(stderr, "  $%04X  %s\n", pc, text.c_str());
+    }
+    for (const Patch &patch : c.patches)
+        std::fprintf(stderr, "  [$%04X] = $%02X\n", patch.address, patch.value);
+    std::abort();
+}
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, const std::size_t size) {
+    std::optional<Case> c = Decode(data, size);
+    if (!c)
+        return 0;
+    if (Divergence(*c).empty())
+        return 0;
+    const Case minimal = Minimize(std::move(*c));
+    Report(minimal, Divergence(minimal));
+}
@@ -0,0 +1,110 @@
+// Drives LLVMFuzzerTestOneInput where libFuzzer is not available. With file arguments it replays each file once, so
+// it also serves AFL-style "cpu6502_fuzz @@" runs; otherwise it feeds random inputs, optionally from several forked
+// worker processes. An input that crashes the target is written to crash-<pid>-<run> in the working directory.
+//
+// Options (libFuzzer spelling): -runs=N (0 runs forever), -seed=N, -max_len=N, -jobs=N.
+
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data, std::size_t size);
+
+namespace {
+// The input being run, kept where the abort handler can write it out.
+std::vector<std::uint8_t> current;
+char crash_path[64];
+
+extern "C" void SaveCrash(int signal) {
+    const int fd = open(crash_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        [[maybe_unused]] const ssize_t written = write(fd, current.data(), current.size());
+        close(fd);
+    }
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+bool Option(const char *arg, const char *name, unsigned long long &value) {
+    const std::size_t length = std::strlen(name);
+    if (std::strncmp(arg, name, length) != 0)
+        return false;
+    value = std::strtoull(arg + length, nullptr, 10);
+    return true;
+}
+
+int Fuzz(const unsigned long long runs, const unsigned long long seed, const std::size_t max_len) {
+    std::mt19937_64 random(seed);
+    current.reserve(max_len);
+    for (unsigned long long run = 0; runs == 0 || run < runs; ++run) {
+        current.resize(8 + random() % (max_len - 7));
+        for (std::uint8_t &byte : current)
+            byte = static_cast<std::uint8_t>(random());
+        std::snprintf(crash_path, sizeof(crash_path), "crash-%d-%llu", static_cast<int>(getpid()), run);
+        LLVMFuzzerTestOneInput(current.data(), current.size());
+        if ((run + 1) % 100000 == 0)
+            std::fprintf(stderr, "[%d] %llu runs\n", static_cast<int>(getpid()), run + 1);
+    }
+    return 0;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    unsigned long long runs = 0, seed = 1, max_len = 512, jobs = 1;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        if (!Option(argv[i], "-runs=", runs) && !Option(argv[i], "-seed=", seed) &&
+            !Option(argv[i], "-max_len=", max_len) && !Option(argv[i], "-jobs=", jobs))
+            files.emplace_back(argv[i]);
+    }
+    std::signal(SIGABRT, SaveCrash);
+    std::signal(SIGSEGV, SaveCrash);
+
+    if (!files.empty()) {
+        for (const std::string &file : files) {
+            std::ifstream in(file, std::ios::binary);
+            if (!in) {
+                std::fprintf(stderr, "cannot read %s\n", file.c_str());
+                return 1;
+            }
+            current.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            std::snprintf(crash_path, sizeof(crash_path), "crash-%d-replay", static_cast<int>(getpid()));
+            LLVMFuzzerTestOneInput(current.data(), current.size());
+        }
+        return 0;
+    }
+    if (max_len < 8)
+        max_len = 8;
+    if (jobs <= 1)
+        return Fuzz(runs, seed, max_len);
+
+    // Each worker is its own process with its own seed, so a crash only takes down that worker.
+    std::vector<pid_t> workers;
+    for (unsigned long long job = 0; job < jobs; ++job) {
+        const pid_t pid = fork();
+        if (pid == 0)
+            return Fuzz(runs, seed + job, max_len);
+        if (pid > 0)
+            workers.push_back(pid);
+    }
+    int failed = 0;
+    for (const pid_t pid : workers) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::fprintf(stderr, "worker %d failed\n", static_cast<int>(pid));
+            failed = 1;
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,89 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "cpu.hpp"
+
+#include <cstddef>
+#include <vector>
+
+struct MemoryPatch {
+    Word address;
+    Byte value;
+};
+
+struct RegisterSeed {
+    Byte A;
+    Byte X;
+    Byte Y;
+    Byte P = 0x24;
+};
+
+struct BatchResult {
+    Word PC;
+    Word SP;
+    Byte A;
+    Byte X;
+    Byte Y;
+    Byte P;
+    u32 cycles;
+};
+
+struct BatchStats {
+    u32 jobs;
+    unsigned threads;
+    double seconds;
+
+    [[nodiscard]] double JobsPerSecond() const;
+};
+
+// Runs one memory image against many independent jobs on a pool of worker threads. Every job starts from a fork
+// of the image with its own patches applied, is reset through the reset vector, seeded with A/X/Y/P and run for
+// a fixed cycle budget. The image must be backed by internal RAM only: host pages and devices would be shared by
+// every worker, so Run rejects them. Jobs are split evenly across workers and idle workers steal half of the largest remaining
+// range. Each worker owns one Memory and one CPU for the whole run, and results and captured memory ranges are
+// written into buffers sized once per run.
+class BatchRunner {
+    struct Job {
+        u32 first_patch;
+        u32 patch_count;
+        RegisterSeed seed;
+    };
+
+    struct Capture {
+        Word address;
+        Word length;
+    };
+
+    const Memory &image;
+    std::vector<Job> jobs;
+    std::vector<MemoryPatch> patches;
+    std::vector<Capture> captures;
+    std::size_t capture_bytes = 0;
+    std::vector<BatchResult> results;
+    std::vector<Byte> captured;
+    BatchStats stats{};
+
+    void RunJob(u32 index, const Memory &base, Memory &memory, CPU &cpu, u32 exec_cycles);
+
+public:
+    // The image must outlive the runner; it is only read.
+    explicit BatchRunner(const Memory &source);
+
+    u32 AddJob(const std::vector<MemoryPatch> &job_patches, RegisterSeed seed = {});
+    // Copies length bytes starting at address out of every job's memory after it finishes.
+    void AddCapture(Word address, Word length);
+    void Reserve(std::size_t job_count, std::size_t patch_count);
+
+    // Runs every job for exec_cycles; threads == 0 uses all hardware threads. Throws std::invalid_argument when
+    // the image maps host memory or a device.
+    void Run(u32 exec_cycles, unsigned threads = 0);
+
+    [[nodiscard]] std::size_t JobCount() const;
+    [[nodiscard]] const BatchResult &Result(u32 job) const;
+    // Captured ranges of a job, concatenated in the order they were added.
+    [[nodiscard]] const Byte *Captured(u32 job) const;
+    [[nodiscard]] std::size_t CaptureBytes() const;
+    [[nodiscard]] const BatchStats &Stats() const;
+};
+
+#endif // BATCH_HPP
@@ -0,0 +1,38 @@
+#ifndef BLOCK_CACHE_HPP
+#define BLOCK_CACHE_HPP
+
+#include "cpu.hpp"
+
+#include <vector>
+
+// Executes a CPU from pre-decoded straight-line blocks. A block is decoded once per start PC and is dropped
+// as soon as any page it was decoded from is written, so self-modifying code keeps interpreter semantics.
+class BlockCache final : public CodeWriteListener {
+    struct Block {
+        u32 first;
+        u32 count;
+    };
+
+    CPU &cpu;
+    std::vector<DecodedOp> ops;
+    std::vector<Block> blocks;
+    std::vector<u32> entries;
+    bool invalidated = false;
+
+    u32 Decode(Word pc);
+
+public:
+    static constexpr std::size_t MAX_DECODED_OPS = 1 << 20;
+
+    // Throws std::logic_error when the memory already has a code write listener, such as a Jit.
+    explicit BlockCache(CPU &processor);
+    ~BlockCache() override;
+    BlockCache(const BlockCache &) = delete;
+    BlockCache &operator=(const BlockCache &) = delete;
+
+    void Execute(u32 exec_cycles);
+    void Flush();
+    void OnCodeWrite(Byte page) override;
+};
+
+#endif // BLOCK_CACHE_HPP
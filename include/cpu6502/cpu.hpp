@@ -14,30 +14,172 @@ typedef struct {
     Byte N : 1;
 } StatusFlags;
 
-class CPU {
+// One pre-decoded instruction: PC advance and fetch cycles are applied before the opcode runs.
+struct DecodedOp {
+    Word operand;
+    Byte opcode;
+    Byte size;
+    Byte cycles;
+};
+
+// Registers, packed status and cycle count of a CPU just before an instruction runs, with the instruction's operand.
+struct InstructionRecord {
+    Word pc;
+    Word operand;
+    Byte opcode;
+    // Opcode plus operand bytes.
+    Byte length;
+    Byte a;
+    Byte x;
+    Byte y;
+    Byte sp;
+    Byte p;
+    u32 cycles;
+};
+
+// Receives every instruction executed by a CPU whose policy enables tracing.
+class InstructionObserver {
+public:
+    virtual ~InstructionObserver() = default;
+    virtual void OnInstruction(const InstructionRecord &record) = 0;
+};
+
+class Debugger;
+struct DebugRegisters;
+class Profiler;
+
+enum class UnknownOpcodeMode {
+    // Abort in debug builds, skip in release builds.
+    AbortInDebug,
+    Abort,
+    // Treat the opcode as a one-byte no-op.
+    Skip,
+};
+
+// Compile-time configuration of BasicCPU. Members are read with if constexpr, so disabled features cost nothing.
+struct CycleAccuratePolicy {
+    // When false, cycles counts executed instructions and Execute takes an instruction budget.
+    static constexpr bool COUNT_CYCLES = true;
+    // When true, every instruction is reported to the observer set with SetObserver.
+    static constexpr bool TRACE = false;
+    // When true, executions, cycles and page-crossing penalties are counted in the profiler set with SetProfiler.
+    static constexpr bool PROFILE = false;
+    static constexpr UnknownOpcodeMode UNKNOWN_OPCODES = UnknownOpcodeMode::AbortInDebug;
+};
+
+struct FunctionalPolicy {
+    static constexpr bool COUNT_CYCLES = false;
+    static constexpr bool TRACE = false;
+    static constexpr bool PROFILE = false;
+    static constexpr UnknownOpcodeMode UNKNOWN_OPCODES = UnknownOpcodeMode::Skip;
+};
+
+struct TracingPolicy : CycleAccuratePolicy {
+    static constexpr bool TRACE = true;
+};
+
+struct ProfilingPolicy : CycleAccuratePolicy {
+    static constexpr bool PROFILE = true;
+};
+
+// Semantics of one opcode, shared by every policy; defined in cpu.cpp.
+template <Byte Code> struct Instruction;
+
+// 6502 core parameterized by a policy. Member functions are defined in cpu.cpp and instantiated there for the
+// policies above.
+template <typename Policy> class BasicCPU {
+    // Z and N are evaluated lazily: instructions only record the result that sets them, and their bits in PS are
+    // unused. Z is set while z_result is zero and N is bit 7 of n_result.
     StatusFlags PS{};
+    Byte z_result = 1;
+    Byte n_result = 0;
     Memory &mem;
+    InstructionObserver *observer = nullptr;
+    Profiler *profiler = nullptr;
+    Debugger *debugger = nullptr;
+    // Interrupt inputs: irq_line is the level of IRQ, nmi_pending latches an NMI edge until it is taken.
+    bool irq_line = false;
+    bool nmi_pending = false;
+    bool stop_requested = false;
+    // Set by CLI with IRQ held: the IRQ waits until one more instruction has run, which ends at a new cycle count.
+    bool irq_delayed = false;
+    u32 cli_cycles = 0;
+    // Raised by the debugger for a watched access, whose conditions are checked at the next boundary.
+    bool debug_stop = false;
+    // Cycles the running dispatch loop may still spend. Raising pending work zeroes it, so the loop's one budget
+    // check also stops it at the next instruction boundary for interrupts and stop requests.
+    u32 budget = 0;
+
+    // Whether instructions may need to be reported to an observer or profiler.
+    static constexpr bool OBSERVED = Policy::TRACE || Policy::PROFILE;
 
+    void SetNZ(Byte result);
+    void Tick(u32 count);
+    void PageCrossed();
+    void UnknownOpcode();
+    [[nodiscard]] bool IrqDelayed() const { return irq_delayed && cycles == cli_cycles; }
+    // Interrupts, breakpoints and stop requests that must be handled before the next instruction.
+    [[nodiscard]] bool WorkPending() const;
+    void RaisePending();
+    // Enters a pending interrupt. Returns false, clearing the request, when a stop was requested instead.
+    bool ServicePending();
+    // Clears a raised watched access; true when the debugger confirms it as a stop.
+    bool ConfirmWatch();
+    void Interrupt(Word vector, Byte break_flag);
+    [[nodiscard]] DebugRegisters Registers() const;
+    // Checked before every instruction of a debugged run; true when a breakpoint stops it.
+    bool AtBreakpoint();
+    void Trace(Byte opcode, Word operand);
+
+    Byte FetchOpcode();
     Byte FetchByte();
     Word FetchWord();
 
     void LDA(Byte operand);
     void LDX(Byte operand);
     void LDY(Byte operand);
+    void BRK();
+    void RTI();
+    void CLI();
+    void SEI();
+
+    void PushByteAndTick(Byte value);
+    Byte PullByteAndTick();
 
-    Word AddrZeroPage();
-    Word AddrAbsolute();
     Byte ReadByteAndTick(Word addr);
     void WriteByteAndTick(Word addr, Byte value);
-    Word AddrZeroPageX();
-    Word AddrZeroPageY();
-    Word AddrAbsoluteX();
-    Word AddrAbsoluteXStore();
-    Word AddrIndexedIndirectX();
-    Word AddrAbsoluteY();
-    Word AddrAbsoluteYStore();
-    Word AddrIndirectIndexedY();
-    Word AddrIndirectIndexedYStore();
+    Word AddrZeroPageX(Byte base);
+    Word AddrZeroPageY(Byte base);
+    Word AddrAbsoluteX(Word base);
+    Word AddrAbsoluteXStore(Word base);
+    Word AddrIndexedIndirectX(Byte base);
+    Word AddrAbsoluteY(Word base);
+    Word AddrAbsoluteYStore(Word base);
+    Word AddrIndirectIndexedY(Byte zp);
+    Word AddrIndirectIndexedYStore(Byte zp);
+
+    // Executes an opcode whose operand bytes have already been fetched; Traced reports it to the observer and the
+    // profiler and makes Dispatch check breakpoints.
+    template <Byte Opcode, bool Traced> void Op(Word operand);
+    // Fetches the operand bytes of an opcode, then executes it.
+    template <Byte Opcode, bool Traced> void Step();
+    // Runs instructions until budget is spent.
+    template <bool Traced> void Dispatch();
+
+    static const Byte OperandSizes[256];
+
+    // Runs decoded instructions in order until the list ends, the cycle target is reached or stop is raised.
+    void ExecuteDecoded(const DecodedOp *op, const DecodedOp *end, u32 target_cycles, const bool &stop);
+
+    template <typename> friend class BasicCPU;
+    template <Byte> friend struct Instruction;
+    friend class BlockCache;
+    friend class GdbStub;
+    friend class Jit;
+    friend class Lockstep;
+    friend class Rewind;
+    friend class SaveState;
+    friend class SteppedCPU;
 
 public:
     Word PC;
@@ -47,10 +189,52 @@ public:
     Byte Y;
     u32 cycles;
 
-    explicit CPU(Memory &memory);
+    explicit BasicCPU(Memory &memory);
+    // Creates a CPU on memory with the registers, flags and cycle count of state, which may use another policy.
+    template <typename Other>
+    BasicCPU(Memory &memory, const BasicCPU<Other> &state)
+        : PS(state.PS), z_result(state.z_result), n_result(state.n_result), mem(memory), irq_line(state.irq_line),
+          nmi_pending(state.nmi_pending), PC(state.PC), SP(state.SP), A(state.A), X(state.X), Y(state.Y),
+          cycles(state.cycles) {}
+
+    // Packed status register, N V U B D I Z C from bit 7 down, with the lazily kept flags evaluated.
+    [[nodiscard]] Byte StatusRegister() const;
+    void SetStatusRegister(Byte P);
+
+    // Only used when the policy enables tracing.
+    void SetObserver(InstructionObserver *Observer);
+    // Only used when the policy enables profiling.
+    void SetProfiler(Profiler *Counters);
+    // Stops Execute at the debugger's breakpoints and watchpoints; nullptr detaches it. The debugger must stay
+    // attached to one CPU at a time.
+    void SetDebugger(Debugger *Breakpoints);
+
+    // Interrupt inputs for devices, called from the thread running the CPU. IRQ is level-triggered and masked by
+    // the I flag; an NMI is taken once per call.
+    void SetIRQ(bool asserted);
+    void TriggerNMI();
+    // Makes Execute return at the next instruction boundary, for breakpoints and scheduled events.
+    void RequestStop();
 
     void Reset();
     void Execute(u32 exec_cycles);
 };
 
+// True for opcodes the interpreter executes; the others are handled according to the policy's UnknownOpcodeMode.
+bool IsImplemented(Byte opcode);
+
+extern template class BasicCPU<CycleAccuratePolicy>;
+extern template class BasicCPU<FunctionalPolicy>;
+extern template class BasicCPU<TracingPolicy>;
+extern template class BasicCPU<ProfilingPolicy>;
+
+// The cycle-accurate core used by the rest of the library.
+using CPU = BasicCPU<CycleAccuratePolicy>;
+// Fastest core: no cycle accounting, tracing or unknown-opcode checks.
+using FunctionalCPU = BasicCPU<FunctionalPolicy>;
+// Cycle-accurate core that reports every instruction to its observer.
+using TracingCPU = BasicCPU<TracingPolicy>;
+// Cycle-accurate core that attributes every instruction to its profiler.
+using ProfilingCPU = BasicCPU<ProfilingPolicy>;
+
 #endif // CPU_HPP
@@ -0,0 +1,162 @@
+#ifndef DEBUGGER_HPP
+#define DEBUGGER_HPP
+
+#include "mem.hpp"
+
+#include <memory>
+#include <vector>
+
+enum class DebugOperand {
+    A,
+    X,
+    Y,
+    SP,
+    P,
+    PC,
+    // The byte at Condition::address, read through the bus.
+    Memory,
+    // The byte a watchpoint saw, or the opcode at a breakpoint.
+    Value,
+};
+
+enum class DebugCompare {
+    Equal,
+    NotEqual,
+    Less,
+    GreaterEqual,
+    // Any bit of the constant set in the operand.
+    AnySet,
+    NoneSet,
+};
+
+// Predicate on a register or a byte, evaluated by the core when a breakpoint or watchpoint matches.
+struct Condition {
+    DebugOperand operand = DebugOperand::A;
+    DebugCompare compare = DebugCompare::Equal;
+    Word constant = 0;
+    Word address = 0;
+};
+
+// Registers and cycle count of the CPU where a condition is evaluated.
+struct DebugRegisters {
+    Word pc;
+    Byte a;
+    Byte x;
+    Byte y;
+    Byte sp;
+    Byte p;
+    u32 cycles;
+};
+
+enum class StopKind {
+    None,
+    Breakpoint,
+    Watchpoint,
+};
+
+// Why the last Execute stopped. For a watchpoint, address, value and write describe the access that matched and pc
+// and cycles are taken after the instruction that made it; for a breakpoint they are taken before it runs.
+struct StopReason {
+    StopKind kind = StopKind::None;
+    u32 id = 0;
+    Word address = 0;
+    Byte value = 0;
+    bool write = false;
+    Word pc = 0;
+    u32 cycles = 0;
+};
+
+// Execution breakpoints and memory watchpoints for a CPU attached with SetDebugger. Every kind keeps a flag per page
+// and a byte bitmap only for flagged pages: a breakpoint check is one page flag test per instruction, and watched
+// pages lose their direct pointer in Memory so that only their accesses reach the bitmap. A CPU without a debugger
+// runs its plain dispatch loop.
+//
+// A point stops when all of its conditions hold, so one without conditions always stops. Conditions are data
+// evaluated in the core, so a matching access whose condition fails costs a few compares and never returns to the
+// host.
+//
+// CPU::Execute stops before an instruction at a breakpoint and after an instruction that touched a watched byte;
+// resuming at the breakpoint that stopped runs it. BlockCache and Jit stop for watchpoints at their next instruction
+// or block boundary and do not check breakpoints. They decode ahead without reporting, so they see data accesses
+// only, not instruction fetches. Accesses made by the host between Execute calls are ignored.
+class Debugger final : public WatchListener {
+    struct Point {
+        u32 id;
+        Word first;
+        Word last;
+        bool executes;
+        bool reads;
+        bool writes;
+        std::vector<Condition> conditions;
+    };
+
+    struct Hit {
+        Word address;
+        Byte value;
+        bool write;
+    };
+
+    // Page flags plus one 256-bit map for each flagged page.
+    struct Bitmap {
+        bool pages[PAGE_COUNT]{};
+        std::unique_ptr<u64[]> bits[PAGE_COUNT];
+
+        [[nodiscard]] bool Test(const Word address) const {
+            return pages[address >> 8] && ((bits[address >> 8][(address & 0xFF) >> 6] >> (address & 63)) & 1);
+        }
+        void Set(Word address);
+        void Clear();
+    };
+
+    Memory &mem;
+    std::vector<Point> points;
+    u32 next_id = 1;
+    Bitmap breakpoints;
+    Bitmap read_watches;
+    Bitmap write_watches;
+    // Watched accesses made by the running instruction, checked at its end.
+    std::vector<Hit> hits;
+    StopReason stop;
+    // Set while conditions read memory, whose accesses are not watched.
+    bool evaluating = false;
+    void *cpu = nullptr;
+    void (*request_stop)(void *cpu) = nullptr;
+    // The breakpoint Execute resumes at, which runs once instead of stopping again.
+    bool resuming = false;
+    Word resume_pc = 0;
+    u32 resume_cycles = 0;
+
+    void Rebuild();
+    [[nodiscard]] bool Holds(const Point &point, const DebugRegisters &registers, Byte value);
+    void OnWatchedAccess(Word Address, Byte Value, bool Write) override;
+
+    // Used by the CPU the debugger is attached to.
+    void Attach(void *target, void (*stop_target)(void *));
+    void Resume(Word pc, u32 cycles);
+    [[nodiscard]] bool IsBreakpoint(const Word pc) const { return breakpoints.Test(pc); }
+    [[nodiscard]] bool StopAtBreakpoint(const DebugRegisters &registers);
+    // Checks the watched accesses of the instruction that just ran; true when one of them stops.
+    [[nodiscard]] bool ConfirmStop(const DebugRegisters &registers);
+
+    template <typename> friend class BasicCPU;
+
+public:
+    // Installs itself as memory's watch listener; throws std::logic_error when the memory already has one, such as
+    // another Debugger.
+    explicit Debugger(Memory &memory);
+    Debugger(const Debugger &) = delete;
+    Debugger &operator=(const Debugger &) = delete;
+    ~Debugger() override;
+
+    // Each returns an id for Remove.
+    u32 AddBreakpoint(Word address, std::vector<Condition> conditions = {});
+    // Stops on reads and/or writes of any byte in first..last. Reads include opcode and operand fetches.
+    u32 AddWatchpoint(Word first, Word last, bool reads, bool writes, std::vector<Condition> conditions = {});
+    void Remove(u32 id);
+    void Clear();
+
+    // Reset by every Execute; kind is None when the last one ran out of cycles or stopped for another reason.
+    [[nodiscard]] const StopReason &LastStop() const { return stop; }
+};
+
+#endif // DEBUGGER_HPP
@@ -0,0 +1,62 @@
+#ifndef GDB_STUB_HPP
+#define GDB_STUB_HPP
+
+#include "cpu.hpp"
+#include "debugger.hpp"
+
+#include <map>
+#include <string>
+#include <tuple>
+
+// GDB remote serial protocol server for one CPU, over a connected stream socket; built on POSIX hosts only.
+//
+// Registers are a, x, y, p, sp (one byte each) and pc (two bytes, little endian), described to the client as
+// target.xml. Memory transfers ('m', 'M', 'X') move up to PacketSize bytes per packet. Breakpoints ('Z0', 'Z1')
+// and watchpoints ('Z2' write, 'Z3' read, 'Z4' access) are set in the stub's Debugger. Continue runs Execute in
+// large slices at full speed and checks the socket for an interrupt (Ctrl-C) between them.
+class GdbStub {
+    CPU &cpu;
+    Memory &mem;
+    Debugger debugger;
+    int fd = -1;
+    // Bytes received but not yet consumed.
+    std::string input;
+    bool acks = true;
+    bool closed = false;
+    std::string last_stop = "S05";
+    // Debugger ids by packet type, address and kind, and the watch type of every watchpoint id.
+    std::map<std::tuple<char, Word, Word>, u32> points;
+    std::map<u32, char> watch_types;
+
+    bool Fill(bool wait);
+    bool ReadPacket(std::string &packet);
+    void WritePacket(const std::string &payload);
+    // Answers one packet; false once the session is over.
+    bool Handle(const std::string &packet);
+    std::string Resume(bool step);
+    bool Interrupted();
+    [[nodiscard]] std::string ReadRegisters() const;
+    void WriteRegister(u32 index, const Byte *bytes);
+    std::string SetPoint(const std::string &packet, bool insert);
+
+public:
+    // Largest packet the client may send; an 'm' reply carries up to half as many bytes of memory.
+    static constexpr u32 PACKET_SIZE = 0x4000;
+    // Cycles run between checks for an interrupt while continuing.
+    static constexpr u32 SLICE = 1 << 20;
+
+    // The stub's Debugger watches the CPU's memory, so this throws std::logic_error when another Debugger already
+    // does.
+    explicit GdbStub(CPU &processor);
+
+    // Serves one session on Socket, which it closes, until the client detaches, kills or disconnects.
+    void Serve(int Socket);
+
+    // Listens on a Unix socket when Endpoint holds a '/', else on "[host:]port" over TCP (host defaults to
+    // 127.0.0.1). Returns the listening socket; throws std::runtime_error.
+    static int Listen(const std::string &Endpoint);
+    // Waits for one client on a listening socket and returns its connection; throws std::runtime_error.
+    static int Accept(int Listener);
+};
+
+#endif // GDB_STUB_HPP
@@ -0,0 +1,92 @@
+#ifndef JIT_HPP
+#define JIT_HPP
+
+#include "cpu.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Optional x86-64 backend that translates hot straight-line blocks into native code. Blocks are interpreted
+// until their entry count reaches the hot threshold. Opcodes the translator does not know, and pages that keep
+// being rewritten, stay on the interpreter. A, X, Y, PC, cycles and the status register match the interpreter at every
+// block exit, and a native block never runs past the cycle budget of Execute.
+class Jit final : public CodeWriteListener {
+public:
+    // Register file shared with generated code; generated code addresses it through a base register.
+    struct State {
+        Jit *jit;
+        const Byte *const *pages;
+        Byte *const *write_pages;
+        u32 cycles;
+        // Cycles the block may run; compared with the cycles it has run, so the counter may wrap in a block.
+        u32 budget;
+        Word pc;
+        Byte a;
+        Byte x;
+        Byte y;
+        Byte z_result;
+        Byte n_result;
+        // Set by a store that invalidated code or raised pending work, such as an IRQ or a stop; the block exits
+        // after it.
+        Byte stop;
+    };
+
+    using BlockFn = void (*)(State *);
+
+    static constexpr u32 DEFAULT_HOT_THRESHOLD = 16;
+    static constexpr std::size_t DEFAULT_ARENA_BYTES = 1 << 20;
+    // Invalidations after which a page is treated as self-modifying and left to the interpreter.
+    static constexpr Byte SMC_PAGE_LIMIT = 8;
+
+    // Throws std::logic_error when the memory already has a code write listener, such as a BlockCache.
+    explicit Jit(CPU &processor, u32 threshold = DEFAULT_HOT_THRESHOLD,
+                 std::size_t arena_size = DEFAULT_ARENA_BYTES);
+    ~Jit() override;
+    Jit(const Jit &) = delete;
+    Jit &operator=(const Jit &) = delete;
+
+    // True when native code generation is compiled in and the executable arena could be mapped.
+    [[nodiscard]] bool Available() const;
+
+    void Execute(u32 exec_cycles);
+    void Flush();
+    void OnCodeWrite(Byte page) override;
+
+    // Runs a shadow interpreter on a private copy of memory and compares it after every native block. The copy
+    // is refreshed from the CPU and its memory at the start of every Execute call.
+    void EnableDifferential();
+    [[nodiscard]] bool Diverged() const;
+    [[nodiscard]] const std::string &DivergenceReport() const;
+
+    [[nodiscard]] u32 CompiledBlocks() const;
+    [[nodiscard]] u32 NativeBlockRuns() const;
+
+private:
+    struct Differential;
+
+    CPU &cpu;
+    u32 hot_threshold;
+    Byte *arena = nullptr;
+    std::size_t arena_bytes;
+    std::size_t arena_used = 0;
+    std::vector<BlockFn> blocks;
+    std::vector<u32> hits;
+    Byte page_invalidations[PAGE_COUNT]{};
+    State state{};
+    u32 compiled_blocks = 0;
+    u32 native_runs = 0;
+    std::unique_ptr<Differential> differential;
+
+    [[nodiscard]] bool Compilable(Word pc) const;
+    BlockFn Compile(Word pc);
+    void RunNative(BlockFn block, u32 budget);
+    void SyncDifferential();
+    void CheckDifferential();
+
+    static Byte ReadThunk(State *state, u32 addr);
+    static void WriteThunk(State *state, u32 addr, u32 value);
+};
+
+#endif // JIT_HPP
@@ -0,0 +1,47 @@
+#ifndef LOADER_HPP
+#define LOADER_HPP
+
+#include "mem.hpp"
+
+#include <cstddef>
+#include <string>
+
+enum class ImageFormat {
+    // Bytes loaded as-is at LoadOptions::base.
+    Raw,
+    // C64 program file: a little-endian load address followed by the bytes.
+    Prg,
+    // Intel HEX text with data, EOF, extended address and start address records.
+    IntelHex,
+};
+
+struct LoadOptions {
+    // Load address of raw images; ignored by formats that carry their own addresses.
+    Word base = 0;
+    // Points the reset vector at the image entry once it is loaded.
+    bool set_reset_vector = false;
+};
+
+struct ImageInfo {
+    // Lowest and highest address written, and the number of bytes written.
+    Word first;
+    Word last;
+    u32 bytes;
+    // Start address record of an Intel HEX image, the first loaded address otherwise.
+    Word entry;
+};
+
+// Loads program images into a Memory through Memory::WriteBlock, so every contiguous run costs one copy per page.
+// Malformed images throw std::runtime_error and images that run past $FFFF throw std::out_of_range; in both cases
+// nothing is written.
+class ImageLoader {
+public:
+    static ImageInfo Load(Memory &memory, const Byte *Data, std::size_t Size, ImageFormat Format,
+                          const LoadOptions &Options = {});
+    static ImageInfo LoadFile(Memory &memory, const std::string &Path, ImageFormat Format,
+                              const LoadOptions &Options = {});
+    // Guesses the format from the extension: .prg, .hex/.ihx, anything else is raw.
+    [[nodiscard]] static ImageFormat FormatForPath(const std::string &Path);
+};
+
+#endif // LOADER_HPP
@@ -0,0 +1,59 @@
+#ifndef LOCKSTEP_HPP
+#define LOCKSTEP_HPP
+
+#include "cpu.hpp"
+
+#include <memory>
+#include <vector>
+
+// Runs up to MAX_LANES independent machines that execute the same program on different data. Registers are kept
+// in structure-of-arrays form and memory is interleaved by lane, so an access that hits the same address in every
+// lane is a single vector load or store. Lanes whose PC or instruction bytes differ are masked out and run as a
+// separate group. When the vector kernels do not cover an opcode, each lane that reaches it is handed to
+// CPU::Execute for the rest of the call. Every lane ends exactly where running it alone through CPU::Execute would.
+class Lockstep {
+public:
+    static constexpr unsigned MAX_LANES = 32;
+
+    explicit Lockstep(unsigned lanes);
+
+    [[nodiscard]] unsigned Lanes() const;
+    // Copies a machine into a lane / a lane back out into a machine.
+    void Load(unsigned lane, const CPU &cpu, const Memory &source);
+    void Store(unsigned lane, CPU &cpu, Memory &destination) const;
+    [[nodiscard]] Byte ReadByte(unsigned lane, Word address) const;
+
+    // Runs every lane for exec_cycles, with CPU::Execute semantics per lane.
+    void Execute(u32 exec_cycles);
+
+    // Lanes handed to the scalar CPU so far.
+    [[nodiscard]] u32 ScalarFallbacks() const;
+    // Vector instruction set the kernels were compiled for: "avx2", "sse2" or "scalar".
+    static const char *Isa();
+
+private:
+    unsigned lane_count;
+    // Byte of lane l at address a lives at memory[a * MAX_LANES + l].
+    std::vector<Byte> memory;
+    alignas(32) Byte a[MAX_LANES]{};
+    alignas(32) Byte x[MAX_LANES]{};
+    alignas(32) Byte y[MAX_LANES]{};
+    alignas(32) Byte p[MAX_LANES]{};
+    Word pc[MAX_LANES]{};
+    Word sp[MAX_LANES]{};
+    u32 cycles[MAX_LANES]{};
+    // Cycle count of every lane when Execute started, and its budget; lanes compare the cycles run so far, so the
+    // counters may wrap.
+    u32 start[MAX_LANES]{};
+    u32 budget = 0;
+    u32 fallbacks = 0;
+    std::unique_ptr<Memory> scratch;
+
+    u32 RunGroup(u32 group, unsigned leader);
+    void Flush(u32 group, Word at, u32 spent);
+    u32 Slack(u32 group) const;
+    [[nodiscard]] u32 Elapsed(unsigned lane) const { return cycles[lane] - start[lane]; }
+    void RunScalar(unsigned lane);
+};
+
+#endif // LOCKSTEP_HPP
@@ -0,0 +1,20 @@
+#ifndef MACHINE_HPP
+#define MACHINE_HPP
+
+#include "cpu.hpp"
+
+// A CPU together with the memory it runs on. Copying forks both: registers are copied and memory pages are shared
+// until either machine writes them.
+class Machine {
+public:
+    Memory memory;
+    CPU cpu;
+
+    Machine();
+    Machine(const Machine &Other);
+    Machine &operator=(const Machine &) = delete;
+
+    [[nodiscard]] Machine Fork() const;
+};
+
+#endif // MACHINE_HPP
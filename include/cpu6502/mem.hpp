@@ -1,23 +1,153 @@
 #ifndef MEM_HPP
 #define MEM_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 
 using Byte = std::uint8_t;
 using Word = std::uint16_t;
 using u32 = std::uint32_t;
+using u64 = std::uint64_t;
 
 static constexpr u32 MAX_MEM = 1024 * 64;
+static constexpr u32 PAGE_BYTES = 256;
+static constexpr u32 PAGE_COUNT = MAX_MEM / PAGE_BYTES;
 
+// Notified when a page marked with Memory::MarkCodePage is written.
+class CodeWriteListener {
+public:
+    virtual ~CodeWriteListener() = default;
+    virtual void OnCodeWrite(Byte page) = 0;
+};
+
+// Notified of reads and writes to pages flagged with Memory::WatchPage, after the access. Reads report the byte read
+// and writes the byte written, including writes to ROM that are ignored.
+class WatchListener {
+public:
+    virtual ~WatchListener() = default;
+    virtual void OnWatchedAccess(Word Address, Byte Value, bool Write) = 0;
+};
+
+// Memory-mapped device attached to one or more pages with Memory::MapDevice. Addresses are full bus addresses.
+class BusDevice {
+public:
+    virtual ~BusDevice() = default;
+    virtual Byte Read(Word Address) = 0;
+    virtual void Write(Word Address, Byte Value) = 0;
+};
+
+// 64 KiB bus made of 256 pages. Each page is backed by the internal RAM, by host RAM or ROM, or by a device.
+// ReadPages/WritePages hold a direct host pointer for every page a plain load or store can serve; a null entry
+// (device pages, writes to ROM, pages holding cached code, watched pages, internal pages shared with a fork) sends
+// the access down the slow path.
+//
+// Internal RAM pages are reference counted and copied on the first write after a fork, so copying a Memory costs
+// a page-table copy and each later write pays at most one page copy per page. A fresh Memory shares one zeroed page
+// for the whole address space.
 class Memory {
-    Byte Data[MAX_MEM]{};
+    struct RamPage;
+
+    RamPage *Ram[PAGE_COUNT]{};
+    const Byte *ReadPages[PAGE_COUNT]{};
+    // Mutable so that forking a const Memory can make the source copy its pages on the next write too.
+    mutable Byte *WritePages[PAGE_COUNT]{};
+    const Byte *HostRead[PAGE_COUNT]{};
+    Byte *HostWrite[PAGE_COUNT]{};
+    BusDevice *Devices[PAGE_COUNT]{};
+    bool CodePages[PAGE_COUNT]{};
+    CodeWriteListener *CodeListener = nullptr;
+    bool ReadWatched[PAGE_COUNT]{};
+    bool WriteWatched[PAGE_COUNT]{};
+    WatchListener *Watcher = nullptr;
+
+    static RamPage *ZeroPage();
+    static void Drop(RamPage *page);
+    void Share(const Memory &Other);
+    void RefreshPage(Byte Page);
+    [[nodiscard]] Byte ReadSlow(Word Address) const;
+    void WriteSlow(Word Address, Byte Value);
+    // Gives a shared internal page a private copy, optionally without copying its bytes.
+    void OwnPage(Byte Page, bool KeepContents);
+    void NotifyCodeWrite(Byte page);
+
+    [[nodiscard]] const Byte *InternalPage(Byte Page) const;
+    // Replaces the internal RAM behind a page with Bytes, owned by Backing, or with the zero page when Bytes is null.
+    void AdoptPage(Byte Page, Byte *Bytes, std::shared_ptr<void> Backing);
+
+    friend class Jit;
+    friend class Rewind;
+    friend class SaveState;
 
 public:
     Memory();
-    [[nodiscard]] Byte ReadByte(Word Address) const;
-    void WriteByte(Word Address, Byte Value);
+    // Copies are forks: internal pages are shared until either side writes them. Host pages and devices are
+    // shared outright. Code marks and watched pages are not copied; assignment notifies the target's listener for
+    // every page it had marked and keeps its watches. Forking the same Memory from several threads at once is safe
+    // once it has been forked at least once.
+    Memory(const Memory &Other);
+    Memory &operator=(const Memory &Other);
+    ~Memory();
+
+    [[nodiscard]] Memory Fork() const;
+
+    [[nodiscard]] Byte ReadByte(const Word Address) const {
+        if (const Byte *page = ReadPages[Address >> 8])
+            return page[Address & 0xFF];
+        return ReadSlow(Address);
+    }
+
+    void WriteByte(const Word Address, const Byte Value) {
+        if (Byte *page = WritePages[Address >> 8]) {
+            page[Address & 0xFF] = Value;
+            return;
+        }
+        WriteSlow(Address, Value);
+    }
+
+    // Reads like ReadByte without calling devices or reporting watched accesses, for decoders and checks that look at
+    // bytes the program has not fetched. Device pages read as zero.
+    [[nodiscard]] Byte PeekByte(const Word Address) const {
+        const Byte page = static_cast<Byte>(Address >> 8);
+        return Devices[page] ? Byte{0} : HostRead[page][Address & 0xFF];
+    }
+    [[nodiscard]] Word PeekWord(Word Address) const;
+
     [[nodiscard]] Word ReadWord(Word Address) const;
     void WriteWord(Word Address, Word Value);
+    // Copies Size bytes to Address with one page lookup and one memcpy per page; behaves like WriteByte for every
+    // byte. Device pages still receive one Write per byte. Throws std::out_of_range past the end of the bus.
+    void WriteBlock(Word Address, const Byte *Bytes, std::size_t Size);
+
+    // Backs a page with PAGE_BYTES of host memory that must outlive the mapping.
+    void MapRam(Byte Page, Byte *Host);
+    // Backs a page with read-only host memory; writes to it are ignored.
+    void MapRom(Byte Page, const Byte *Host);
+    // Routes every access to pages FirstPage..LastPage to the device.
+    void MapDevice(Byte FirstPage, Byte LastPage, BusDevice *Device);
+    // Restores the internal RAM behind a page.
+    void UnmapPage(Byte Page);
+    [[nodiscard]] bool IsDevicePage(Byte Page) const;
+    // True when a page is backed by the internal RAM rather than host memory.
+    [[nodiscard]] bool IsInternalPage(Byte Page) const;
+    // True while an internal page is still shared with another Memory.
+    [[nodiscard]] bool IsSharedPage(Byte Page) const;
+
+    // Marks a page as holding cached code; the next write to it notifies the listener once and clears the mark.
+    // Remapping a marked page notifies as well.
+    void MarkCodePage(Byte Page);
+    // A memory has one code write listener; installing a second one throws std::logic_error. Null removes it.
+    void SetCodeWriteListener(CodeWriteListener *Listener);
+    // Removes Listener if it is still the one installed.
+    void RemoveCodeWriteListener(const CodeWriteListener *Listener);
+
+    // Sends reads and/or writes of a page down the slow path, which reports them to the watch listener. Only
+    // ReadByte and WriteByte report; WriteBlock does not.
+    void WatchPage(Byte Page, bool Reads, bool Writes);
+    // Clears every watched page. Like the code write listener there is one; installing a second one throws
+    // std::logic_error.
+    void SetWatchListener(WatchListener *Listener);
+    void RemoveWatchListener(const WatchListener *Listener);
 };
 
 #endif // MEM_HPP
@@ -0,0 +1,266 @@
+#ifndef OPCODES_HPP
+#define OPCODES_HPP
+
+#include "mem.hpp"
+
+#include <array>
+#include <string>
+
+// clang-format off
+enum class Mnemonic : Byte {
+    ADC, AND, ASL, BCC, BCS, BEQ, BIT, BMI, BNE, BPL, BRK, BVC, BVS, CLC, CLD, CLI, CLV, CMP, CPX, CPY, DEC, DEX, DEY,
+    EOR, INC, INX, INY, JMP, JSR, LDA, LDX, LDY, LSR, NOP, ORA, PHA, PHP, PLA, PLP, ROL, ROR, RTI, RTS, SBC, SEC, SED,
+    SEI, STA, STX, STY, TAX, TAY, TSX, TXA, TXS, TYA,
+    // Undocumented opcodes.
+    Illegal,
+};
+// clang-format on
+
+enum class AddressingMode : Byte {
+    Implied,
+    Accumulator,
+    Immediate,
+    ZeroPage,
+    ZeroPageX,
+    ZeroPageY,
+    Absolute,
+    AbsoluteX,
+    AbsoluteY,
+    Indirect,
+    IndexedIndirectX,
+    IndirectIndexedY,
+    Relative,
+};
+
+// Extra cycles an instruction takes beyond OpcodeInfo::cycles.
+enum class PageCrossPenalty : Byte {
+    None,
+    // One cycle when the indexed address is on a different page than the base address.
+    IndexedRead,
+    // One cycle when the branch is taken and another when the target is on a different page.
+    Branch,
+};
+
+// Status register bits, as used by OpcodeInfo::flags.
+constexpr Byte FLAG_C = 0x01;
+constexpr Byte FLAG_Z = 0x02;
+constexpr Byte FLAG_I = 0x04;
+constexpr Byte FLAG_D = 0x08;
+constexpr Byte FLAG_B = 0x10;
+constexpr Byte FLAG_V = 0x40;
+constexpr Byte FLAG_N = 0x80;
+
+struct OpcodeInfo {
+    Mnemonic mnemonic;
+    AddressingMode mode;
+    // Opcode plus operand bytes.
+    Byte length;
+    // Cycles including the opcode and operand fetches, without page-cross penalties.
+    Byte cycles;
+    PageCrossPenalty penalty;
+    // Status bits the instruction can change.
+    Byte flags;
+};
+
+constexpr const char *MnemonicName(const Mnemonic mnemonic) {
+    constexpr const char *names[] = {
+        "ADC", "AND", "ASL", "BCC", "BCS", "BEQ", "BIT", "BMI", "BNE", "BPL", "BRK", "BVC", "BVS", "CLC", "CLD",
+        "CLI", "CLV", "CMP", "CPX", "CPY", "DEC", "DEX", "DEY", "EOR", "INC", "INX", "INY", "JMP", "JSR", "LDA",
+        "LDX", "LDY", "LSR", "NOP", "ORA", "PHA", "PHP", "PLA", "PLP", "ROL", "ROR", "RTI", "RTS", "SBC", "SEC",
+        "SED", "SEI", "STA", "STX", "STY", "TAX", "TAY", "TSX", "TXA", "TXS", "TYA", "???"};
+    return names[static_cast<Byte>(mnemonic)];
+}
+
+constexpr Byte ModeLength(const AddressingMode mode) {
+    switch (mode) {
+    case AddressingMode::Implied:
+    case AddressingMode::Accumulator:
+        return 1;
+    case AddressingMode::Absolute:
+    case AddressingMode::AbsoluteX:
+    case AddressingMode::AbsoluteY:
+    case AddressingMode::Indirect:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+constexpr Byte MnemonicFlags(const Mnemonic mnemonic) {
+    switch (mnemonic) {
+    case Mnemonic::ADC:
+    case Mnemonic::SBC:
+        return FLAG_N | FLAG_V | FLAG_Z | FLAG_C;
+    case Mnemonic::ASL:
+    case Mnemonic::LSR:
+    case Mnemonic::ROL:
+    case Mnemonic::ROR:
+    case Mnemonic::CMP:
+    case Mnemonic::CPX:
+    case Mnemonic::CPY:
+        return FLAG_N | FLAG_Z | FLAG_C;
+    case Mnemonic::BIT:
+        return FLAG_N | FLAG_V | FLAG_Z;
+    case Mnemonic::AND:
+    case Mnemonic::ORA:
+    case Mnemonic::EOR:
+    case Mnemonic::DEC:
+    case Mnemonic::DEX:
+    case Mnemonic::DEY:
+    case Mnemonic::INC:
+    case Mnemonic::INX:
+    case Mnemonic::INY:
+    case Mnemonic::LDA:
+    case Mnemonic::LDX:
+    case Mnemonic::LDY:
+    case Mnemonic::PLA:
+    case Mnemonic::TAX:
+    case Mnemonic::TAY:
+    case Mnemonic::TSX:
+    case Mnemonic::TXA:
+    case Mnemonic::TYA:
+        return FLAG_N | FLAG_Z;
+    case Mnemonic::CLC:
+    case Mnemonic::SEC:
+        return FLAG_C;
+    case Mnemonic::CLD:
+    case Mnemonic::SED:
+        return FLAG_D;
+    case Mnemonic::CLI:
+    case Mnemonic::SEI:
+        return FLAG_I;
+    case Mnemonic::CLV:
+        return FLAG_V;
+    case Mnemonic::BRK:
+        return FLAG_B | FLAG_I;
+    case Mnemonic::PLP:
+    case Mnemonic::RTI:
+        return FLAG_N | FLAG_V | FLAG_B | FLAG_D | FLAG_I | FLAG_Z | FLAG_C;
+    default:
+        return 0;
+    }
+}
+
+// Instructions whose indexed reads pay for page crossings; stores and read-modify-write instructions always take
+// the extra cycle and have it in their base count.
+constexpr bool ReadsOperand(const Mnemonic mnemonic) {
+    switch (mnemonic) {
+    case Mnemonic::ADC:
+    case Mnemonic::AND:
+    case Mnemonic::CMP:
+    case Mnemonic::EOR:
+    case Mnemonic::LDA:
+    case Mnemonic::LDX:
+    case Mnemonic::LDY:
+    case Mnemonic::ORA:
+    case Mnemonic::SBC:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The documented NMOS 6502 instruction set; every other opcode is Illegal.
+constexpr std::array<OpcodeInfo, 256> BuildOpcodeTable() {
+    struct Entry {
+        Byte code;
+        Mnemonic mnemonic;
+        AddressingMode mode;
+        Byte cycles;
+    };
+    using M = Mnemonic;
+    using A = AddressingMode;
+    // clang-format off
+    constexpr Entry entries[] = {
+        {0x69, M::ADC, A::Immediate, 2}, {0x65, M::ADC, A::ZeroPage, 3}, {0x75, M::ADC, A::ZeroPageX, 4},
+        {0x6D, M::ADC, A::Absolute, 4}, {0x7D, M::ADC, A::AbsoluteX, 4}, {0x79, M::ADC, A::AbsoluteY, 4},
+        {0x61, M::ADC, A::IndexedIndirectX, 6}, {0x71, M::ADC, A::IndirectIndexedY, 5},
+        {0x29, M::AND, A::Immediate, 2}, {0x25, M::AND, A::ZeroPage, 3}, {0x35, M::AND, A::ZeroPageX, 4},
+        {0x2D, M::AND, A::Absolute, 4}, {0x3D, M::AND, A::AbsoluteX, 4}, {0x39, M::AND, A::AbsoluteY, 4},
+        {0x21, M::AND, A::IndexedIndirectX, 6}, {0x31, M::AND, A::IndirectIndexedY, 5},
+        {0x0A, M::ASL, A::Accumulator, 2}, {0x06, M::ASL, A::ZeroPage, 5}, {0x16, M::ASL, A::ZeroPageX, 6},
+        {0x0E, M::ASL, A::Absolute, 6}, {0x1E, M::ASL, A::AbsoluteX, 7},
+        {0x90, M::BCC, A::Relative, 2}, {0xB0, M::BCS, A::Relative, 2}, {0xF0, M::BEQ, A::Relative, 2},
+        {0x30, M::BMI, A::Relative, 2}, {0xD0, M::BNE, A::Relative, 2}, {0x10, M::BPL, A::Relative, 2},
+        {0x50, M::BVC, A::Relative, 2}, {0x70, M::BVS, A::Relative, 2},
+        {0x24, M::BIT, A::ZeroPage, 3}, {0x2C, M::BIT, A::Absolute, 4},
+        {0x00, M::BRK, A::Implied, 7},
+        {0x18, M::CLC, A::Implied, 2}, {0xD8, M::CLD, A::Implied, 2}, {0x58, M::CLI, A::Implied, 2},
+        {0xB8, M::CLV, A::Implied, 2},
+        {0xC9, M::CMP, A::Immediate, 2}, {0xC5, M::CMP, A::ZeroPage, 3}, {0xD5, M::CMP, A::ZeroPageX, 4},
+        {0xCD, M::CMP, A::Absolute, 4}, {0xDD, M::CMP, A::AbsoluteX, 4}, {0xD9, M::CMP, A::AbsoluteY, 4},
+        {0xC1, M::CMP, A::IndexedIndirectX, 6}, {0xD1, M::CMP, A::IndirectIndexedY, 5},
+        {0xE0, M::CPX, A::Immediate, 2}, {0xE4, M::CPX, A::ZeroPage, 3}, {0xEC, M::CPX, A::Absolute, 4},
+        {0xC0, M::CPY, A::Immediate, 2}, {0xC4, M::CPY, A::ZeroPage, 3}, {0xCC, M::CPY, A::Absolute, 4},
+        {0xC6, M::DEC, A::ZeroPage, 5}, {0xD6, M::DEC, A::ZeroPageX, 6}, {0xCE, M::DEC, A::Absolute, 6},
+        {0xDE, M::DEC, A::AbsoluteX, 7},
+        {0xCA, M::DEX, A::Implied, 2}, {0x88, M::DEY, A::Implied, 2},
+        {0x49, M::EOR, A::Immediate, 2}, {0x45, M::EOR, A::ZeroPage, 3}, {0x55, M::EOR, A::ZeroPageX, 4},
+        {0x4D, M::EOR, A::Absolute, 4}, {0x5D, M::EOR, A::AbsoluteX, 4}, {0x59, M::EOR, A::AbsoluteY, 4},
+        {0x41, M::EOR, A::IndexedIndirectX, 6}, {0x51, M::EOR, A::IndirectIndexedY, 5},
+        {0xE6, M::INC, A::ZeroPage, 5}, {0xF6, M::INC, A::ZeroPageX, 6}, {0xEE, M::INC, A::Absolute, 6},
+        {0xFE, M::INC, A::AbsoluteX, 7},
+        {0xE8, M::INX, A::Implied, 2}, {0xC8, M::INY, A::Implied, 2},
+        {0x4C, M::JMP, A::Absolute, 3}, {0x6C, M::JMP, A::Indirect, 5},
+        {0x20, M::JSR, A::Absolute, 6},
+        {0xA9, M::LDA, A::Immediate, 2}, {0xA5, M::LDA, A::ZeroPage, 3}, {0xB5, M::LDA, A::ZeroPageX, 4},
+        {0xAD, M::LDA, A::Absolute, 4}, {0xBD, M::LDA, A::AbsoluteX, 4}, {0xB9, M::LDA, A::AbsoluteY, 4},
+        {0xA1, M::LDA, A::IndexedIndirectX, 6}, {0xB1, M::LDA, A::IndirectIndexedY, 5},
+        {0xA2, M::LDX, A::Immediate, 2}, {0xA6, M::LDX, A::ZeroPage, 3}, {0xB6, M::LDX, A::ZeroPageY, 4},
+        {0xAE, M::LDX, A::Absolute, 4}, {0xBE, M::LDX, A::AbsoluteY, 4},
+        {0xA0, M::LDY, A::Immediate, 2}, {0xA4, M::LDY, A::ZeroPage, 3}, {0xB4, M::LDY, A::ZeroPageX, 4},
+        {0xAC, M::LDY, A::Absolute, 4}, {0xBC, M::LDY, A::AbsoluteX, 4},
+        {0x4A, M::LSR, A::Accumulator, 2}, {0x46, M::LSR, A::ZeroPage, 5}, {0x56, M::LSR, A::ZeroPageX, 6},
+        {0x4E, M::LSR, A::Absolute, 6}, {0x5E, M::LSR, A::AbsoluteX, 7},
+        {0xEA, M::NOP, A::Implied, 2},
+        {0x09, M::ORA, A::Immediate, 2}, {0x05, M::ORA, A::ZeroPage, 3}, {0x15, M::ORA, A::ZeroPageX, 4},
+        {0x0D, M::ORA, A::Absolute, 4}, {0x1D, M::ORA, A::AbsoluteX, 4}, {0x19, M::ORA, A::AbsoluteY, 4},
+        {0x01, M::ORA, A::IndexedIndirectX, 6}, {0x11, M::ORA, A::IndirectIndexedY, 5},
+        {0x48, M::PHA, A::Implied, 3}, {0x08, M::PHP, A::Implied, 3}, {0x68, M::PLA, A::Implied, 4},
+        {0x28, M::PLP, A::Implied, 4},
+        {0x2A, M::ROL, A::Accumulator, 2}, {0x26, M::ROL, A::ZeroPage, 5}, {0x36, M::ROL, A::ZeroPageX, 6},
+        {0x2E, M::ROL, A::Absolute, 6}, {0x3E, M::ROL, A::AbsoluteX, 7},
+        {0x6A, M::ROR, A::Accumulator, 2}, {0x66, M::ROR, A::ZeroPage, 5}, {0x76, M::ROR, A::ZeroPageX, 6},
+        {0x6E, M::ROR, A::Absolute, 6}, {0x7E, M::ROR, A::AbsoluteX, 7},
+        {0x40, M::RTI, A::Implied, 6}, {0x60, M::RTS, A::Implied, 6},
+        {0xE9, M::SBC, A::Immediate, 2}, {0xE5, M::SBC, A::ZeroPage, 3}, {0xF5, M::SBC, A::ZeroPageX, 4},
+        {0xED, M::SBC, A::Absolute, 4}, {0xFD, M::SBC, A::AbsoluteX, 4}, {0xF9, M::SBC, A::AbsoluteY, 4},
+        {0xE1, M::SBC, A::IndexedIndirectX, 6}, {0xF1, M::SBC, A::IndirectIndexedY, 5},
+        {0x38, M::SEC, A::Implied, 2}, {0xF8, M::SED, A::Implied, 2}, {0x78, M::SEI, A::Implied, 2},
+        {0x85, M::STA, A::ZeroPage, 3}, {0x95, M::STA, A::ZeroPageX, 4}, {0x8D, M::STA, A::Absolute, 4},
+        {0x9D, M::STA, A::AbsoluteX, 5}, {0x99, M::STA, A::AbsoluteY, 5}, {0x81, M::STA, A::IndexedIndirectX, 6},
+        {0x91, M::STA, A::IndirectIndexedY, 6},
+        {0x86, M::STX, A::ZeroPage, 3}, {0x96, M::STX, A::ZeroPageY, 4}, {0x8E, M::STX, A::Absolute, 4},
+        {0x84, M::STY, A::ZeroPage, 3}, {0x94, M::STY, A::ZeroPageX, 4}, {0x8C, M::STY, A::Absolute, 4},
+        {0xAA, M::TAX, A::Implied, 2}, {0xA8, M::TAY, A::Implied, 2}, {0xBA, M::TSX, A::Implied, 2},
+        {0x8A, M::TXA, A::Implied, 2}, {0x9A, M::TXS, A::Implied, 2}, {0x98, M::TYA, A::Implied, 2},
+    };
+    // clang-format on
+    std::array<OpcodeInfo, 256> table{};
+    for (OpcodeInfo &info : table)
+        info = {Mnemonic::Illegal, AddressingMode::Implied, 1, 0, PageCrossPenalty::None, 0};
+    for (const Entry &entry : entries) {
+        PageCrossPenalty penalty = PageCrossPenalty::None;
+        if (entry.mode == AddressingMode::Relative)
+            penalty = PageCrossPenalty::Branch;
+        else if (ReadsOperand(entry.mnemonic) &&
+                 (entry.mode == AddressingMode::AbsoluteX || entry.mode == AddressingMode::AbsoluteY ||
+                  entry.mode == AddressingMode::IndirectIndexedY))
+            penalty = PageCrossPenalty::IndexedRead;
+        table[entry.code] = {entry.mnemonic, entry.mode, ModeLength(entry.mode), entry.cycles, penalty,
+                             MnemonicFlags(entry.mnemonic)};
+    }
+    return table;
+}
+
+// Built at compile time; the interpreter, block cache, JIT and lockstep engine all take lengths and cycle costs
+// from here.
+inline constexpr std::array<OpcodeInfo, 256> OPCODES = BuildOpcodeTable();
+
+// Formats one instruction as assembly, for example "LDA $1234,X". Relative branches show their target, computed
+// from pc, and undocumented opcodes print as ".byte $xx".
+std::string Disassemble(Word pc, Byte opcode, Word operand);
+// Disassembles the instruction at pc and returns its length.
+Byte Disassemble(const Memory &memory, Word pc, std::string &text);
+
+#endif // OPCODES_HPP
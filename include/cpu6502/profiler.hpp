@@ -0,0 +1,83 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "cpu.hpp"
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+// Counts executions, cycles and page-crossing penalties of a ProfilingCPU per PC and per opcode. Counters are flat
+// arrays indexed by address and opcode, so attributing an instruction is a handful of increments. Cycles are also
+// charged to a calling-context tree whose frames are entered with Call and left with Return; Report prints the
+// hottest addresses and WriteFolded emits one line per stack for flamegraph tools.
+class Profiler {
+public:
+    Profiler();
+
+    void Clear();
+
+    [[nodiscard]] u64 Executions(Word pc) const;
+    [[nodiscard]] u64 Cycles(Word pc) const;
+    // Extra cycles taken by indexed reads whose effective address crossed a page.
+    [[nodiscard]] u64 PageCrosses(Word pc) const;
+    [[nodiscard]] u64 OpcodeExecutions(Byte opcode) const;
+    [[nodiscard]] u64 OpcodeCycles(Byte opcode) const;
+    [[nodiscard]] u64 OpcodePageCrosses(Byte opcode) const;
+    [[nodiscard]] u64 TotalExecutions() const;
+    [[nodiscard]] u64 TotalCycles() const;
+
+    // Enters and leaves a subroutine frame of the call tree; meant for JSR and RTS. Return at the root is ignored.
+    void Call(Word target);
+    void Return();
+
+    // Writes the top addresses by cycles, then every executed opcode, both sorted by cycles.
+    void Report(std::ostream &out, std::size_t top = 20) const;
+    // Writes "root;$C000;$C100 cycles" lines, one per call-tree frame with cycles of its own.
+    void WriteFolded(std::ostream &out) const;
+
+private:
+    static constexpr u32 NO_FRAME = ~0u;
+
+    struct Frame {
+        Word entry;
+        u32 parent;
+        u32 first_child;
+        u32 next_sibling;
+        u64 cycles;
+    };
+
+    std::vector<u64> pc_executions;
+    std::vector<u64> pc_cycles;
+    std::vector<u64> pc_crosses;
+    // Last opcode executed at each address, for the report.
+    std::vector<Byte> pc_opcodes;
+    u64 opcode_executions[256]{};
+    u64 opcode_cycles[256]{};
+    u64 opcode_crosses[256]{};
+    std::vector<Frame> frames;
+    u32 frame = 0;
+    u32 pending_crosses = 0;
+
+    void PageCrossed() { ++pending_crosses; }
+
+    void Executed(const Word pc, const Byte opcode, const u32 taken) {
+        ++pc_executions[pc];
+        pc_cycles[pc] += taken;
+        pc_opcodes[pc] = opcode;
+        ++opcode_executions[opcode];
+        opcode_cycles[opcode] += taken;
+        frames[frame].cycles += taken;
+        if (pending_crosses != 0) {
+            pc_crosses[pc] += pending_crosses;
+            opcode_crosses[opcode] += pending_crosses;
+            pending_crosses = 0;
+        }
+    }
+
+    void WriteFrame(std::ostream &out, u32 index) const;
+
+    template <typename> friend class BasicCPU;
+};
+
+#endif // PROFILER_HPP
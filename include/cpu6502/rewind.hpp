@@ -0,0 +1,84 @@
+#ifndef REWIND_HPP
+#define REWIND_HPP
+
+#include "cpu.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+// Reverse execution for a CPU: Execute takes a checkpoint every interval cycles, and StepBack and SeekCycle restore
+// the nearest checkpoint before their target and replay forward to it.
+//
+// A checkpoint is a fork of the memory plus the registers, so taking one copies the page table only. The journal
+// is kept by the memory's copy-on-write pages: the first write to a page after a checkpoint copies it, and the
+// checkpoint keeps the old copy. When the pages held only by checkpoints exceed the journal limit, the oldest
+// checkpoints are dropped. Like save states, this covers the internal RAM; host pages and devices are not rolled
+// back, so replay is exact for machines whose devices do not change what the program sees.
+//
+// Execute after a seek to the past discards the checkpoints after it, since the run then makes a new history.
+class Rewind {
+    struct Snapshot {
+        Memory memory;
+        Word pc;
+        Word sp;
+        Byte a;
+        Byte x;
+        Byte y;
+        Byte p;
+        bool irq;
+        bool nmi;
+        // Taken right after a CLI with IRQ held, which delays the IRQ by one instruction.
+        bool irq_delayed;
+        u32 cycles;
+        // Bytes of pages this checkpoint holds that the next one does not share.
+        std::size_t bytes;
+    };
+
+    CPU &cpu;
+    u32 interval;
+    std::size_t journal_limit;
+    std::deque<Snapshot> snapshots;
+    // Sum of bytes over all checkpoints.
+    std::size_t journal = 0;
+    // The cycle the recorded history reaches, which seeks may return to after going back.
+    u32 latest = 0;
+
+    // Cycles from the oldest checkpoint, so comparisons survive the cycle counter wrapping.
+    [[nodiscard]] u32 Age(u32 cycle) const;
+    [[nodiscard]] static std::size_t Diverged(const Memory &older, const Memory &newer);
+    void Restore(const Snapshot &snapshot);
+    // Drops the checkpoints after the current cycle, left behind by a seek to the past.
+    void Truncate();
+    // Runs count cycles from a restored checkpoint with the debugger detached; with starts, one instruction at a
+    // time, recording the cycle count before each.
+    void Replay(u32 count, std::vector<u32> *starts);
+    // The newest checkpoint at or before a cycle.
+    [[nodiscard]] std::size_t Nearest(u32 cycle) const;
+
+public:
+    static constexpr u32 DEFAULT_INTERVAL = 1 << 20;
+    static constexpr std::size_t DEFAULT_JOURNAL_LIMIT = std::size_t{64} << 20;
+
+    // Takes the first checkpoint at the CPU's current state; throws std::invalid_argument for a zero interval.
+    explicit Rewind(CPU &processor, u32 checkpoint_interval = DEFAULT_INTERVAL,
+                    std::size_t journal_bytes = DEFAULT_JOURNAL_LIMIT);
+
+    // Runs like CPU::Execute, taking checkpoints on the way; returns early when the CPU stops early.
+    void Execute(u32 exec_cycles);
+    void Checkpoint();
+
+    // Goes back count instructions, counting an interrupt entry as one; false, with the CPU replayed back to where
+    // it was, when that is before the oldest checkpoint.
+    bool StepBack(u32 count = 1);
+    // Goes to the first instruction boundary at or after cycle; false when it is before the oldest checkpoint or
+    // after the recorded history.
+    bool SeekCycle(u32 cycle);
+
+    [[nodiscard]] u32 OldestCycle() const { return snapshots.front().cycles; }
+    [[nodiscard]] std::size_t Checkpoints() const { return snapshots.size(); }
+    // Bytes of pages held only by checkpoints, including those the live memory has copied since the newest one.
+    [[nodiscard]] std::size_t JournalBytes() const;
+};
+
+#endif // REWIND_HPP
@@ -0,0 +1,26 @@
+#ifndef SAVESTATE_HPP
+#define SAVESTATE_HPP
+
+#include "cpu.hpp"
+
+#include <string>
+
+// Versioned binary snapshot of a CPU and the internal RAM of its memory. The file holds a little-endian header
+// with the registers, packed status flags, interrupt lines and cycle counter, a bitmap of non-zero pages, and then those pages in
+// ascending order, each at a PAGE_BYTES aligned offset. All-zero pages are not stored.
+//
+// Host and device mappings are not part of a save state; loading replaces the internal RAM behind every page and
+// leaves the target's mappings in place. On POSIX hosts Load maps the file privately and points the restored pages
+// straight into the mapping, so loading copies no page data and writes never reach the file.
+class SaveState {
+public:
+    // Version 2 added the interrupt lines; version 1 files still load, with no interrupt pending.
+    static constexpr u32 VERSION = 2;
+
+    // Throws std::runtime_error when the file cannot be written.
+    static void Save(const std::string &Path, const CPU &cpu, const Memory &memory);
+    // Throws std::runtime_error when the file cannot be read, is truncated, or has an unknown magic or version.
+    static void Load(const std::string &Path, CPU &cpu, Memory &memory);
+};
+
+#endif // SAVESTATE_HPP
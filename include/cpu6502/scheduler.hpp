@@ -0,0 +1,100 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include "cpu.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+// Device events on a 64-bit cycle timeline. Run executes a CPU without interruption up to the earliest pending
+// event, fires every event that is due and continues, so devices never have to poll the CPU cycle by cycle.
+//
+// Instructions are not split, so an event fires after the instruction that reaches its cycle; Now() may then be a
+// few cycles past it. Callbacks receive the cycle they were scheduled for, and periodic devices should reschedule
+// relative to that cycle so their period does not drift.
+//
+// Devices may call Now() and schedule events while Run executes: Now() counts the cycles the CPU has run so far,
+// and an event due before the running slice ends stops the CPU at the next instruction boundary. When the CPU stops
+// for any other reason (a breakpoint, a watchpoint or RequestStop), Run fires the events that are due and returns.
+class Scheduler {
+public:
+    using EventId = u64;
+    using Callback = std::function<void(u64 when)>;
+
+    static constexpr u64 NO_EVENT = std::numeric_limits<u64>::max();
+
+private:
+    struct Entry {
+        u64 when;
+        EventId id;
+    };
+
+    // Min-heap on (when, id): events due at the same cycle fire in the order they were scheduled. Cancelled events
+    // stay in the heap until they reach the top.
+    std::vector<Entry> heap;
+    std::unordered_map<EventId, Callback> callbacks;
+    u64 now = 0;
+    EventId next_id = 0;
+    // While Run executes a slice: the CPU's cycle counter and its value when the slice began, the cycle the slice
+    // ends at, how to stop the CPU early, and whether an event asked to.
+    const u32 *clock = nullptr;
+    u32 clock_start = 0;
+    u64 slice_end = 0;
+    void *running = nullptr;
+    void (*stop)(void *) = nullptr;
+    bool stopped_for_event = false;
+
+    static bool Later(const Entry &a, const Entry &b);
+    void PopFront();
+    void DropCancelled();
+
+public:
+    // Cycles run on this timeline so far, including those of a slice Run is executing.
+    [[nodiscard]] u64 Now() const;
+    // Cycle of the earliest pending event, or NO_EVENT.
+    [[nodiscard]] u64 NextEvent() const;
+    [[nodiscard]] std::size_t Pending() const;
+
+    // Events at or before Now() fire on the next call to Run or Fire.
+    EventId Schedule(u64 when, Callback callback);
+    EventId ScheduleIn(u64 delay, Callback callback);
+    // Returns false when the event already fired or was cancelled.
+    bool Cancel(EventId id);
+    void Clear();
+
+    // Fires the events due at or before Now().
+    void Fire();
+
+    // Runs cpu for at least exec_cycles cycles (instructions for policies that do not count cycles), firing events
+    // as the timeline reaches them, unless the CPU stops early. Returns the cycles actually run.
+    template <typename Policy> u64 Run(BasicCPU<Policy> &cpu, u64 exec_cycles);
+};
+
+template <typename Policy> u64 Scheduler::Run(BasicCPU<Policy> &cpu, const u64 exec_cycles) {
+    const u64 start = now;
+    const u64 end = now + exec_cycles;
+    Fire();
+    while (now < end) {
+        slice_end = std::min(NextEvent(), end);
+        const u64 slice = std::min<u64>(slice_end - now, std::numeric_limits<u32>::max());
+        const u32 before = cpu.cycles;
+        clock = &cpu.cycles;
+        clock_start = before;
+        running = &cpu;
+        stop = [](void *processor) { static_cast<BasicCPU<Policy> *>(processor)->RequestStop(); };
+        stopped_for_event = false;
+        cpu.Execute(static_cast<u32>(slice));
+        clock = nullptr;
+        const u32 ran = cpu.cycles - before;
+        now += ran;
+        Fire();
+        if (ran < slice && !stopped_for_event)
+            break;
+    }
+    return now - start;
+}
+
+#endif // SCHEDULER_HPP
@@ -0,0 +1,108 @@
+#ifndef STEPPED_HPP
+#define STEPPED_HPP
+
+#include "cpu.hpp"
+
+#include <coroutine>
+#include <cstddef>
+
+enum class BusOp : Byte {
+    Read,
+    Write,
+    // Internal cycle; address is what a 6502 would put on the bus for its dummy read, but nothing is read.
+    Idle,
+};
+
+struct BusAccess {
+    Word address;
+    Byte value;
+    BusOp op;
+};
+
+// Cycle-stepped core on top of a CPU's registers and memory. Each instruction is a coroutine that suspends at every
+// bus cycle, so a bus master can run DMA, video or other devices between any two cycles of an instruction.
+// Instructions and interrupts take the same cycles, in the same order of reads and writes, as the interpreter;
+// operand words are fetched a byte per cycle.
+//
+// Requires C++20 and is built as the cpu6502::stepped library when the compiler supports coroutines.
+class SteppedCPU {
+    // Recycles instruction frames, which all have the same size, so steady-state stepping does not allocate.
+    class FramePool {
+        struct Block {
+            Block *next;
+        };
+        Block *free = nullptr;
+        std::size_t block_size = 0;
+
+        void Drain();
+
+    public:
+        FramePool() = default;
+        FramePool(const FramePool &) = delete;
+        FramePool &operator=(const FramePool &) = delete;
+        ~FramePool();
+
+        void *Allocate(std::size_t size);
+        void Release(void *frame, std::size_t size);
+    };
+
+    class Instruction {
+    public:
+        struct promise_type {
+            static void *operator new(std::size_t size, SteppedCPU &core);
+            static void operator delete(void *frame, std::size_t size);
+
+            Instruction get_return_object() {
+                return Instruction(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception();
+        };
+
+        Instruction() = default;
+        explicit Instruction(std::coroutine_handle<promise_type> Handle) : handle(Handle) {}
+        Instruction(Instruction &&Other) noexcept;
+        Instruction &operator=(Instruction &&Other) noexcept;
+        ~Instruction();
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    // Suspends the instruction until the bus master runs the access; resumes with the byte read.
+    struct Cycle {
+        SteppedCPU &core;
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<>) const noexcept {}
+        [[nodiscard]] Byte await_resume() const noexcept { return core.access.value; }
+    };
+
+    CPU &cpu;
+    FramePool pool;
+    Instruction current;
+    BusAccess access{};
+    BusAccess last{};
+
+    Cycle Read(Word address);
+    Cycle Write(Word address, Byte value);
+    Cycle Idle(Word address);
+    Cycle Push(Byte value);
+    Cycle Pull();
+    Instruction Run();
+
+public:
+    explicit SteppedCPU(CPU &core);
+    SteppedCPU(const SteppedCPU &) = delete;
+    SteppedCPU &operator=(const SteppedCPU &) = delete;
+
+    // Runs one bus cycle and returns it.
+    const BusAccess &Step();
+    // True when the last instruction has finished and the next Step fetches an opcode.
+    [[nodiscard]] bool AtInstructionBoundary() const;
+    // Steps until at least exec_cycles have run, stopping at the first instruction boundary after that.
+    void Execute(u32 exec_cycles);
+};
+
+#endif // STEPPED_HPP
@@ -0,0 +1,39 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include "cpu.hpp"
+
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+
+// Keeps the last Capacity() instructions of a TracingCPU as fixed-size binary records. The ring is allocated once;
+// recording an instruction is a single record store with no allocation or formatting, and text is only produced
+// by Dump. Attach with TracingCPU::SetObserver; a TracingCPU without an observer pays one null check per
+// instruction, and CPU compiles tracing out entirely.
+class TraceRing final : public InstructionObserver {
+public:
+    // Capacity is rounded up to a power of two.
+    explicit TraceRing(std::size_t capacity);
+
+    void OnInstruction(const InstructionRecord &record) override { records[recorded++ & mask] = record; }
+
+    [[nodiscard]] std::size_t Capacity() const;
+    // Records currently held, at most Capacity().
+    [[nodiscard]] std::size_t Size() const;
+    // Instructions seen since construction or the last Clear, including overwritten ones.
+    [[nodiscard]] u64 Recorded() const;
+    // index 0 is the oldest record still held.
+    [[nodiscard]] const InstructionRecord &Record(std::size_t index) const;
+    void Clear();
+
+    // Writes the last count records (all held records when count is 0), oldest first, one line each.
+    void Dump(std::ostream &out, std::size_t count = 0) const;
+
+private:
+    std::unique_ptr<InstructionRecord[]> records;
+    std::size_t mask;
+    u64 recorded = 0;
+};
+
+#endif // TRACE_HPP
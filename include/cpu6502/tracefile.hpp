@@ -0,0 +1,92 @@
+#ifndef TRACEFILE_HPP
+#define TRACEFILE_HPP
+
+#include "cpu.hpp"
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Streams every instruction of a TracingCPU to disk without stalling it. Records are collected into fixed-size
+// batches on the emulation thread; full batches go to a background writer over a lock-free single-producer queue
+// and come back empty over a second one, so the hot path never allocates, locks or touches the file. When every
+// batch is in flight the emulation thread waits for the writer.
+//
+// The writer turns each batch into one chunk: the first record is stored whole and every later one as a delta
+// against its predecessor (sequential PCs cost nothing, only changed registers are stored, operands and cycle
+// deltas are variable length). A table of contents keyed by 64-bit start cycle closes the file, so
+// TraceFileReader can seek to any cycle by decoding a single chunk.
+class TraceFileWriter final : public InstructionObserver {
+public:
+    static constexpr std::size_t DEFAULT_CHUNK_RECORDS = 4096;
+    static constexpr std::size_t BATCHES = 8;
+
+    // Throws std::runtime_error when the file cannot be created.
+    explicit TraceFileWriter(const std::string &Path, std::size_t chunk_records = DEFAULT_CHUNK_RECORDS);
+    // Closes the file if Close has not been called; errors are dropped.
+    ~TraceFileWriter() override;
+    TraceFileWriter(const TraceFileWriter &) = delete;
+    TraceFileWriter &operator=(const TraceFileWriter &) = delete;
+
+    void OnInstruction(const InstructionRecord &record) override {
+        batch[used] = record;
+        if (++used == chunk_size)
+            Submit();
+    }
+
+    // Writes the pending records and the table of contents and stops the writer thread. Throws std::runtime_error
+    // when any write failed.
+    void Close();
+
+private:
+    struct Stream;
+
+    InstructionRecord *batch = nullptr;
+    std::size_t used = 0;
+    std::size_t chunk_size;
+    std::unique_ptr<Stream> stream;
+
+    void Submit();
+};
+
+// Reads a file written by TraceFileWriter.
+class TraceFileReader {
+public:
+    // Throws std::runtime_error when the file is missing, truncated or not a trace.
+    explicit TraceFileReader(const std::string &Path);
+
+    [[nodiscard]] u64 Count() const;
+    [[nodiscard]] std::size_t Chunks() const;
+
+    // Positions the reader at the first instruction that starts at or after cycle; only the chunk holding it is
+    // decoded.
+    void SeekCycle(u64 cycle);
+    // Reads the next record; false at the end of the trace.
+    bool Next(InstructionRecord &record);
+    // Start cycle of the record last returned by Next, extended past the 32-bit wrap of InstructionRecord::cycles.
+    [[nodiscard]] u64 Cycle() const;
+
+private:
+    struct Chunk {
+        u64 first_cycle;
+        u64 offset;
+    };
+
+    std::ifstream file;
+    std::vector<Chunk> chunks;
+    u64 count = 0;
+    std::size_t next_chunk = 0;
+    std::vector<Byte> data;
+    std::size_t position = 0;
+    u32 remaining = 0;
+    InstructionRecord previous{};
+    u64 cycle = 0;
+    // Set by SeekCycle when it has already decoded the record Next returns first.
+    bool buffered = false;
+
+    void LoadChunk(std::size_t index);
+};
+
+#endif // TRACEFILE_HPP
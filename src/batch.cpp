@@ -0,0 +1,158 @@
+#include "cpu6502/batch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+// A worker's remaining jobs [begin, end), packed into one word so the owner and thieves can claim with one CAS.
+struct alignas(64) WorkRange {
+    std::atomic<u64> range{0};
+};
+
+u64 Pack(const u32 begin, const u32 end) { return static_cast<u64>(begin) << 32 | end; }
+u32 Begin(const u64 range) { return static_cast<u32>(range >> 32); }
+u32 End(const u64 range) { return static_cast<u32>(range); }
+
+bool PopFront(WorkRange &queue, u32 &job) {
+    u64 range = queue.range.load(std::memory_order_relaxed);
+    while (Begin(range) < End(range)) {
+        if (queue.range.compare_exchange_weak(range, Pack(Begin(range) + 1, End(range)), std::memory_order_acquire,
+                                              std::memory_order_relaxed)) {
+            job = Begin(range);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Moves the upper half of the fullest victim's range into the thief's own (empty) range.
+bool Steal(WorkRange *queues, const unsigned count, const unsigned thief) {
+    for (;;) {
+        unsigned victim = count;
+        u32 largest = 0;
+        u64 range = 0;
+        for (unsigned i = 0; i < count; ++i) {
+            const u64 candidate = queues[i].range.load(std::memory_order_relaxed);
+            const u32 remaining = End(candidate) - Begin(candidate);
+            if (i != thief && remaining > largest) {
+                victim = i;
+                largest = remaining;
+                range = candidate;
+            }
+        }
+        if (victim == count)
+            return false;
+        const u32 mid = Begin(range) + largest / 2;
+        if (queues[victim].range.compare_exchange_strong(range, Pack(Begin(range), mid), std::memory_order_acq_rel,
+                                                         std::memory_order_relaxed)) {
+            queues[thief].range.store(Pack(mid, End(range)), std::memory_order_release);
+            return true;
+        }
+    }
+}
+} // namespace
+
+double BatchStats::JobsPerSecond() const { return seconds > 0.0 ? jobs / seconds : 0.0; }
+
+BatchRunner::BatchRunner(const Memory &source) : image(source) {}
+
+u32 BatchRunner::AddJob(const std::vector<MemoryPatch> &job_patches, const RegisterSeed seed) {
+    jobs.push_back({static_cast<u32>(patches.size()), static_cast<u32>(job_patches.size()), seed});
+    patches.insert(patches.end(), job_patches.begin(), job_patches.end());
+    return static_cast<u32>(jobs.size() - 1);
+}
+
+void BatchRunner::AddCapture(const Word address, const Word length) {
+    if (static_cast<u32>(address) + length > MAX_MEM)
+        throw std::out_of_range("BatchRunner capture range exceeds memory");
+    captures.push_back({address, length});
+    capture_bytes += length;
+}
+
+void BatchRunner::Reserve(const std::size_t job_count, const std::size_t patch_count) {
+    jobs.reserve(job_count);
+    patches.reserve(patch_count);
+}
+
+void BatchRunner::RunJob(const u32 index, const Memory &base, Memory &memory, CPU &cpu, const u32 exec_cycles) {
+    const Job &job = jobs[index];
+    memory = base;
+    for (u32 i = 0; i < job.patch_count; ++i) {
+        const MemoryPatch &patch = patches[job.first_patch + i];
+        memory.WriteByte(patch.address, patch.value);
+    }
+    cpu.Reset();
+    cpu.A = job.seed.A;
+    cpu.X = job.seed.X;
+    cpu.Y = job.seed.Y;
+    cpu.SetStatusRegister(job.seed.P);
+    cpu.Execute(exec_cycles);
+
+    results[index] = {cpu.PC, cpu.SP, cpu.A, cpu.X, cpu.Y, cpu.StatusRegister(), cpu.cycles};
+    Byte *out = captured.data() + index * capture_bytes;
+    for (const Capture &capture : captures) {
+        for (u32 i = 0; i < capture.length; ++i)
+            out[i] = memory.ReadByte(static_cast<Word>(capture.address + i));
+        out += capture.length;
+    }
+}
+
+void BatchRunner::Run(const u32 exec_cycles, unsigned threads) {
+    for (u32 page = 0; page < PAGE_COUNT; ++page)
+        if (image.IsDevicePage(static_cast<Byte>(page)) || !image.IsInternalPage(static_cast<Byte>(page)))
+            throw std::invalid_argument("BatchRunner image must be backed by internal RAM only");
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    const u32 count = static_cast<u32>(jobs.size());
+    threads = std::max(1u, std::min(threads, count));
+
+    results.assign(count, BatchResult{});
+    captured.assign(count * capture_bytes, 0);
+
+    const std::unique_ptr<WorkRange[]> queues(new WorkRange[threads]);
+    for (unsigned i = 0; i < threads; ++i) {
+        const u32 begin = static_cast<u32>(static_cast<u64>(count) * i / threads);
+        const u32 end = static_cast<u32>(static_cast<u64>(count) * (i + 1) / threads);
+        queues[i].range.store(Pack(begin, end), std::memory_order_relaxed);
+    }
+
+    // Forked once here so that workers only ever read the shared pages while forking it for every job.
+    const Memory base = image;
+    auto worker = [&](const unsigned id) {
+        const auto memory = std::make_unique<Memory>();
+        CPU cpu(*memory);
+        u32 job;
+        for (;;) {
+            while (PopFront(queues[id], job))
+                RunJob(job, base, *memory, cpu, exec_cycles);
+            if (!Steal(queues.get(), threads, id))
+                break;
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i)
+        pool.emplace_back(worker, i);
+    worker(0);
+    for (std::thread &thread : pool)
+        thread.join();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    stats = {count, threads, elapsed.count()};
+}
+
+std::size_t BatchRunner::JobCount() const { return jobs.size(); }
+
+const BatchResult &BatchRunner::Result(const u32 job) const { return results.at(job); }
+
+const Byte *BatchRunner::Captured(const u32 job) const { return captured.data() + job * capture_bytes; }
+
+std::size_t BatchRunner::CaptureBytes() const { return capture_bytes; }
+
+const BatchStats &BatchRunner::Stats() const { return stats; }
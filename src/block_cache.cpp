@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cpu6502/block_cache.hpp>
+
+BlockCache::BlockCache(CPU &processor) : cpu(processor), entries(MAX_MEM, 0) { cpu.mem.SetCodeWriteListener(this); }
+
+BlockCache::~BlockCache() { cpu.mem.RemoveCodeWriteListener(this); }
+
+u32 BlockCache::Decode(const Word pc) {
+    if (ops.size() >= MAX_DECODED_OPS)
+        Flush();
+
+    const Memory &mem = cpu.mem;
+    const auto first = static_cast<u32>(ops.size());
+    const Byte page = static_cast<Byte>(pc >> 8);
+    Word addr = pc;
+    do {
+        const Byte opcode = mem.PeekByte(addr);
+        const Byte operand_size = CPU::OperandSizes[opcode];
+        const auto operand_addr = static_cast<Word>(addr + 1);
+        Word operand = 0;
+        if (operand_size == 2)
+            operand = mem.PeekWord(operand_addr);
+        else if (operand_size == 1)
+            operand = mem.PeekByte(operand_addr);
+        // Operand fetches cost one cycle per byte, like the opcode fetch itself.
+        const auto size = static_cast<Byte>(operand_size + 1);
+        ops.push_back({operand, opcode, size, size});
+        addr = static_cast<Word>(addr + size);
+        // BRK and RTI leave straight-line flow
+        if (opcode == 0x00 || opcode == 0x40)
+            break;
+    } while ((addr >> 8) == page);
+
+    cpu.mem.MarkCodePage(page);
+    cpu.mem.MarkCodePage(static_cast<Byte>((addr - 1) >> 8));
+
+    blocks.push_back({first, static_cast<u32>(ops.size()) - first});
+    entries[pc] = static_cast<u32>(blocks.size());
+    return entries[pc];
+}
+
+void BlockCache::Execute(const u32 exec_cycles) {
+    const u32 start = cpu.cycles;
+    const u32 target_cycles = start + exec_cycles;
+    while (cpu.cycles - start < exec_cycles) {
+        if (cpu.WorkPending()) {
+            if (!cpu.ServicePending())
+                return;
+            continue;
+        }
+        // Code read from a device can change under the same address, so it is never cached. The instruction after
+        // a CLI that delays a held IRQ runs alone so the IRQ is taken right after it.
+        const Byte page = static_cast<Byte>(cpu.PC >> 8);
+        if (cpu.mem.IsDevicePage(page) || cpu.mem.IsDevicePage(static_cast<Byte>(page + 1)) || cpu.IrqDelayed()) {
+            cpu.Execute(1);
+            continue;
+        }
+        u32 entry = entries[cpu.PC];
+        if (entry == 0)
+            entry = Decode(cpu.PC);
+        const Block &block = blocks[entry - 1];
+        const DecodedOp *const first = &ops[block.first];
+        invalidated = false;
+        cpu.ExecuteDecoded(first, first + block.count, target_cycles, invalidated);
+    }
+    if (cpu.debug_stop)
+        cpu.ConfirmWatch();
+}
+
+void BlockCache::Flush() {
+    ops.clear();
+    blocks.clear();
+    std::fill(entries.begin(), entries.end(), 0);
+    invalidated = true;
+}
+
+void BlockCache::OnCodeWrite(const Byte page) {
+    // Blocks that start on the previous page may run into this one.
+    const u32 begin = static_cast<Byte>(page - 1) * PAGE_BYTES;
+    std::fill_n(entries.begin() + begin, PAGE_BYTES, 0);
+    std::fill_n(entries.begin() + page * PAGE_BYTES, PAGE_BYTES, 0);
+    invalidated = true;
+}
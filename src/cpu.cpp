@@ -1,11 +1,29 @@
+#include <cpu6502/config.hpp>
 #include <cpu6502/cpu.hpp>
+#include <cpu6502/debugger.hpp>
+#include <cpu6502/opcodes.hpp>
+#include <cpu6502/profiler.hpp>
 #include <cstdlib>
 
+#if CPU6502_DISPATCH_THREADED && defined(__GNUC__)
+#define CPU6502_COMPUTED_GOTO 1
+#else
+#define CPU6502_COMPUTED_GOTO 0
+#endif
+
+#if defined(__GNUC__)
+#define CPU6502_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define CPU6502_NOINLINE __declspec(noinline)
+#else
+#define CPU6502_NOINLINE
+#endif
+
 namespace {
 Word MakeWord(const Byte lo, const Byte hi) { return static_cast<Word>((static_cast<Word>(hi) << 8) | lo); }
 } // namespace
 
-CPU::CPU(Memory &memory) : mem(memory) {
+template <typename Policy> BasicCPU<Policy>::BasicCPU(Memory &memory) : mem(memory) {
     PC = 0x0000;
     SP = 0x0000;
     A = 0x00;
@@ -13,17 +31,16 @@ CPU::CPU(Memory &memory) : mem(memory) {
     Y = 0x00;
     cycles = 0;
     PS.C = 0;
-    PS.Z = 0;
     PS.I = 0;
     PS.D = 0;
     PS.B = 0;
     // Unused bit is hardwired to 1
     PS.U = 1;
     PS.V = 0;
-    PS.N = 0;
+    SetNZ(0x01);
 }
 
-void CPU::Reset() {
+template <typename Policy> void BasicCPU<Policy>::Reset() {
     // Set SP to 0xFD
     SP = 0x00FD;
     // Set status flags (I flag is set on reset)
@@ -31,250 +48,648 @@ void CPU::Reset() {
     PS.U = 1;
     // Other flags can remain undefined
     PS.C = 0;
-    PS.Z = 0;
     PS.D = 0;
     PS.B = 0;
     PS.V = 0;
-    PS.N = 0;
+    SetNZ(0x01);
+    nmi_pending = false;
+    stop_requested = false;
+    debug_stop = false;
+    irq_delayed = false;
     // Read the reset vector from 0xFFFC and 0xFFFD
     const Byte lo = mem.ReadByte(0xFFFC);
     const Byte hi = mem.ReadByte(0xFFFD);
     PC = MakeWord(lo, hi);
     // Reset takes 6 cycles on real 6502
-    cycles = 6;
+    cycles = Policy::COUNT_CYCLES ? 6 : 0;
+}
+
+template <typename Policy> Byte BasicCPU<Policy>::StatusRegister() const {
+    return static_cast<Byte>(PS.C | (z_result == 0) << 1 | PS.I << 2 | PS.D << 3 | PS.B << 4 | PS.U << 5 | PS.V << 6 |
+                             (n_result & 0x80));
+}
+
+template <typename Policy> void BasicCPU<Policy>::SetStatusRegister(const Byte P) {
+    PS.C = (P & 0x01) != 0;
+    PS.I = (P & 0x04) != 0;
+    PS.D = (P & 0x08) != 0;
+    PS.B = (P & 0x10) != 0;
+    PS.U = (P & 0x20) != 0;
+    PS.V = (P & 0x40) != 0;
+    z_result = (P & 0x02) != 0 ? 0 : 1;
+    n_result = P & 0x80;
+}
+
+template <typename Policy> void BasicCPU<Policy>::SetNZ(const Byte result) {
+    z_result = result;
+    n_result = result;
+}
+
+template <typename Policy> void BasicCPU<Policy>::Tick(const u32 count) {
+    if constexpr (Policy::COUNT_CYCLES)
+        cycles += count;
+}
+
+// Taken by indexed reads whose effective address crosses a page.
+template <typename Policy> void BasicCPU<Policy>::PageCrossed() {
+    Tick(1);
+    if constexpr (Policy::PROFILE) {
+        if (profiler)
+            profiler->PageCrossed();
+    }
+}
+
+template <typename Policy> void BasicCPU<Policy>::UnknownOpcode() {
+    if constexpr (Policy::UNKNOWN_OPCODES == UnknownOpcodeMode::Abort) {
+        std::abort();
+    } else if constexpr (Policy::UNKNOWN_OPCODES == UnknownOpcodeMode::AbortInDebug) {
+#if !defined(NDEBUG) && !defined(FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION)
+        std::abort();
+#endif
+    }
+}
+
+template <typename Policy> bool BasicCPU<Policy>::WorkPending() const {
+    return nmi_pending || (irq_line && !PS.I && !IrqDelayed()) || stop_requested || debug_stop;
+}
+
+template <typename Policy> void BasicCPU<Policy>::RaisePending() {
+    if (WorkPending())
+        budget = 0;
+}
+
+template <typename Policy> void BasicCPU<Policy>::SetIRQ(const bool asserted) {
+    irq_line = asserted;
+    RaisePending();
+}
+
+template <typename Policy> void BasicCPU<Policy>::TriggerNMI() {
+    nmi_pending = true;
+    RaisePending();
+}
+
+template <typename Policy> void BasicCPU<Policy>::RequestStop() {
+    stop_requested = true;
+    RaisePending();
+}
+
+template <typename Policy> bool BasicCPU<Policy>::ConfirmWatch() {
+    // A watched access whose conditions fail, or made while the debugger is detached for a rewind replay, lets the
+    // run go on.
+    debug_stop = false;
+    return debugger && debugger->ConfirmStop(Registers());
+}
+
+template <typename Policy> bool BasicCPU<Policy>::ServicePending() {
+    if (debug_stop && ConfirmWatch())
+        stop_requested = true;
+    if (stop_requested) {
+        stop_requested = false;
+        return false;
+    }
+    // Two internal cycles, then the same pushes and vector fetch as BRK without the B flag.
+    if (nmi_pending) {
+        nmi_pending = false;
+        Tick(2);
+        Interrupt(0xFFFA, 0x00);
+    } else if (irq_line && !PS.I && !IrqDelayed()) {
+        Tick(2);
+        Interrupt(0xFFFE, 0x00);
+    }
+    return true;
+}
+
+template <typename Policy> void BasicCPU<Policy>::Interrupt(const Word vector, const Byte break_flag) {
+    PushByteAndTick(static_cast<Byte>(PC >> 8));
+    PushByteAndTick(static_cast<Byte>(PC));
+    PushByteAndTick(static_cast<Byte>((StatusRegister() & 0xEF) | 0x20 | break_flag));
+    PS.I = 1;
+    const Byte lo = ReadByteAndTick(vector);
+    const Byte hi = ReadByteAndTick(static_cast<Word>(vector + 1));
+    PC = MakeWord(lo, hi);
+}
+
+// Kept out of line so that a tracing core without an observer only pays for the null check.
+template <typename Policy> CPU6502_NOINLINE void BasicCPU<Policy>::Trace(const Byte opcode, const Word operand) {
+    const u32 fetched = 1 + OperandSizes[opcode];
+    const auto pc = static_cast<Word>(PC - fetched);
+    const u32 start = cycles - (Policy::COUNT_CYCLES ? fetched : 1);
+    observer->OnInstruction({pc, operand, opcode, static_cast<Byte>(fetched), A, X, Y, static_cast<Byte>(SP),
+                             StatusRegister(), start});
+}
+
+template <typename Policy> void BasicCPU<Policy>::SetObserver(InstructionObserver *Observer) { observer = Observer; }
+
+template <typename Policy> void BasicCPU<Policy>::SetProfiler(Profiler *Counters) { profiler = Counters; }
+
+template <typename Policy> void BasicCPU<Policy>::SetDebugger(Debugger *Breakpoints) {
+    debugger = Breakpoints;
+    debug_stop = false;
+    if (debugger) {
+        debugger->Attach(this, [](void *cpu) {
+            auto *self = static_cast<BasicCPU *>(cpu);
+            self->debug_stop = true;
+            self->budget = 0;
+        });
+    }
 }
 
-Byte CPU::FetchByte() {
+template <typename Policy> DebugRegisters BasicCPU<Policy>::Registers() const {
+    return {PC, A, X, Y, static_cast<Byte>(SP), StatusRegister(), cycles};
+}
+
+template <typename Policy> bool BasicCPU<Policy>::AtBreakpoint() {
+    if (!debugger || !debugger->IsBreakpoint(PC) || !debugger->StopAtBreakpoint(Registers()))
+        return false;
+    RequestStop();
+    return true;
+}
+
+// The opcode fetch is the one cycle every instruction takes, so without cycle accounting it counts instructions.
+template <typename Policy> Byte BasicCPU<Policy>::FetchOpcode() {
     const Byte data = mem.ReadByte(PC);
     PC++;
     cycles++;
     return data;
 }
 
-Word CPU::FetchWord() {
+template <typename Policy> Byte BasicCPU<Policy>::FetchByte() {
+    const Byte data = mem.ReadByte(PC);
+    PC++;
+    Tick(1);
+    return data;
+}
+
+template <typename Policy> Word BasicCPU<Policy>::FetchWord() {
     const Word data = mem.ReadWord(PC);
     PC += 2;
-    cycles += 2;
+    Tick(2);
     return data;
 }
 
-void CPU::LDA(const Byte operand) {
+template <typename Policy> void BasicCPU<Policy>::LDA(const Byte operand) {
     A = operand;
-    PS.Z = (A == 0);
-    PS.N = (A & 0x80) != 0;
+    SetNZ(A);
 }
 
-void CPU::LDX(const Byte operand) {
+template <typename Policy> void BasicCPU<Policy>::LDX(const Byte operand) {
     X = operand;
-    PS.Z = (X == 0);
-    PS.N = (X & 0x80) != 0;
+    SetNZ(X);
 }
 
-void CPU::LDY(const Byte operand) {
+template <typename Policy> void BasicCPU<Policy>::LDY(const Byte operand) {
     Y = operand;
-    PS.Z = (Y == 0);
-    PS.N = (Y & 0x80) != 0;
+    SetNZ(Y);
 }
 
-Byte CPU::ReadByteAndTick(const Word addr) {
+// BRK skips the byte after its opcode, so the handler returns past it.
+template <typename Policy> void BasicCPU<Policy>::BRK() {
+    PC++;
+    Tick(1);
+    Interrupt(0xFFFE, 0x10);
+}
+
+template <typename Policy> void BasicCPU<Policy>::RTI() {
+    Tick(2);
+    // B and the unused bit are not stored in the status register.
+    const Byte P = PullByteAndTick();
+    SetStatusRegister(static_cast<Byte>((P & 0xCF) | (StatusRegister() & 0x30)));
+    const Byte lo = PullByteAndTick();
+    const Byte hi = PullByteAndTick();
+    PC = MakeWord(lo, hi);
+    RaisePending();
+}
+
+// A held IRQ is taken after the instruction that follows CLI, so CLI; SEI does not let it in. Ending the dispatch
+// loop here lets Execute run that instruction alone.
+template <typename Policy> void BasicCPU<Policy>::CLI() {
+    PS.I = 0;
+    if (irq_line) {
+        irq_delayed = true;
+        cli_cycles = cycles;
+        budget = 0;
+    }
+}
+
+template <typename Policy> void BasicCPU<Policy>::SEI() { PS.I = 1; }
+
+template <typename Policy> void BasicCPU<Policy>::PushByteAndTick(const Byte value) {
+    WriteByteAndTick(static_cast<Word>(0x0100 | (SP & 0xFF)), value);
+    SP = static_cast<Byte>(SP - 1);
+}
+
+template <typename Policy> Byte BasicCPU<Policy>::PullByteAndTick() {
+    SP = static_cast<Byte>(SP + 1);
+    return ReadByteAndTick(static_cast<Word>(0x0100 | SP));
+}
+
+template <typename Policy> Byte BasicCPU<Policy>::ReadByteAndTick(const Word addr) {
     const Byte value = mem.ReadByte(addr);
-    cycles += 1;
+    Tick(1);
     return value;
 }
 
-void CPU::WriteByteAndTick(const Word addr, const Byte value) {
+template <typename Policy> void BasicCPU<Policy>::WriteByteAndTick(const Word addr, const Byte value) {
     mem.WriteByte(addr, value);
-    cycles += 1;
+    Tick(1);
 }
 
-Word CPU::AddrZeroPage() { return FetchByte(); }
-
-Word CPU::AddrAbsolute() { return FetchWord(); }
-
-Word CPU::AddrZeroPageX() {
-    const Byte base = FetchByte();
+template <typename Policy> Word BasicCPU<Policy>::AddrZeroPageX(const Byte base) {
     const Word addr = static_cast<Byte>(base + X);
-    cycles += 1;
+    Tick(1);
     return addr;
 }
 
-Word CPU::AddrZeroPageY() {
-    const Byte base = FetchByte();
+template <typename Policy> Word BasicCPU<Policy>::AddrZeroPageY(const Byte base) {
     const Word addr = static_cast<Byte>(base + Y);
-    cycles += 1;
+    Tick(1);
     return addr;
 }
 
-Word CPU::AddrAbsoluteX() {
-    const Word base = FetchWord();
+template <typename Policy> Word BasicCPU<Policy>::AddrAbsoluteX(const Word base) {
     const Word addr = static_cast<Word>(base + X);
     if ((base & 0xFF00) != (addr & 0xFF00))
-        cycles += 1;
+        PageCrossed();
     return addr;
 }
 
-Word CPU::AddrAbsoluteXStore() {
-    const Word base = FetchWord();
+template <typename Policy> Word BasicCPU<Policy>::AddrAbsoluteXStore(const Word base) {
     const Word addr = static_cast<Word>(base + X);
-    cycles += 1;
+    Tick(1);
     return addr;
 }
 
-Word CPU::AddrIndexedIndirectX() {
-    const Byte zp = static_cast<Byte>(FetchByte() + X);
-    cycles += 1;
+template <typename Policy> Word BasicCPU<Policy>::AddrIndexedIndirectX(const Byte base) {
+    const Byte zp = static_cast<Byte>(base + X);
+    Tick(1);
     const Byte lo = ReadByteAndTick(zp);
     const Byte hi = ReadByteAndTick(static_cast<Byte>(zp + 1));
     return MakeWord(lo, hi);
 }
 
-Word CPU::AddrAbsoluteY() {
-    const Word base = FetchWord();
+template <typename Policy> Word BasicCPU<Policy>::AddrAbsoluteY(const Word base) {
     const Word addr = static_cast<Word>(base + Y);
     if ((base & 0xFF00) != (addr & 0xFF00))
-        cycles += 1;
+        PageCrossed();
     return addr;
 }
 
-Word CPU::AddrAbsoluteYStore() {
-    const Word base = FetchWord();
+template <typename Policy> Word BasicCPU<Policy>::AddrAbsoluteYStore(const Word base) {
     const Word addr = static_cast<Word>(base + Y);
-    cycles += 1;
+    Tick(1);
     return addr;
 }
 
-Word CPU::AddrIndirectIndexedY() {
-    const Byte zp = FetchByte();
+template <typename Policy> Word BasicCPU<Policy>::AddrIndirectIndexedY(const Byte zp) {
     const Byte lo = ReadByteAndTick(zp);
     const Byte hi = ReadByteAndTick(static_cast<Byte>(zp + 1));
     const Word base = MakeWord(lo, hi);
     const Word addr = static_cast<Word>(base + Y);
     if ((base & 0xFF00) != (addr & 0xFF00))
-        cycles += 1;
+        PageCrossed();
     return addr;
 }
 
-Word CPU::AddrIndirectIndexedYStore() {
-    const Byte zp = FetchByte();
+template <typename Policy> Word BasicCPU<Policy>::AddrIndirectIndexedYStore(const Byte zp) {
     const Byte lo = ReadByteAndTick(zp);
     const Byte hi = ReadByteAndTick(static_cast<Byte>(zp + 1));
     const Word base = MakeWord(lo, hi);
     const Word addr = static_cast<Word>(base + Y);
-    cycles += 1;
+    Tick(1);
     return addr;
 }
 
-void CPU::Execute(const u32 exec_cycles) {
-    const u32 target_cycles = cycles + exec_cycles;
-    while (cycles < target_cycles) {
-        // ReSharper disable once CppTooWideScope
-        const Byte opcode = FetchByte();
-        switch (opcode) {
-        case 0x00:       // BRK (stub)
-            cycles += 6; // total 7 including opcode fetch
-            break;
-        case 0xA9:            // LDA #imm
-            LDA(FetchByte()); // total 2 cycles
-            break;
-        case 0xA5: // LDA zp
-            LDA(ReadByteAndTick(AddrZeroPage()));
-            break;
-        case 0xAD: // LDA abs
-            LDA(ReadByteAndTick(AddrAbsolute()));
-            break;
-        case 0xB5: // LDA zp,X
-            LDA(ReadByteAndTick(AddrZeroPageX()));
-            break;
-        case 0xBD: // LDA abs,X
-            LDA(ReadByteAndTick(AddrAbsoluteX()));
-            break;
-        case 0xA1: // LDA (ind,X)
-            LDA(ReadByteAndTick(AddrIndexedIndirectX()));
-            break;
-        case 0xB9: // LDA abs,Y
-            LDA(ReadByteAndTick(AddrAbsoluteY()));
-            break;
-        case 0xB1: // LDA (ind),Y
-            LDA(ReadByteAndTick(AddrIndirectIndexedY()));
-            break;
-        case 0xA2:            // LDX #imm
-            LDX(FetchByte()); // total 2 cycles
-            break;
-        case 0xA6: // LDX zp
-            LDX(ReadByteAndTick(AddrZeroPage()));
-            break;
-        case 0xAE: // LDX abs
-            LDX(ReadByteAndTick(AddrAbsolute()));
-            break;
-        case 0xB6: // LDX zp,Y
-            LDX(ReadByteAndTick(AddrZeroPageY()));
-            break;
-        case 0xBE: // LDX abs,Y
-            LDX(ReadByteAndTick(AddrAbsoluteY()));
-            break;
-        case 0xA0:            // LDY #imm
-            LDY(FetchByte()); // total 2 cycles
-            break;
-        case 0xA4: // LDY zp
-            LDY(ReadByteAndTick(AddrZeroPage()));
-            break;
-        case 0xAC: // LDY abs
-            LDY(ReadByteAndTick(AddrAbsolute()));
-            break;
-        case 0xB4: // LDY zp,X
-            LDY(ReadByteAndTick(AddrZeroPageX()));
-            break;
-        case 0xBC: // LDY abs,X
-            LDY(ReadByteAndTick(AddrAbsoluteX()));
-            break;
-        case 0x85: // STA zp
-            WriteByteAndTick(AddrZeroPage(), A);
-            break;
-        case 0x8D: // STA abs
-            WriteByteAndTick(AddrAbsolute(), A);
-            break;
-        case 0x95: // STA zp,X
-            WriteByteAndTick(AddrZeroPageX(), A);
-            break;
-        case 0x9D: // STA abs,X
-            WriteByteAndTick(AddrAbsoluteXStore(), A);
-            break;
-        case 0x99: // STA abs,Y
-            WriteByteAndTick(AddrAbsoluteYStore(), A);
-            break;
-        case 0x81: // STA (ind,X)
-            WriteByteAndTick(AddrIndexedIndirectX(), A);
-            break;
-        case 0x91: // STA (ind),Y
-            WriteByteAndTick(AddrIndirectIndexedYStore(), A);
-            break;
-        case 0x86: // STX zp
-            WriteByteAndTick(AddrZeroPage(), X);
-            break;
-        case 0x8E: // STX abs
-            WriteByteAndTick(AddrAbsolute(), X);
-            break;
-        case 0x96: // STX zp,Y
-            WriteByteAndTick(AddrZeroPageY(), X);
-            break;
-        case 0x84: // STY zp
-            WriteByteAndTick(AddrZeroPage(), Y);
-            break;
-        case 0x8C: // STY abs
-            WriteByteAndTick(AddrAbsolute(), Y);
-            break;
-        case 0x94: // STY zp,X
-            WriteByteAndTick(AddrZeroPageX(), Y);
-            break;
-        case 0xEA:       // NOP
-            cycles += 1; // total 2 cycles
-            break;
-        default:
-#ifndef NDEBUG
-            std::abort();
+#define CPU6502_OPCODE_ROW(X, hi)                                                                                      \
+    X(hi##0) X(hi##1) X(hi##2) X(hi##3) X(hi##4) X(hi##5) X(hi##6) X(hi##7) X(hi##8) X(hi##9) X(hi##A) X(hi##B)        \
+        X(hi##C) X(hi##D) X(hi##E) X(hi##F)
+
+#define CPU6502_FOR_EACH_OPCODE(X)                                                                                     \
+    CPU6502_OPCODE_ROW(X, 0x0)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0x1)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0x2)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0x3)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0x4)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0x5)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0x6)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0x7)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0x8)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0x9)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0xA)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0xB)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0xC)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0xD)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0xE)                                                                                         \
+    CPU6502_OPCODE_ROW(X, 0xF)
+
+namespace {
+// Cycles an implied-mode instruction spends after its opcode fetch.
+constexpr u32 IdleCycles(const Byte opcode) { return OPCODES[opcode].cycles - OPCODES[opcode].length; }
+
+Byte Lo(const Word operand) { return static_cast<Byte>(operand); }
+} // namespace
+
+// Opcodes without a specialization below are not implemented yet.
+template <Byte Code> struct Instruction {
+    static constexpr bool IMPLEMENTED = false;
+    template <typename Core> static void Run(Core &cpu, Word) { cpu.UnknownOpcode(); }
+};
+
+// Specializes Instruction for one opcode; the statement runs with the CPU as cpu and the fetched operand as operand.
+#define CPU6502_INSTRUCTION(code, ...)                                                                                 \
+    template <> struct Instruction<code> {                                                                             \
+        static constexpr bool IMPLEMENTED = true;                                                                      \
+        template <typename Core> static void Run([[maybe_unused]] Core &cpu, [[maybe_unused]] const Word operand) {    \
+            __VA_ARGS__;                                                                                               \
+        }                                                                                                              \
+    };
+
+// BRK, total 7 cycles including opcode fetch
+CPU6502_INSTRUCTION(0x00, cpu.BRK())
+
+// RTI, total 6 cycles
+CPU6502_INSTRUCTION(0x40, cpu.RTI())
+
+// CLI, total 2 cycles
+CPU6502_INSTRUCTION(0x58, cpu.Tick(IdleCycles(0x58)), cpu.CLI())
+
+// SEI, total 2 cycles
+CPU6502_INSTRUCTION(0x78, cpu.Tick(IdleCycles(0x78)), cpu.SEI())
+
+// LDA #imm, total 2 cycles
+CPU6502_INSTRUCTION(0xA9, cpu.LDA(Lo(operand)))
+
+// LDA zp
+CPU6502_INSTRUCTION(0xA5, cpu.LDA(cpu.ReadByteAndTick(operand)))
+
+// LDA abs
+CPU6502_INSTRUCTION(0xAD, cpu.LDA(cpu.ReadByteAndTick(operand)))
+
+// LDA zp,X
+CPU6502_INSTRUCTION(0xB5, cpu.LDA(cpu.ReadByteAndTick(cpu.AddrZeroPageX(Lo(operand)))))
+
+// LDA abs,X
+CPU6502_INSTRUCTION(0xBD, cpu.LDA(cpu.ReadByteAndTick(cpu.AddrAbsoluteX(operand))))
+
+// LDA (ind,X)
+CPU6502_INSTRUCTION(0xA1, cpu.LDA(cpu.ReadByteAndTick(cpu.AddrIndexedIndirectX(Lo(operand)))))
+
+// LDA abs,Y
+CPU6502_INSTRUCTION(0xB9, cpu.LDA(cpu.ReadByteAndTick(cpu.AddrAbsoluteY(operand))))
+
+// LDA (ind),Y
+CPU6502_INSTRUCTION(0xB1, cpu.LDA(cpu.ReadByteAndTick(cpu.AddrIndirectIndexedY(Lo(operand)))))
+
+// LDX #imm, total 2 cycles
+CPU6502_INSTRUCTION(0xA2, cpu.LDX(Lo(operand)))
+
+// LDX zp
+CPU6502_INSTRUCTION(0xA6, cpu.LDX(cpu.ReadByteAndTick(operand)))
+
+// LDX abs
+CPU6502_INSTRUCTION(0xAE, cpu.LDX(cpu.ReadByteAndTick(operand)))
+
+// LDX zp,Y
+CPU6502_INSTRUCTION(0xB6, cpu.LDX(cpu.ReadByteAndTick(cpu.AddrZeroPageY(Lo(operand)))))
+
+// LDX abs,Y
+CPU6502_INSTRUCTION(0xBE, cpu.LDX(cpu.ReadByteAndTick(cpu.AddrAbsoluteY(operand))))
+
+// LDY #imm, total 2 cycles
+CPU6502_INSTRUCTION(0xA0, cpu.LDY(Lo(operand)))
+
+// LDY zp
+CPU6502_INSTRUCTION(0xA4, cpu.LDY(cpu.ReadByteAndTick(operand)))
+
+// LDY abs
+CPU6502_INSTRUCTION(0xAC, cpu.LDY(cpu.ReadByteAndTick(operand)))
+
+// LDY zp,X
+CPU6502_INSTRUCTION(0xB4, cpu.LDY(cpu.ReadByteAndTick(cpu.AddrZeroPageX(Lo(operand)))))
+
+// LDY abs,X
+CPU6502_INSTRUCTION(0xBC, cpu.LDY(cpu.ReadByteAndTick(cpu.AddrAbsoluteX(operand))))
+
+// STA zp
+CPU6502_INSTRUCTION(0x85, cpu.WriteByteAndTick(operand, cpu.A))
+
+// STA abs
+CPU6502_INSTRUCTION(0x8D, cpu.WriteByteAndTick(operand, cpu.A))
+
+// STA zp,X
+CPU6502_INSTRUCTION(0x95, cpu.WriteByteAndTick(cpu.AddrZeroPageX(Lo(operand)), cpu.A))
+
+// STA abs,X
+CPU6502_INSTRUCTION(0x9D, cpu.WriteByteAndTick(cpu.AddrAbsoluteXStore(operand), cpu.A))
+
+// STA abs,Y
+CPU6502_INSTRUCTION(0x99, cpu.WriteByteAndTick(cpu.AddrAbsoluteYStore(operand), cpu.A))
+
+// STA (ind,X)
+CPU6502_INSTRUCTION(0x81, cpu.WriteByteAndTick(cpu.AddrIndexedIndirectX(Lo(operand)), cpu.A))
+
+// STA (ind),Y
+CPU6502_INSTRUCTION(0x91, cpu.WriteByteAndTick(cpu.AddrIndirectIndexedYStore(Lo(operand)), cpu.A))
+
+// STX zp
+CPU6502_INSTRUCTION(0x86, cpu.WriteByteAndTick(operand, cpu.X))
+
+// STX abs
+CPU6502_INSTRUCTION(0x8E, cpu.WriteByteAndTick(operand, cpu.X))
+
+// STX zp,Y
+CPU6502_INSTRUCTION(0x96, cpu.WriteByteAndTick(cpu.AddrZeroPageY(Lo(operand)), cpu.X))
+
+// STY zp
+CPU6502_INSTRUCTION(0x84, cpu.WriteByteAndTick(operand, cpu.Y))
+
+// STY abs
+CPU6502_INSTRUCTION(0x8C, cpu.WriteByteAndTick(operand, cpu.Y))
+
+// STY zp,X
+CPU6502_INSTRUCTION(0x94, cpu.WriteByteAndTick(cpu.AddrZeroPageX(Lo(operand)), cpu.Y))
+
+// NOP, total 2 cycles
+CPU6502_INSTRUCTION(0xEA, cpu.Tick(IdleCycles(0xEA)))
+
+#undef CPU6502_INSTRUCTION
+
+namespace {
+// Operand bytes the core fetches for an opcode; unimplemented opcodes take none.
+template <Byte Code> constexpr Byte OperandBytes() {
+    return Instruction<Code>::IMPLEMENTED ? static_cast<Byte>(OPCODES[Code].length - 1) : 0;
+}
+
+#define CPU6502_IMPLEMENTED(code) Instruction<code>::IMPLEMENTED,
+constexpr bool IMPLEMENTED_OPCODES[256] = {CPU6502_FOR_EACH_OPCODE(CPU6502_IMPLEMENTED)};
+#undef CPU6502_IMPLEMENTED
+} // namespace
+
+bool IsImplemented(const Byte opcode) { return IMPLEMENTED_OPCODES[opcode]; }
+
+template <typename Policy> template <Byte Opcode, bool Traced> void BasicCPU<Policy>::Op(const Word operand) {
+    if constexpr (Traced && Policy::TRACE) {
+        if (observer)
+            Trace(Opcode, operand);
+    }
+    if constexpr (Traced && Policy::PROFILE) {
+        if (profiler) {
+            const u32 fetched = 1 + OperandBytes<Opcode>();
+            const auto pc = static_cast<Word>(PC - fetched);
+            const u32 start = cycles - (Policy::COUNT_CYCLES ? fetched : 1);
+            Instruction<Opcode>::Run(*this, operand);
+            profiler->Executed(pc, Opcode, cycles - start);
+            return;
+        }
+    }
+    Instruction<Opcode>::Run(*this, operand);
+}
+
+template <typename Policy> template <Byte Opcode, bool Traced> void BasicCPU<Policy>::Step() {
+    if constexpr (OperandBytes<Opcode>() == 2)
+        Op<Opcode, Traced>(FetchWord());
+    else if constexpr (OperandBytes<Opcode>() == 1)
+        Op<Opcode, Traced>(FetchByte());
+    else
+        Op<Opcode, Traced>(0);
+}
+
+#define CPU6502_OPERAND_SIZE(code) OperandBytes<code>(),
+template <typename Policy>
+const Byte BasicCPU<Policy>::OperandSizes[256] = {CPU6502_FOR_EACH_OPCODE(CPU6502_OPERAND_SIZE)};
+#undef CPU6502_OPERAND_SIZE
+
+// The observer, profiler and debugger are checked once per call, so a core without any of them runs the same loop
+// as a plain core.
+template <typename Policy> void BasicCPU<Policy>::Execute(const u32 exec_cycles) {
+    // Watched accesses the host made since the last run do not stop this one.
+    if (debugger) {
+        debug_stop = false;
+        debugger->Resume(PC, cycles);
+    }
+    const u32 start = cycles;
+    while (cycles - start < exec_cycles) {
+        if (WorkPending()) {
+            if (!ServicePending())
+                return;
+            continue;
+        }
+        budget = exec_cycles - (cycles - start);
+        if (irq_delayed) {
+            irq_delayed = IrqDelayed();
+            if (irq_delayed)
+                budget = 1;
+        }
+        if (debugger) {
+            Dispatch<true>();
+            continue;
+        }
+        if constexpr (OBSERVED) {
+            if (observer || profiler) {
+                Dispatch<true>();
+                continue;
+            }
+        }
+        Dispatch<false>();
+    }
+    // A watched access by the last instruction is confirmed now, as the next call starts with a fresh stop.
+    if (debug_stop)
+        ConfirmWatch();
+}
+
+template <typename Policy> template <bool Traced> void BasicCPU<Policy>::Dispatch() {
+    // Compared as cycles run so far, so the counter may wrap during the call.
+    const u32 start = cycles;
+#if CPU6502_COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#define CPU6502_LABEL_ADDRESS(code) &&op_##code,
+    static void *const labels[256] = {CPU6502_FOR_EACH_OPCODE(CPU6502_LABEL_ADDRESS)};
+#undef CPU6502_LABEL_ADDRESS
+#define CPU6502_DISPATCH_NEXT()                                                                                        \
+    if (cycles - start >= budget || (Traced && AtBreakpoint()))                                                        \
+        return;                                                                                                        \
+    goto *labels[FetchOpcode()]
+    CPU6502_DISPATCH_NEXT();
+#define CPU6502_THREADED_OP(code)                                                                                      \
+    op_##code : Step<code, Traced>();                                                                                  \
+    CPU6502_DISPATCH_NEXT();
+    CPU6502_FOR_EACH_OPCODE(CPU6502_THREADED_OP)
+#undef CPU6502_THREADED_OP
+#undef CPU6502_DISPATCH_NEXT
+#pragma GCC diagnostic pop
+#elif CPU6502_DISPATCH_TABLE || CPU6502_DISPATCH_THREADED
+    using Handler = void (BasicCPU::*)();
+#define CPU6502_HANDLER(code) &BasicCPU::Step<code, Traced>,
+    static constexpr Handler handlers[256] = {CPU6502_FOR_EACH_OPCODE(CPU6502_HANDLER)};
+#undef CPU6502_HANDLER
+    while (cycles - start < budget && !(Traced && AtBreakpoint()))
+        (this->*handlers[FetchOpcode()])();
 #else
-            break;
-#endif
+    while (cycles - start < budget && !(Traced && AtBreakpoint())) {
+        switch (FetchOpcode()) {
+#define CPU6502_SWITCH_CASE(code)                                                                                      \
+    case code:                                                                                                         \
+        Step<code, Traced>();                                                                                          \
+        break;
+            CPU6502_FOR_EACH_OPCODE(CPU6502_SWITCH_CASE)
+#undef CPU6502_SWITCH_CASE
         }
     }
+#endif
 }
+
+template <typename Policy>
+void BasicCPU<Policy>::ExecuteDecoded(const DecodedOp *op, const DecodedOp *const end, const u32 target_cycles,
+                                      const bool &stop) {
+    const u32 start = cycles;
+    budget = target_cycles - start;
+#if CPU6502_COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#define CPU6502_LABEL_ADDRESS(code) &&decoded_##code,
+    static void *const labels[256] = {CPU6502_FOR_EACH_OPCODE(CPU6502_LABEL_ADDRESS)};
+#undef CPU6502_LABEL_ADDRESS
+#define CPU6502_DISPATCH_DECODED()                                                                                     \
+    PC = static_cast<Word>(PC + op->size);                                                                             \
+    cycles += Policy::COUNT_CYCLES ? op->cycles : 1;                                                                   \
+    goto *labels[op->opcode]
+    CPU6502_DISPATCH_DECODED();
+#define CPU6502_THREADED_OP(code)                                                                                      \
+    decoded_##code : Op<code, OBSERVED>(op->operand);                                                                  \
+    if (++op == end || cycles - start >= budget || stop)                                                               \
+        return;                                                                                                        \
+    CPU6502_DISPATCH_DECODED();
+    CPU6502_FOR_EACH_OPCODE(CPU6502_THREADED_OP)
+#undef CPU6502_THREADED_OP
+#undef CPU6502_DISPATCH_DECODED
+#pragma GCC diagnostic pop
+#else
+#if CPU6502_DISPATCH_TABLE || CPU6502_DISPATCH_THREADED
+    using Handler = void (BasicCPU::*)(Word);
+#define CPU6502_HANDLER(code) &BasicCPU::Op<code, OBSERVED>,
+    static constexpr Handler handlers[256] = {CPU6502_FOR_EACH_OPCODE(CPU6502_HANDLER)};
+#undef CPU6502_HANDLER
+#endif
+    do {
+        PC = static_cast<Word>(PC + op->size);
+        cycles += Policy::COUNT_CYCLES ? op->cycles : 1;
+#if CPU6502_DISPATCH_TABLE || CPU6502_DISPATCH_THREADED
+        (this->*handlers[op->opcode])(op->operand);
+#else
+        switch (op->opcode) {
+#define CPU6502_SWITCH_CASE(code)                                                                                      \
+    case code:                                                                                                         \
+        Op<code, OBSERVED>(op->operand);                                                                               \
+        break;
+            CPU6502_FOR_EACH_OPCODE(CPU6502_SWITCH_CASE)
+#undef CPU6502_SWITCH_CASE
+        }
+#endif
+    } while (++op != end && cycles - start < budget && !stop);
+#endif
+}
+
+template class BasicCPU<CycleAccuratePolicy>;
+template class BasicCPU<FunctionalPolicy>;
+template class BasicCPU<TracingPolicy>;
+template class BasicCPU<ProfilingPolicy>;
@@ -0,0 +1,182 @@
+#include <cpu6502/debugger.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+bool Compare(const u32 operand, const DebugCompare compare, const Word constant) {
+    switch (compare) {
+    case DebugCompare::Equal:
+        return operand == constant;
+    case DebugCompare::NotEqual:
+        return operand != constant;
+    case DebugCompare::Less:
+        return operand < constant;
+    case DebugCompare::GreaterEqual:
+        return operand >= constant;
+    case DebugCompare::AnySet:
+        return (operand & constant) != 0;
+    case DebugCompare::NoneSet:
+        return (operand & constant) == 0;
+    }
+    return false;
+}
+} // namespace
+
+void Debugger::Bitmap::Set(const Word address) {
+    const Byte page = static_cast<Byte>(address >> 8);
+    if (!pages[page]) {
+        pages[page] = true;
+        bits[page] = std::make_unique<u64[]>(PAGE_BYTES / 64);
+    }
+    bits[page][(address & 0xFF) >> 6] |= u64{1} << (address & 63);
+}
+
+void Debugger::Bitmap::Clear() {
+    for (u32 page = 0; page < PAGE_COUNT; ++page) {
+        pages[page] = false;
+        bits[page].reset();
+    }
+}
+
+Debugger::Debugger(Memory &memory) : mem(memory) { mem.SetWatchListener(this); }
+
+Debugger::~Debugger() { mem.RemoveWatchListener(this); }
+
+u32 Debugger::AddBreakpoint(const Word address, std::vector<Condition> conditions) {
+    points.push_back({next_id, address, address, true, false, false, std::move(conditions)});
+    Rebuild();
+    return next_id++;
+}
+
+u32 Debugger::AddWatchpoint(const Word first, const Word last, const bool reads, const bool writes,
+                            std::vector<Condition> conditions) {
+    if (first > last)
+        throw std::invalid_argument("Watchpoint range ends before it starts");
+    points.push_back({next_id, first, last, false, reads, writes, std::move(conditions)});
+    Rebuild();
+    return next_id++;
+}
+
+void Debugger::Remove(const u32 id) {
+    points.erase(std::remove_if(points.begin(), points.end(), [id](const Point &point) { return point.id == id; }),
+                 points.end());
+    Rebuild();
+}
+
+void Debugger::Clear() {
+    points.clear();
+    Rebuild();
+}
+
+void Debugger::Rebuild() {
+    breakpoints.Clear();
+    read_watches.Clear();
+    write_watches.Clear();
+    for (const Point &point : points) {
+        for (u32 address = point.first; address <= point.last; ++address) {
+            if (point.executes)
+                breakpoints.Set(static_cast<Word>(address));
+            if (point.reads)
+                read_watches.Set(static_cast<Word>(address));
+            if (point.writes)
+                write_watches.Set(static_cast<Word>(address));
+        }
+    }
+    for (u32 page = 0; page < PAGE_COUNT; ++page)
+        mem.WatchPage(static_cast<Byte>(page), read_watches.pages[page], write_watches.pages[page]);
+}
+
+bool Debugger::Holds(const Point &point, const DebugRegisters &registers, const Byte value) {
+    for (const Condition &condition : point.conditions) {
+        u32 operand = 0;
+        switch (condition.operand) {
+        case DebugOperand::A:
+            operand = registers.a;
+            break;
+        case DebugOperand::X:
+            operand = registers.x;
+            break;
+        case DebugOperand::Y:
+            operand = registers.y;
+            break;
+        case DebugOperand::SP:
+            operand = registers.sp;
+            break;
+        case DebugOperand::P:
+            operand = registers.p;
+            break;
+        case DebugOperand::PC:
+            operand = registers.pc;
+            break;
+        case DebugOperand::Memory:
+            evaluating = true;
+            operand = mem.ReadByte(condition.address);
+            evaluating = false;
+            break;
+        case DebugOperand::Value:
+            operand = value;
+            break;
+        }
+        if (!Compare(operand, condition.compare, condition.constant))
+            return false;
+    }
+    return true;
+}
+
+void Debugger::OnWatchedAccess(const Word Address, const Byte Value, const bool Write) {
+    if (evaluating || !request_stop || !(Write ? write_watches : read_watches).Test(Address))
+        return;
+    hits.push_back({Address, Value, Write});
+    request_stop(cpu);
+}
+
+void Debugger::Attach(void *target, void (*stop_target)(void *)) {
+    cpu = target;
+    request_stop = stop_target;
+    hits.clear();
+}
+
+void Debugger::Resume(const Word pc, const u32 cycles) {
+    resuming = stop.kind == StopKind::Breakpoint && stop.pc == pc && stop.cycles == cycles;
+    resume_pc = pc;
+    resume_cycles = cycles;
+    stop = {};
+    hits.clear();
+}
+
+bool Debugger::StopAtBreakpoint(const DebugRegisters &registers) {
+    if (resuming) {
+        resuming = false;
+        if (registers.pc == resume_pc && registers.cycles == resume_cycles)
+            return false;
+    }
+    evaluating = true;
+    const Byte opcode = mem.ReadByte(registers.pc);
+    evaluating = false;
+    for (const Point &point : points) {
+        if (point.executes && point.first == registers.pc && Holds(point, registers, opcode)) {
+            stop = {StopKind::Breakpoint, point.id, registers.pc, opcode, false, registers.pc, registers.cycles};
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Debugger::ConfirmStop(const DebugRegisters &registers) {
+    for (const Hit &hit : hits) {
+        for (const Point &point : points) {
+            if (hit.address < point.first || hit.address > point.last || !(hit.write ? point.writes : point.reads))
+                continue;
+            if (Holds(point, registers, hit.value)) {
+                stop = {StopKind::Watchpoint, point.id, hit.address, hit.value, hit.write, registers.pc,
+                        registers.cycles};
+                hits.clear();
+                return true;
+            }
+        }
+    }
+    hits.clear();
+    return false;
+}
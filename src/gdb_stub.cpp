@@ -0,0 +1,499 @@
+#include <cpu6502/gdb_stub.hpp>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+const char TARGET_XML[] = R"(<?xml version="1.0"?>
+<!DOCTYPE target SYSTEM "gdb-target.dtd">
+<target version="1.0">
+  <feature name="org.sim6502.cpu">
+    <reg name="a" bitsize="8" type="uint8" regnum="0"/>
+    <reg name="x" bitsize="8" type="uint8"/>
+    <reg name="y" bitsize="8" type="uint8"/>
+    <reg name="p" bitsize="8" type="uint8"/>
+    <reg name="sp" bitsize="8" type="uint8"/>
+    <reg name="pc" bitsize="16" type="code_ptr"/>
+  </feature>
+</target>
+)";
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+// Offset of each register in the 'g' reply, in bytes, and of the end of the last one.
+constexpr std::size_t REGISTER_OFFSETS[] = {0, 1, 2, 3, 4, 5, 7};
+constexpr u32 REGISTER_COUNT = 6;
+
+void AppendHex(std::string &out, const Byte value) {
+    static const char HEX[] = "0123456789abcdef";
+    out += HEX[value >> 4];
+    out += HEX[value & 0x0F];
+}
+
+int HexDigit(const char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Reads hex digits from text at at, which it advances; false when there are none.
+bool ParseHex(const std::string &text, std::size_t &at, u32 &value) {
+    const std::size_t begin = at;
+    value = 0;
+    for (; at < text.size() && at - begin < 8 && HexDigit(text[at]) >= 0; ++at)
+        value = value << 4 | static_cast<u32>(HexDigit(text[at]));
+    return at != begin;
+}
+
+bool ParseHexBytes(const std::string &text, std::size_t at, std::vector<Byte> &bytes) {
+    if ((text.size() - at) % 2 != 0)
+        return false;
+    for (; at < text.size(); at += 2) {
+        const int hi = HexDigit(text[at]);
+        const int lo = HexDigit(text[at + 1]);
+        if (hi < 0 || lo < 0)
+            return false;
+        bytes.push_back(static_cast<Byte>(hi << 4 | lo));
+    }
+    return true;
+}
+
+// Parses "ADDR,LENGTH" at at, followed by Separator unless it is 0.
+bool ParseRange(const std::string &text, std::size_t &at, u32 &address, u32 &length, const char separator) {
+    if (!ParseHex(text, at, address) || at >= text.size() || text[at++] != ',' || !ParseHex(text, at, length))
+        return false;
+    if (separator == 0)
+        return at == text.size();
+    return at < text.size() && text[at++] == separator;
+}
+
+[[noreturn]] void Fail(const std::string &what, const int socket) {
+    const int error = errno;
+    if (socket >= 0)
+        close(socket);
+    throw std::runtime_error(what + ": " + std::strerror(error));
+}
+} // namespace
+
+GdbStub::GdbStub(CPU &processor) : cpu(processor), mem(processor.mem), debugger(processor.mem) {}
+
+void GdbStub::Serve(const int Socket) {
+    fd = Socket;
+    input.clear();
+    acks = true;
+    closed = false;
+    cpu.SetDebugger(&debugger);
+    std::string packet;
+    while (ReadPacket(packet) && Handle(packet)) {
+    }
+    cpu.SetDebugger(nullptr);
+    debugger.Clear();
+    points.clear();
+    watch_types.clear();
+    close(fd);
+    fd = -1;
+}
+
+bool GdbStub::Fill(const bool wait) {
+    if (closed)
+        return false;
+    if (!wait) {
+        pollfd ready{fd, POLLIN, 0};
+        if (poll(&ready, 1, 0) <= 0)
+            return false;
+    }
+    char buffer[4096];
+    ssize_t received;
+    do {
+        received = recv(fd, buffer, sizeof(buffer), 0);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) {
+        closed = true;
+        return false;
+    }
+    input.append(buffer, static_cast<std::size_t>(received));
+    return true;
+}
+
+// Acks and interrupts between packets are dropped.
+bool GdbStub::ReadPacket(std::string &packet) {
+    for (;;) {
+        const std::size_t start = input.find('$');
+        if (start == std::string::npos)
+            input.clear();
+        const std::size_t end = start == std::string::npos ? start : input.find('#', start);
+        if (end == std::string::npos || end + 2 >= input.size()) {
+            if (!Fill(true))
+                return false;
+            continue;
+        }
+        packet = input.substr(start + 1, end - start - 1);
+        const int hi = HexDigit(input[end + 1]);
+        const int lo = HexDigit(input[end + 2]);
+        input.erase(0, end + 3);
+        Byte sum = 0;
+        for (const char c : packet)
+            sum = static_cast<Byte>(sum + static_cast<Byte>(c));
+        const bool valid = hi >= 0 && lo >= 0 && sum == (hi << 4 | lo);
+        if (acks && send(fd, valid ? "+" : "-", 1, SEND_FLAGS) != 1)
+            closed = true;
+        if (valid)
+            return true;
+    }
+}
+
+void GdbStub::WritePacket(const std::string &payload) {
+    std::string frame = "$" + payload + "#";
+    Byte sum = 0;
+    for (const char c : payload)
+        sum = static_cast<Byte>(sum + static_cast<Byte>(c));
+    AppendHex(frame, sum);
+    for (;;) {
+        for (std::size_t sent = 0; sent < frame.size();) {
+            const ssize_t count = send(fd, frame.data() + sent, frame.size() - sent, SEND_FLAGS);
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count <= 0) {
+                closed = true;
+                return;
+            }
+            sent += static_cast<std::size_t>(count);
+        }
+        if (!acks)
+            return;
+        while (input.empty()) {
+            if (!Fill(true))
+                return;
+        }
+        if (input[0] != '-') {
+            if (input[0] == '+')
+                input.erase(0, 1);
+            return;
+        }
+        input.erase(0, 1);
+    }
+}
+
+std::string GdbStub::ReadRegisters() const {
+    std::string out;
+    for (const Byte value : {cpu.A, cpu.X, cpu.Y, cpu.StatusRegister(), static_cast<Byte>(cpu.SP),
+                             static_cast<Byte>(cpu.PC), static_cast<Byte>(cpu.PC >> 8)})
+        AppendHex(out, value);
+    return out;
+}
+
+void GdbStub::WriteRegister(const u32 index, const Byte *bytes) {
+    switch (index) {
+    case 0:
+        cpu.A = bytes[0];
+        break;
+    case 1:
+        cpu.X = bytes[0];
+        break;
+    case 2:
+        cpu.Y = bytes[0];
+        break;
+    case 3:
+        cpu.SetStatusRegister(bytes[0]);
+        break;
+    case 4:
+        cpu.SP = bytes[0];
+        break;
+    default:
+        cpu.PC = static_cast<Word>(bytes[0] | bytes[1] << 8);
+        break;
+    }
+}
+
+bool GdbStub::Handle(const std::string &packet) {
+    std::size_t at = 1;
+    u32 address = 0;
+    u32 length = 0;
+    std::vector<Byte> bytes;
+    switch (packet.empty() ? '\0' : packet[0]) {
+    case '?':
+        WritePacket(last_stop);
+        return true;
+    case 'g':
+        WritePacket(ReadRegisters());
+        return true;
+    case 'G':
+        if (!ParseHexBytes(packet, 1, bytes) || bytes.size() != REGISTER_OFFSETS[REGISTER_COUNT]) {
+            WritePacket("E01");
+            return true;
+        }
+        for (u32 index = 0; index < REGISTER_COUNT; ++index)
+            WriteRegister(index, &bytes[REGISTER_OFFSETS[index]]);
+        WritePacket("OK");
+        return true;
+    case 'p':
+        if (!ParseHex(packet, at, address) || address >= REGISTER_COUNT) {
+            WritePacket("E01");
+            return true;
+        }
+        WritePacket(ReadRegisters().substr(2 * REGISTER_OFFSETS[address],
+                                           2 * (REGISTER_OFFSETS[address + 1] - REGISTER_OFFSETS[address])));
+        return true;
+    case 'P':
+        if (!ParseHex(packet, at, address) || address >= REGISTER_COUNT || at >= packet.size() ||
+            packet[at] != '=' || !ParseHexBytes(packet, at + 1, bytes) ||
+            bytes.size() != REGISTER_OFFSETS[address + 1] - REGISTER_OFFSETS[address]) {
+            WritePacket("E01");
+            return true;
+        }
+        WriteRegister(address, bytes.data());
+        WritePacket("OK");
+        return true;
+    case 'm': {
+        if (!ParseRange(packet, at, address, length, 0) || address >= MAX_MEM) {
+            WritePacket("E01");
+            return true;
+        }
+        // Shorter replies for reads past the end of the bus or the packet size are partial reads.
+        const u32 end = std::min({address + length, MAX_MEM, address + PACKET_SIZE / 2});
+        std::string out;
+        out.reserve(2 * (end - address));
+        for (; address < end; ++address)
+            AppendHex(out, mem.ReadByte(static_cast<Word>(address)));
+        WritePacket(out);
+        return true;
+    }
+    case 'M':
+        if (!ParseRange(packet, at, address, length, ':') || !ParseHexBytes(packet, at, bytes) ||
+            bytes.size() != length || address + length > MAX_MEM) {
+            WritePacket("E01");
+            return true;
+        }
+        mem.WriteBlock(static_cast<Word>(address), bytes.data(), bytes.size());
+        WritePacket("OK");
+        return true;
+    case 'X':
+        if (!ParseRange(packet, at, address, length, ':')) {
+            WritePacket("E01");
+            return true;
+        }
+        // Binary data escapes '#', '$', '}' and '*' as '}' followed by the byte XOR 0x20.
+        for (; at < packet.size(); ++at) {
+            if (packet[at] == '}' && at + 1 < packet.size())
+                bytes.push_back(static_cast<Byte>(packet[++at] ^ 0x20));
+            else
+                bytes.push_back(static_cast<Byte>(packet[at]));
+        }
+        if (bytes.size() != length || address + length > MAX_MEM) {
+            WritePacket("E01");
+            return true;
+        }
+        mem.WriteBlock(static_cast<Word>(address), bytes.data(), bytes.size());
+        WritePacket("OK");
+        return true;
+    case 'c':
+    case 's':
+        if (ParseHex(packet, at, address))
+            cpu.PC = static_cast<Word>(address);
+        last_stop = Resume(packet[0] == 's');
+        WritePacket(last_stop);
+        return true;
+    case 'Z':
+    case 'z':
+        WritePacket(SetPoint(packet, packet[0] == 'Z'));
+        return true;
+    case 'H':
+        WritePacket("OK");
+        return true;
+    case 'D':
+        WritePacket("OK");
+        return false;
+    case 'k':
+        return false;
+    case 'q':
+        if (packet.rfind("qSupported", 0) == 0) {
+            char features[96];
+            std::snprintf(features, sizeof(features), "PacketSize=%x;qXfer:features:read+;QStartNoAckMode+",
+                          PACKET_SIZE);
+            WritePacket(features);
+        } else if (packet.rfind("qXfer:features:read:target.xml:", 0) == 0) {
+            at = sizeof("qXfer:features:read:target.xml:") - 1;
+            if (!ParseRange(packet, at, address, length, 0)) {
+                WritePacket("E01");
+                return true;
+            }
+            const std::string xml = TARGET_XML;
+            const std::string chunk = address < xml.size() ? xml.substr(address, length) : "";
+            WritePacket((address + chunk.size() < xml.size() ? "m" : "l") + chunk);
+        } else if (packet == "qAttached") {
+            WritePacket("1");
+        } else {
+            WritePacket("");
+        }
+        return true;
+    case 'Q':
+        if (packet == "QStartNoAckMode") {
+            WritePacket("OK");
+            acks = false;
+        } else {
+            WritePacket("");
+        }
+        return true;
+    case 'v':
+        if (packet.rfind("vKill", 0) == 0) {
+            WritePacket("OK");
+            return false;
+        }
+        WritePacket("");
+        return true;
+    default:
+        WritePacket("");
+        return true;
+    }
+}
+
+std::string GdbStub::SetPoint(const std::string &packet, const bool insert) {
+    const char type = packet.size() > 1 ? packet[1] : '\0';
+    if (type < '0' || type > '4' || packet.size() < 3 || packet[2] != ',')
+        return "E01";
+    std::size_t at = 3;
+    u32 address = 0;
+    u32 kind = 0;
+    if (!ParseHex(packet, at, address) || at >= packet.size() || packet[at++] != ',' || !ParseHex(packet, at, kind) ||
+        address >= MAX_MEM)
+        return "E01";
+    // Breakpoint kinds are instruction sizes; both breakpoint types are the same here.
+    const char key_type = type == '1' ? '0' : type;
+    const Word key_kind = type <= '1' ? Word{0} : static_cast<Word>(kind);
+    const auto key = std::make_tuple(key_type, static_cast<Word>(address), key_kind);
+    const auto found = points.find(key);
+    if (!insert) {
+        if (found != points.end()) {
+            debugger.Remove(found->second);
+            watch_types.erase(found->second);
+            points.erase(found);
+        }
+        return "OK";
+    }
+    if (found != points.end())
+        return "OK";
+    u32 id = 0;
+    if (type <= '1') {
+        id = debugger.AddBreakpoint(static_cast<Word>(address));
+    } else {
+        if (kind == 0 || address + kind > MAX_MEM)
+            return "E01";
+        id = debugger.AddWatchpoint(static_cast<Word>(address), static_cast<Word>(address + kind - 1), type != '2',
+                                    type != '3');
+        watch_types[id] = type;
+    }
+    points[key] = id;
+    return "OK";
+}
+
+std::string GdbStub::Resume(const bool step) {
+    const Word pc = cpu.PC;
+    const u32 cycles = cpu.cycles;
+    for (;;) {
+        cpu.Execute(step ? 1 : SLICE);
+        const StopReason &stop = debugger.LastStop();
+        // A breakpoint where the run starts stops before anything runs; the next Execute steps over it.
+        if (stop.kind == StopKind::Breakpoint && cpu.PC == pc && cpu.cycles == cycles)
+            continue;
+        if (stop.kind == StopKind::Watchpoint) {
+            const char type = watch_types[stop.id];
+            std::string reply = type == '2' ? "T05watch:" : type == '3' ? "T05rwatch:" : "T05awatch:";
+            AppendHex(reply, static_cast<Byte>(stop.address >> 8));
+            AppendHex(reply, static_cast<Byte>(stop.address));
+            return reply + ";";
+        }
+        if (stop.kind == StopKind::Breakpoint || step)
+            return "S05";
+        if (Interrupted())
+            return "S02";
+    }
+}
+
+// Takes in whatever the client sent while the CPU ran; an interrupt byte or a closed connection ends the run.
+bool GdbStub::Interrupted() {
+    while (Fill(false)) {
+    }
+    const std::size_t at = input.find('\x03');
+    if (at == std::string::npos)
+        return closed;
+    input.erase(at, 1);
+    return true;
+}
+
+int GdbStub::Listen(const std::string &Endpoint) {
+    int listener = -1;
+    if (Endpoint.find('/') != std::string::npos) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (Endpoint.size() >= sizeof(address.sun_path))
+            throw std::runtime_error("Unix socket path too long: " + Endpoint);
+        std::memcpy(address.sun_path, Endpoint.c_str(), Endpoint.size() + 1);
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0)
+            Fail("socket", listener);
+        unlink(Endpoint.c_str());
+        if (bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+            Fail("bind " + Endpoint, listener);
+    } else {
+        const std::size_t colon = Endpoint.rfind(':');
+        const std::string host = colon == std::string::npos ? "127.0.0.1" : Endpoint.substr(0, colon);
+        const std::string port = colon == std::string::npos ? Endpoint : Endpoint.substr(colon + 1);
+        std::size_t used = 0;
+        unsigned long number = 0;
+        try {
+            number = std::stoul(port, &used, 10);
+        } catch (const std::logic_error &) {
+            used = 0;
+        }
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(number));
+        if (port.empty() || used != port.size() || number > 0xFFFF)
+            throw std::runtime_error("bad port in " + Endpoint);
+        if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+            throw std::runtime_error("bad IPv4 address in " + Endpoint);
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener < 0)
+            Fail("socket", listener);
+        const int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+            Fail("bind " + Endpoint, listener);
+    }
+    if (listen(listener, 1) != 0)
+        Fail("listen " + Endpoint, listener);
+    return listener;
+}
+
+int GdbStub::Accept(const int Listener) {
+    int client;
+    do {
+        client = accept(Listener, nullptr, nullptr);
+    } while (client < 0 && errno == EINTR);
+    if (client < 0)
+        Fail("accept", -1);
+    // Packets are answered one at a time, so waiting to coalesce them only adds latency. Fails on Unix sockets.
+    const int no_delay = 1;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+    return client;
+}
@@ -0,0 +1,605 @@
+#include <algorithm>
+#include <cpu6502/config.hpp>
+#include <cpu6502/jit.hpp>
+#include <cpu6502/opcodes.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+#if CPU6502_ENABLE_JIT && defined(__x86_64__) && defined(__linux__)
+#define CPU6502_JIT_NATIVE 1
+#include <sys/mman.h>
+#else
+#define CPU6502_JIT_NATIVE 0
+#endif
+
+namespace {
+template <typename Fn> const void *Address(Fn *fn) { return reinterpret_cast<const void *>(fn); }
+
+enum class Kind : Byte { None, Load, Store, Nop };
+
+enum class Mode : Byte {
+    Implied,
+    Immediate,
+    ZeroPage,
+    ZeroPageX,
+    ZeroPageY,
+    Absolute,
+    AbsoluteX,
+    AbsoluteY,
+    AbsoluteXStore,
+    AbsoluteYStore,
+    IndexedIndirectX,
+    IndirectIndexedY,
+    IndirectIndexedYStore,
+};
+
+constexpr Byte PAGES = offsetof(Jit::State, pages);
+constexpr Byte WRITE_PAGES = offsetof(Jit::State, write_pages);
+constexpr Byte REG_A = offsetof(Jit::State, a);
+constexpr Byte REG_X = offsetof(Jit::State, x);
+constexpr Byte REG_Y = offsetof(Jit::State, y);
+constexpr Byte Z_RESULT = offsetof(Jit::State, z_result);
+constexpr Byte N_RESULT = offsetof(Jit::State, n_result);
+constexpr Byte CYCLES = offsetof(Jit::State, cycles);
+constexpr Byte BUDGET = offsetof(Jit::State, budget);
+constexpr Byte PC = offsetof(Jit::State, pc);
+constexpr Byte STOP = offsetof(Jit::State, stop);
+
+// Entry count of a hot PC the translator could not compile.
+constexpr u32 UNTRANSLATABLE = ~u32{0};
+
+// How the translator handles an opcode; cycles exclude the page-cross penalty, which generated code adds.
+struct Translation {
+    Kind kind;
+    Mode mode;
+    Byte reg;
+    Byte cycles;
+};
+
+constexpr Mode TranslateMode(const Kind kind, const AddressingMode mode) {
+    const bool store = kind == Kind::Store;
+    switch (mode) {
+    case AddressingMode::Immediate:
+        return Mode::Immediate;
+    case AddressingMode::ZeroPage:
+        return Mode::ZeroPage;
+    case AddressingMode::ZeroPageX:
+        return Mode::ZeroPageX;
+    case AddressingMode::ZeroPageY:
+        return Mode::ZeroPageY;
+    case AddressingMode::Absolute:
+        return Mode::Absolute;
+    case AddressingMode::AbsoluteX:
+        return store ? Mode::AbsoluteXStore : Mode::AbsoluteX;
+    case AddressingMode::AbsoluteY:
+        return store ? Mode::AbsoluteYStore : Mode::AbsoluteY;
+    case AddressingMode::IndexedIndirectX:
+        return Mode::IndexedIndirectX;
+    case AddressingMode::IndirectIndexedY:
+        return store ? Mode::IndirectIndexedYStore : Mode::IndirectIndexedY;
+    default:
+        return Mode::Implied;
+    }
+}
+
+constexpr Translation Translate(const Byte opcode) {
+    const OpcodeInfo &info = OPCODES[opcode];
+    Kind kind = Kind::Load;
+    Byte reg = 0;
+    switch (info.mnemonic) {
+    case Mnemonic::LDA:
+        reg = REG_A;
+        break;
+    case Mnemonic::LDX:
+        reg = REG_X;
+        break;
+    case Mnemonic::LDY:
+        reg = REG_Y;
+        break;
+    case Mnemonic::STA:
+        kind = Kind::Store;
+        reg = REG_A;
+        break;
+    case Mnemonic::STX:
+        kind = Kind::Store;
+        reg = REG_X;
+        break;
+    case Mnemonic::STY:
+        kind = Kind::Store;
+        reg = REG_Y;
+        break;
+    case Mnemonic::NOP:
+        return {Kind::Nop, Mode::Implied, 0, info.cycles};
+    default:
+        return {Kind::None, Mode::Implied, 0, 0};
+    }
+    return {kind, TranslateMode(kind, info.mode), reg, info.cycles};
+}
+
+// Minimal x86-64 encoder. Generated blocks keep the State pointer in rbx, the cycles run in the block in r12d, the
+// budget in r13d and the memory read page table in r14; every exit stores PC and cycles back through one shared
+// epilogue. Reads and writes of directly mapped pages are plain loads and stores; the rest call back into Memory.
+class Emitter {
+    std::vector<Byte> code;
+    std::vector<std::size_t> exits;
+    // Conditional exits taken rarely jump to stubs placed after the block, so the straight-line path falls through.
+    std::vector<std::pair<std::size_t, Word>> stubs;
+    const void *read_thunk;
+    const void *write_thunk;
+
+    void Rel32(const std::size_t at, const std::size_t target) {
+        const auto rel = static_cast<u32>(static_cast<std::int64_t>(target) - static_cast<std::int64_t>(at + 4));
+        for (std::size_t i = 0; i < 4; ++i)
+            code[at + i] = static_cast<Byte>(rel >> (8 * i));
+    }
+
+public:
+    Emitter(const void *read, const void *write) : read_thunk(read), write_thunk(write) {}
+
+    // Bytes emitted by Call.
+    static constexpr Byte CALL_BYTES = 15;
+
+    [[nodiscard]] const std::vector<Byte> &Code() const { return code; }
+
+    void Emit(const std::initializer_list<Byte> bytes) { code.insert(code.end(), bytes); }
+
+    void Imm32(const u32 value) {
+        for (std::size_t i = 0; i < 4; ++i)
+            code.push_back(static_cast<Byte>(value >> (8 * i)));
+    }
+
+    void Prologue() {
+        Emit({0x53});                     // push rbx
+        Emit({0x41, 0x54});               // push r12
+        Emit({0x41, 0x55});               // push r13
+        Emit({0x41, 0x56});               // push r14
+        Emit({0x41, 0x57});               // push r15
+        Emit({0x48, 0x89, 0xFB});         // mov rbx, rdi
+        Emit({0x45, 0x31, 0xE4});         // xor r12d, r12d
+        Emit({0x44, 0x8B, 0x6B, BUDGET}); // mov r13d, [rbx+budget]
+        Emit({0x4C, 0x8B, 0x73, PAGES});  // mov r14, [rbx+pages]
+    }
+
+    void Exit(const Word pc) {
+        Emit({0xB8}); // mov eax, imm32
+        Imm32(pc);
+        Emit({0xE9}); // jmp epilogue
+        exits.push_back(code.size());
+        Imm32(0);
+    }
+
+    void Epilogue() {
+        for (const auto &[at, pc] : stubs) {
+            Rel32(at, code.size());
+            Exit(pc);
+        }
+        for (const std::size_t at : exits)
+            Rel32(at, code.size());
+        Emit({0x66, 0x89, 0x43, PC});     // mov [rbx+pc], ax
+        Emit({0x44, 0x03, 0x63, CYCLES}); // add r12d, [rbx+cycles]
+        Emit({0x44, 0x89, 0x63, CYCLES}); // mov [rbx+cycles], r12d
+        Emit({0x41, 0x5F, 0x41, 0x5E});   // pop r15; pop r14
+        Emit({0x41, 0x5D, 0x41, 0x5C});   // pop r13; pop r12
+        Emit({0x5B, 0xC3});               // pop rbx; ret
+    }
+
+    void AddCycles(const Byte value) { Emit({0x41, 0x83, 0xC4, value}); } // add r12d, imm8
+
+    // Adds the page-cross cycle when edx, the low address byte plus the index, carried into the next page.
+    void PageCrossPenalty() {
+        Emit({0x81, 0xFA, 0x00, 0x01, 0x00, 0x00}); // cmp edx, 0x100
+        Emit({0x72, 0x04});                         // jb +4
+        AddCycles(1);
+    }
+
+    void MovEsiImm(const u32 value) {
+        Emit({0xBE}); // mov esi, imm32
+        Imm32(value);
+    }
+
+    void AddEsiImm(const u32 value) {
+        Emit({0x81, 0xC6}); // add esi, imm32
+        Imm32(value);
+    }
+
+    void LoadEsiReg(const Byte reg) { Emit({0x0F, 0xB6, 0x73, reg}); } // movzx esi, byte [rbx+reg]
+
+    // Reads the byte at address esi into eax through the page table, calling ReadThunk for unmapped pages.
+    void ReadByte() {
+        Emit({0x89, 0xF0});             // mov eax, esi
+        Emit({0xC1, 0xE8, 0x08});       // shr eax, 8
+        Emit({0x49, 0x8B, 0x04, 0xC6}); // mov rax, [r14+rax*8]
+        Emit({0x48, 0x85, 0xC0});       // test rax, rax
+        Emit({0x74, 0x0A});             // jz slow
+        Emit({0x40, 0x0F, 0xB6, 0xCE}); // movzx ecx, sil
+        Emit({0x0F, 0xB6, 0x04, 0x08}); // movzx eax, byte [rax+rcx]
+        Emit({0xEB, CALL_BYTES + 3});   // jmp done
+        Call(read_thunk);               // slow:
+        Emit({0x0F, 0xB6, 0xC0});       // movzx eax, al
+    }
+
+    // Writes register reg to address esi through the write page table, calling WriteThunk for pages without a
+    // direct pointer: devices, watched pages, pages holding code and pages shared with a fork.
+    void WriteByte(const Byte reg) {
+        Emit({0x89, 0xF0});              // mov eax, esi
+        Emit({0xC1, 0xE8, 0x08});        // shr eax, 8
+        Emit({0x48, 0x8B, 0x4B, WRITE_PAGES}); // mov rcx, [rbx+write_pages]
+        Emit({0x48, 0x8B, 0x04, 0xC1});  // mov rax, [rcx+rax*8]
+        Emit({0x48, 0x85, 0xC0});        // test rax, rax
+        Emit({0x74, 0x0D});              // jz slow
+        Emit({0x40, 0x0F, 0xB6, 0xCE});  // movzx ecx, sil
+        Emit({0x0F, 0xB6, 0x53, reg});   // movzx edx, byte [rbx+reg]
+        Emit({0x88, 0x14, 0x08});        // mov [rax+rcx], dl
+        Emit({0xEB, CALL_BYTES + 4});    // jmp done
+        Emit({0x0F, 0xB6, 0x53, reg});   // slow: movzx edx, byte [rbx+reg]
+        Call(write_thunk);
+    }
+
+    // Reads the little-endian pointer at zero-page address esi into eax, wrapping within the zero page.
+    void ReadZeroPagePointer() {
+        Emit({0x41, 0x89, 0xF7}); // mov r15d, esi
+        ReadByte();
+        Emit({0x41, 0x8D, 0x77, 0x01}); // lea esi, [r15+1]
+        Emit({0x40, 0x0F, 0xB6, 0xF6}); // movzx esi, sil
+        Emit({0x41, 0x89, 0xC7});       // mov r15d, eax
+        ReadByte();
+        Emit({0xC1, 0xE0, 0x08}); // shl eax, 8
+        Emit({0x44, 0x09, 0xF8}); // or eax, r15d
+    }
+
+    // Reads the pointer at a fixed zero-page address with one 16-bit load when page zero is directly mapped, else
+    // through ReadZeroPagePointer. The pointer at $FF wraps to $00, so it always takes the general path.
+    void ReadZeroPagePointer(const Byte zp) {
+        if (zp == 0xFF) {
+            MovEsiImm(zp);
+            ReadZeroPagePointer();
+            return;
+        }
+        Emit({0x49, 0x8B, 0x06}); // mov rax, [r14]
+        Emit({0x48, 0x85, 0xC0}); // test rax, rax
+        Emit({0x74, 0x09});       // jz slow
+        Emit({0x0F, 0xB7, 0x80}); // movzx eax, word [rax+imm32]
+        Imm32(zp);
+        Emit({0xEB, 0x00}); // jmp done
+        const std::size_t jump = code.size();
+        MovEsiImm(zp); // slow:
+        ReadZeroPagePointer();
+        code[jump - 1] = static_cast<Byte>(code.size() - jump);
+    }
+
+    void Call(const void *target) {
+        Emit({0x48, 0x89, 0xDF, 0x48, 0xB8}); // mov rdi, rbx; mov rax, imm64
+        const auto address = reinterpret_cast<std::uintptr_t>(target);
+        Imm32(static_cast<u32>(address));
+        Imm32(static_cast<u32>(address >> 32));
+        Emit({0xFF, 0xD0}); // call rax
+    }
+
+    void CheckBudget(const Word next_pc) {
+        Emit({0x45, 0x39, 0xEC});       // cmp r12d, r13d
+        Emit({0x0F, 0x83});             // jae stub
+        ExitStub(next_pc);
+    }
+
+    void CheckStop(const Word next_pc) {
+        Emit({0x80, 0x7B, STOP, 0x00}); // cmp byte [rbx+stop], 0
+        Emit({0x0F, 0x85});             // jne stub
+        ExitStub(next_pc);
+    }
+
+    void ExitStub(const Word pc) {
+        stubs.emplace_back(code.size(), pc);
+        Imm32(0);
+    }
+};
+
+} // namespace
+
+struct Jit::Differential {
+    Memory memory;
+    CPU cpu;
+    std::string report;
+
+    explicit Differential(const Memory &source) : memory(source), cpu(memory) {}
+};
+
+Jit::Jit(CPU &processor, const u32 threshold, const std::size_t arena_size)
+    : cpu(processor), hot_threshold(threshold), arena_bytes(arena_size), blocks(MAX_MEM, nullptr),
+      hits(MAX_MEM, 0) {
+    state.jit = this;
+    cpu.mem.SetCodeWriteListener(this);
+#if CPU6502_JIT_NATIVE
+    void *mapping = mmap(nullptr, arena_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping != MAP_FAILED)
+        arena = static_cast<Byte *>(mapping);
+#endif
+}
+
+Jit::~Jit() {
+    cpu.mem.RemoveCodeWriteListener(this);
+#if CPU6502_JIT_NATIVE
+    if (arena)
+        munmap(arena, arena_bytes);
+#endif
+}
+
+bool Jit::Available() const { return arena != nullptr; }
+
+void Jit::Execute(const u32 exec_cycles) {
+    // Compared as cycles run so far, so the counter may wrap during the call.
+    const u32 start = cpu.cycles;
+    if (differential && !Diverged())
+        SyncDifferential();
+    while (cpu.cycles - start < exec_cycles && !Diverged()) {
+        if (cpu.WorkPending()) {
+            if (!cpu.ServicePending())
+                return;
+            if (differential)
+                SyncDifferential();
+            continue;
+        }
+        const Word pc = cpu.PC;
+        BlockFn block = blocks[pc];
+        if (!block && arena && hits[pc] != UNTRANSLATABLE && ++hits[pc] >= hot_threshold && Compilable(pc)) {
+            block = Compile(pc);
+            // Not retried until the code is written again.
+            if (!block)
+                hits[pc] = UNTRANSLATABLE;
+        }
+        // The instruction after a CLI that delays a held IRQ runs alone so the IRQ is taken right after it.
+        if (block && !cpu.IrqDelayed()) {
+            RunNative(block, exec_cycles - (cpu.cycles - start));
+            CheckDifferential();
+        } else {
+            cpu.Execute(1);
+        }
+    }
+    if (cpu.debug_stop)
+        cpu.ConfirmWatch();
+}
+
+bool Jit::Compilable(const Word pc) const {
+    // Code read from a device can change under the same address, so it is always interpreted.
+    const Byte page = static_cast<Byte>(pc >> 8);
+    return page_invalidations[page] < SMC_PAGE_LIMIT && !cpu.mem.IsDevicePage(page) &&
+           !cpu.mem.IsDevicePage(static_cast<Byte>(page + 1));
+}
+
+void Jit::RunNative(const BlockFn block, const u32 budget) {
+    state.pages = cpu.mem.ReadPages;
+    state.write_pages = cpu.mem.WritePages;
+    state.cycles = cpu.cycles;
+    state.budget = budget;
+    state.pc = cpu.PC;
+    state.a = cpu.A;
+    state.x = cpu.X;
+    state.y = cpu.Y;
+    state.z_result = cpu.z_result;
+    state.n_result = cpu.n_result;
+    state.stop = 0;
+    block(&state);
+    cpu.cycles = state.cycles;
+    cpu.PC = state.pc;
+    cpu.A = state.a;
+    cpu.X = state.x;
+    cpu.Y = state.y;
+    cpu.z_result = state.z_result;
+    cpu.n_result = state.n_result;
+    ++native_runs;
+}
+
+Jit::BlockFn Jit::Compile(const Word pc) {
+#if CPU6502_JIT_NATIVE
+    const Memory &mem = cpu.mem;
+    if (Translate(mem.PeekByte(pc)).kind == Kind::None)
+        return nullptr;
+
+    Emitter emitter(Address(&Jit::ReadThunk), Address(&Jit::WriteThunk));
+    emitter.Prologue();
+    const Byte page = static_cast<Byte>(pc >> 8);
+    Word addr = pc;
+    while (true) {
+        const Byte opcode = mem.PeekByte(addr);
+        const Translation op = Translate(opcode);
+        if (op.kind == Kind::None)
+            break;
+        const Byte operand_size = CPU::OperandSizes[opcode];
+        const auto operand_addr = static_cast<Word>(addr + 1);
+        const Word operand = operand_size == 2   ? mem.PeekWord(operand_addr)
+                             : operand_size == 1 ? mem.PeekByte(operand_addr)
+                                                 : Word{0};
+        const auto next = static_cast<Word>(addr + 1 + operand_size);
+
+        emitter.AddCycles(op.cycles);
+        switch (op.mode) {
+        case Mode::Implied:
+        case Mode::Immediate:
+            break;
+        case Mode::ZeroPage:
+        case Mode::Absolute:
+            emitter.MovEsiImm(operand);
+            break;
+        case Mode::ZeroPageX:
+        case Mode::ZeroPageY:
+            emitter.LoadEsiReg(op.mode == Mode::ZeroPageX ? REG_X : REG_Y);
+            emitter.AddEsiImm(operand);
+            emitter.Emit({0x40, 0x0F, 0xB6, 0xF6}); // movzx esi, sil
+            break;
+        case Mode::AbsoluteX:
+        case Mode::AbsoluteY:
+            emitter.LoadEsiReg(op.mode == Mode::AbsoluteX ? REG_X : REG_Y);
+            emitter.Emit({0x8D, 0x96}); // lea edx, [rsi+imm32]
+            emitter.Imm32(operand & 0x00FFu);
+            emitter.PageCrossPenalty();
+            emitter.AddEsiImm(operand);
+            emitter.Emit({0x0F, 0xB7, 0xF6}); // movzx esi, si
+            break;
+        case Mode::AbsoluteXStore:
+        case Mode::AbsoluteYStore:
+            emitter.LoadEsiReg(op.mode == Mode::AbsoluteXStore ? REG_X : REG_Y);
+            emitter.AddEsiImm(operand);
+            emitter.Emit({0x0F, 0xB7, 0xF6}); // movzx esi, si
+            break;
+        case Mode::IndexedIndirectX:
+            emitter.LoadEsiReg(REG_X);
+            emitter.AddEsiImm(operand);
+            emitter.Emit({0x40, 0x0F, 0xB6, 0xF6}); // movzx esi, sil
+            emitter.ReadZeroPagePointer();
+            emitter.Emit({0x89, 0xC6}); // mov esi, eax
+            break;
+        case Mode::IndirectIndexedY:
+        case Mode::IndirectIndexedYStore:
+            emitter.ReadZeroPagePointer(static_cast<Byte>(operand));
+            emitter.Emit({0x0F, 0xB6, 0x4B, REG_Y}); // movzx ecx, byte [rbx+y]
+            if (op.mode == Mode::IndirectIndexedY) {
+                emitter.Emit({0x0F, 0xB6, 0xD0}); // movzx edx, al
+                emitter.Emit({0x01, 0xCA});       // add edx, ecx
+                emitter.PageCrossPenalty();
+            }
+            emitter.Emit({0x8D, 0x34, 0x08}); // lea esi, [rax+rcx]
+            emitter.Emit({0x0F, 0xB7, 0xF6}); // movzx esi, si
+            break;
+        }
+
+        if (op.kind == Kind::Load) {
+            if (op.mode == Mode::Immediate) {
+                const auto value = static_cast<Byte>(operand);
+                emitter.Emit({0xC6, 0x43, op.reg, value});   // mov byte [rbx+reg], imm8
+                emitter.Emit({0xC6, 0x43, Z_RESULT, value}); // mov byte [rbx+z_result], imm8
+                emitter.Emit({0xC6, 0x43, N_RESULT, value}); // mov byte [rbx+n_result], imm8
+            } else {
+                emitter.ReadByte();
+                emitter.Emit({0x88, 0x43, op.reg});   // mov [rbx+reg], al
+                emitter.Emit({0x88, 0x43, Z_RESULT}); // mov [rbx+z_result], al
+                emitter.Emit({0x88, 0x43, N_RESULT}); // mov [rbx+n_result], al
+            }
+        } else if (op.kind == Kind::Store) {
+            emitter.WriteByte(op.reg);
+        }
+
+        addr = next;
+        if ((addr >> 8) != page || Translate(mem.PeekByte(addr)).kind == Kind::None)
+            break;
+        if (op.kind == Kind::Store)
+            emitter.CheckStop(addr);
+        emitter.CheckBudget(addr);
+    }
+    emitter.Exit(addr);
+    emitter.Epilogue();
+
+    const std::vector<Byte> &code = emitter.Code();
+    if (arena_used + code.size() > arena_bytes) {
+        Flush();
+        if (code.size() > arena_bytes)
+            return nullptr;
+    }
+    Byte *const target = arena + arena_used;
+    mprotect(arena, arena_bytes, PROT_READ | PROT_WRITE);
+    std::memcpy(target, code.data(), code.size());
+    mprotect(arena, arena_bytes, PROT_READ | PROT_EXEC);
+    arena_used += (code.size() + 15) & ~std::size_t{15};
+
+    cpu.mem.MarkCodePage(page);
+    cpu.mem.MarkCodePage(static_cast<Byte>((addr - 1) >> 8));
+
+    auto block = reinterpret_cast<BlockFn>(target);
+    blocks[pc] = block;
+    ++compiled_blocks;
+    return block;
+#else
+    (void)pc;
+    return nullptr;
+#endif
+}
+
+void Jit::Flush() {
+    std::fill(blocks.begin(), blocks.end(), nullptr);
+    arena_used = 0;
+}
+
+void Jit::OnCodeWrite(const Byte page) {
+    // Blocks that start on the previous page may run into this one.
+    const u32 begin = static_cast<Byte>(page - 1) * PAGE_BYTES;
+    std::fill_n(blocks.begin() + begin, PAGE_BYTES, nullptr);
+    std::fill_n(blocks.begin() + page * PAGE_BYTES, PAGE_BYTES, nullptr);
+    std::fill_n(hits.begin() + begin, PAGE_BYTES, 0);
+    std::fill_n(hits.begin() + page * PAGE_BYTES, PAGE_BYTES, 0);
+    if (page_invalidations[page] < SMC_PAGE_LIMIT)
+        ++page_invalidations[page];
+    state.stop = 1;
+}
+
+void Jit::EnableDifferential() { differential = std::make_unique<Differential>(cpu.mem); }
+
+void Jit::SyncDifferential() {
+    differential->memory = cpu.mem;
+    CPU &shadow = differential->cpu;
+    shadow.PC = cpu.PC;
+    shadow.SP = cpu.SP;
+    shadow.A = cpu.A;
+    shadow.X = cpu.X;
+    shadow.Y = cpu.Y;
+    shadow.cycles = cpu.cycles;
+    shadow.SetStatusRegister(cpu.StatusRegister());
+}
+
+bool Jit::Diverged() const { return differential && !differential->report.empty(); }
+
+const std::string &Jit::DivergenceReport() const {
+    static const std::string none;
+    return differential ? differential->report : none;
+}
+
+void Jit::CheckDifferential() {
+    if (!differential)
+        return;
+    CPU &shadow = differential->cpu;
+    if (shadow.cycles != cpu.cycles)
+        shadow.Execute(cpu.cycles - shadow.cycles);
+
+    std::ostringstream out;
+    out << std::hex << std::setfill('0');
+    auto compare = [&out](const char *name, const u32 native, const u32 interpreted) {
+        if (native != interpreted)
+            out << name << ": native=$" << native << " interpreter=$" << interpreted << '\n';
+    };
+    compare("PC", cpu.PC, shadow.PC);
+    compare("SP", cpu.SP, shadow.SP);
+    compare("A", cpu.A, shadow.A);
+    compare("X", cpu.X, shadow.X);
+    compare("Y", cpu.Y, shadow.Y);
+    compare("cycles", cpu.cycles, shadow.cycles);
+    compare("P", cpu.StatusRegister(), shadow.StatusRegister());
+    for (u32 addr = 0; addr < MAX_MEM; ++addr) {
+        const auto address = static_cast<Word>(addr);
+        if (cpu.mem.PeekByte(address) != differential->memory.PeekByte(address)) {
+            out << "memory $" << std::setw(4) << addr << ": native=$" << std::setw(2)
+                << static_cast<u32>(cpu.mem.PeekByte(address)) << " interpreter=$" << std::setw(2)
+                << static_cast<u32>(differential->memory.PeekByte(address)) << '\n';
+            break;
+        }
+    }
+    differential->report = out.str();
+}
+
+u32 Jit::CompiledBlocks() const { return compiled_blocks; }
+
+u32 Jit::NativeBlockRuns() const { return native_runs; }
+
+Byte Jit::ReadThunk(State *state, const u32 addr) {
+    return state->jit->cpu.mem.ReadByte(static_cast<Word>(addr));
+}
+
+void Jit::WriteThunk(State *state, const u32 addr, const u32 value) {
+    CPU &processor = state->jit->cpu;
+    processor.mem.WriteByte(static_cast<Word>(addr), static_cast<Byte>(value));
+    // A device or watchpoint may have raised an interrupt or a stop, which the interpreter takes before the next
+    // instruction.
+    if (processor.WorkPending())
+        state->stop = 1;
+}
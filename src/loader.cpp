@@ -0,0 +1,167 @@
+#include "cpu6502/loader.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+// A contiguous range of image bytes and the address it is loaded at.
+struct Run {
+    u32 address;
+    std::size_t offset;
+    std::size_t size;
+};
+
+struct Image {
+    const Byte *data = nullptr;
+    std::vector<Byte> decoded;
+    std::vector<Run> runs;
+    bool has_entry = false;
+    u32 entry = 0;
+};
+
+Byte HexByte(const Byte *text, const std::size_t size, const std::size_t at, const std::size_t line) {
+    auto digit = [&](const std::size_t index) {
+        const int c = index < size ? std::tolower(text[index]) : 0;
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        throw std::runtime_error("Intel HEX line " + std::to_string(line) + " has a bad hex digit");
+    };
+    return static_cast<Byte>(digit(at) << 4 | digit(at + 1));
+}
+
+Image ParseIntelHex(const Byte *text, const std::size_t size) {
+    Image image;
+    u32 upper = 0;
+    std::size_t line = 0;
+    std::size_t at = 0;
+    std::vector<Byte> record;
+    for (;;) {
+        while (at < size && std::isspace(text[at]))
+            ++at;
+        if (at == size)
+            throw std::runtime_error("Intel HEX image has no end-of-file record");
+        ++line;
+        if (text[at] != ':')
+            throw std::runtime_error("Intel HEX line " + std::to_string(line) + " does not start with ':'");
+        ++at;
+
+        // Byte count, two address bytes, record type, data and checksum.
+        const std::size_t count = HexByte(text, size, at, line);
+        record.resize(count + 5);
+        Byte sum = 0;
+        for (std::size_t i = 0; i < record.size(); ++i) {
+            record[i] = HexByte(text, size, at + 2 * i, line);
+            sum = static_cast<Byte>(sum + record[i]);
+        }
+        at += 2 * record.size();
+        if (sum != 0)
+            throw std::runtime_error("Intel HEX line " + std::to_string(line) + " has a bad checksum");
+
+        const Byte *data = record.data() + 4;
+        const u32 offset = static_cast<u32>(record[1] << 8 | record[2]);
+        const u32 data32 = count >= 4 ? static_cast<u32>(data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3]) : 0;
+        switch (record[3]) {
+        case 0x00: {
+            const u32 address = upper + offset;
+            if (address + count > MAX_MEM)
+                throw std::out_of_range("Intel HEX line " + std::to_string(line) + " is outside the address space");
+            if (!image.runs.empty() && image.runs.back().address + image.runs.back().size == address)
+                image.runs.back().size += count;
+            else
+                image.runs.push_back({address, image.decoded.size(), count});
+            image.decoded.insert(image.decoded.end(), data, data + count);
+            break;
+        }
+        case 0x01:
+            return image;
+        case 0x02:
+        case 0x04:
+            if (count != 2)
+                throw std::runtime_error("Intel HEX line " + std::to_string(line) + " has a bad address record");
+            upper = static_cast<u32>(data[0] << 8 | data[1]) << (record[3] == 0x02 ? 4 : 16);
+            break;
+        case 0x03:
+        case 0x05:
+            if (count != 4)
+                throw std::runtime_error("Intel HEX line " + std::to_string(line) + " has a bad start record");
+            // CS:IP for a start segment record, a linear address otherwise.
+            image.entry = record[3] == 0x03 ? (data32 >> 16 << 4) + (data32 & 0xFFFF) : data32;
+            image.has_entry = true;
+            break;
+        default:
+            throw std::runtime_error("Intel HEX line " + std::to_string(line) + " has an unknown record type");
+        }
+    }
+}
+} // namespace
+
+ImageInfo ImageLoader::Load(Memory &memory, const Byte *Data, const std::size_t Size, const ImageFormat Format,
+                            const LoadOptions &Options) {
+    Image image;
+    switch (Format) {
+    case ImageFormat::Raw:
+        image.data = Data;
+        image.runs.push_back({Options.base, 0, Size});
+        break;
+    case ImageFormat::Prg:
+        if (Size < 2)
+            throw std::runtime_error("PRG image is missing its load address");
+        image.data = Data;
+        image.runs.push_back({static_cast<u32>(Data[0] | Data[1] << 8), 2, Size - 2});
+        break;
+    case ImageFormat::IntelHex:
+        image = ParseIntelHex(Data, Size);
+        image.data = image.decoded.data();
+        break;
+    }
+
+    ImageInfo info{0xFFFF, 0, 0, 0};
+    for (const Run &run : image.runs) {
+        if (run.address + run.size > MAX_MEM)
+            throw std::out_of_range("Image does not fit below $10000");
+        if (run.size == 0)
+            continue;
+        info.first = std::min(info.first, static_cast<Word>(run.address));
+        info.last = std::max(info.last, static_cast<Word>(run.address + run.size - 1));
+        info.bytes += static_cast<u32>(run.size);
+    }
+    if (info.bytes == 0)
+        info.first = info.last = image.runs.empty() ? Word{0} : static_cast<Word>(image.runs.front().address);
+    if (image.has_entry && image.entry >= MAX_MEM)
+        throw std::out_of_range("Intel HEX start address is outside the address space");
+    info.entry = image.has_entry ? static_cast<Word>(image.entry) : info.first;
+
+    for (const Run &run : image.runs)
+        memory.WriteBlock(static_cast<Word>(run.address), image.data + run.offset, run.size);
+    if (Options.set_reset_vector)
+        memory.WriteWord(0xFFFC, info.entry);
+    return info;
+}
+
+ImageInfo ImageLoader::LoadFile(Memory &memory, const std::string &Path, const ImageFormat Format,
+                                const LoadOptions &Options) {
+    std::ifstream in(Path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("Cannot open image " + Path);
+    const std::vector<Byte> bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    return Load(memory, bytes.data(), bytes.size(), Format, Options);
+}
+
+ImageFormat ImageLoader::FormatForPath(const std::string &Path) {
+    const std::size_t dot = Path.find_last_of('.');
+    std::string extension = dot == std::string::npos ? "" : Path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (extension == "prg")
+        return ImageFormat::Prg;
+    if (extension == "hex" || extension == "ihx")
+        return ImageFormat::IntelHex;
+    return ImageFormat::Raw;
+}
@@ -0,0 +1,480 @@
+#include <cpu6502/lockstep.hpp>
+#include <cpu6502/opcodes.hpp>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+constexpr unsigned LANES = Lockstep::MAX_LANES;
+
+// One byte for each of the LANES lanes. Masks hold 0x00 or 0xFF per lane.
+#if defined(__AVX2__)
+struct Vec {
+    __m256i v;
+
+    static Vec Load(const Byte *src) { return {_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src))}; }
+    static Vec Splat(const Byte value) { return {_mm256_set1_epi8(static_cast<char>(value))}; }
+    static Vec Select(const Vec mask, const Vec yes, const Vec no) {
+        return {_mm256_blendv_epi8(no.v, yes.v, mask.v)};
+    }
+    void Store(Byte *dst) const { _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), v); }
+    [[nodiscard]] u32 Bits() const { return static_cast<u32>(_mm256_movemask_epi8(v)); }
+
+    friend Vec operator==(const Vec l, const Vec r) { return {_mm256_cmpeq_epi8(l.v, r.v)}; }
+    friend Vec operator&(const Vec l, const Vec r) { return {_mm256_and_si256(l.v, r.v)}; }
+    friend Vec operator|(const Vec l, const Vec r) { return {_mm256_or_si256(l.v, r.v)}; }
+};
+constexpr const char *ISA = "avx2";
+#elif defined(__SSE2__)
+struct Vec {
+    __m128i lo;
+    __m128i hi;
+
+    static Vec Load(const Byte *src) {
+        return {_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 16))};
+    }
+    static Vec Splat(const Byte value) {
+        const __m128i v = _mm_set1_epi8(static_cast<char>(value));
+        return {v, v};
+    }
+    static Vec Select(const Vec mask, const Vec yes, const Vec no) {
+        return {_mm_or_si128(_mm_and_si128(mask.lo, yes.lo), _mm_andnot_si128(mask.lo, no.lo)),
+                _mm_or_si128(_mm_and_si128(mask.hi, yes.hi), _mm_andnot_si128(mask.hi, no.hi))};
+    }
+    void Store(Byte *dst) const {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), hi);
+    }
+    [[nodiscard]] u32 Bits() const {
+        return static_cast<u32>(_mm_movemask_epi8(lo)) | static_cast<u32>(_mm_movemask_epi8(hi)) << 16;
+    }
+
+    friend Vec operator==(const Vec l, const Vec r) { return {_mm_cmpeq_epi8(l.lo, r.lo), _mm_cmpeq_epi8(l.hi, r.hi)}; }
+    friend Vec operator&(const Vec l, const Vec r) { return {_mm_and_si128(l.lo, r.lo), _mm_and_si128(l.hi, r.hi)}; }
+    friend Vec operator|(const Vec l, const Vec r) { return {_mm_or_si128(l.lo, r.lo), _mm_or_si128(l.hi, r.hi)}; }
+};
+constexpr const char *ISA = "sse2";
+#else
+struct Vec {
+    Byte b[LANES];
+
+    static Vec Load(const Byte *src) {
+        Vec out{};
+        for (unsigned i = 0; i < LANES; ++i)
+            out.b[i] = src[i];
+        return out;
+    }
+    static Vec Splat(const Byte value) {
+        Vec out{};
+        for (Byte &lane : out.b)
+            lane = value;
+        return out;
+    }
+    static Vec Select(const Vec mask, const Vec yes, const Vec no) {
+        Vec out{};
+        for (unsigned i = 0; i < LANES; ++i)
+            out.b[i] = static_cast<Byte>((mask.b[i] & yes.b[i]) | (~mask.b[i] & no.b[i]));
+        return out;
+    }
+    void Store(Byte *dst) const {
+        for (unsigned i = 0; i < LANES; ++i)
+            dst[i] = b[i];
+    }
+    [[nodiscard]] u32 Bits() const {
+        u32 bits = 0;
+        for (unsigned i = 0; i < LANES; ++i)
+            bits |= static_cast<u32>(b[i] >> 7) << i;
+        return bits;
+    }
+
+    friend Vec operator==(const Vec l, const Vec r) {
+        Vec out{};
+        for (unsigned i = 0; i < LANES; ++i)
+            out.b[i] = l.b[i] == r.b[i] ? 0xFF : 0x00;
+        return out;
+    }
+    friend Vec operator&(const Vec l, const Vec r) {
+        Vec out{};
+        for (unsigned i = 0; i < LANES; ++i)
+            out.b[i] = static_cast<Byte>(l.b[i] & r.b[i]);
+        return out;
+    }
+    friend Vec operator|(const Vec l, const Vec r) {
+        Vec out{};
+        for (unsigned i = 0; i < LANES; ++i)
+            out.b[i] = static_cast<Byte>(l.b[i] | r.b[i]);
+        return out;
+    }
+};
+constexpr const char *ISA = "scalar";
+#endif
+
+enum class Kind : Byte { None, Load, Store, Nop };
+
+enum class Reg : Byte { A, X, Y };
+
+// Vector kernel for an opcode, taken from the opcode table. Cycles include fetch; page_cross kernels add one more
+// when the indexed address leaves the base page.
+struct Kernel {
+    Kind kind;
+    AddressingMode mode;
+    Reg reg;
+    Byte cycles;
+    bool page_cross;
+};
+
+constexpr Kernel KernelFor(const Byte opcode) {
+    const OpcodeInfo &info = OPCODES[opcode];
+    const bool penalty = info.penalty == PageCrossPenalty::IndexedRead;
+    switch (info.mnemonic) {
+    case Mnemonic::LDA:
+        return {Kind::Load, info.mode, Reg::A, info.cycles, penalty};
+    case Mnemonic::LDX:
+        return {Kind::Load, info.mode, Reg::X, info.cycles, penalty};
+    case Mnemonic::LDY:
+        return {Kind::Load, info.mode, Reg::Y, info.cycles, penalty};
+    case Mnemonic::STA:
+        return {Kind::Store, info.mode, Reg::A, info.cycles, penalty};
+    case Mnemonic::STX:
+        return {Kind::Store, info.mode, Reg::X, info.cycles, penalty};
+    case Mnemonic::STY:
+        return {Kind::Store, info.mode, Reg::Y, info.cycles, penalty};
+    case Mnemonic::NOP:
+        return {Kind::Nop, info.mode, Reg::A, info.cycles, penalty};
+    default:
+        return {Kind::None, AddressingMode::Implied, Reg::A, 0, false};
+    }
+}
+
+Word MakeWord(const Byte lo, const Byte hi) { return static_cast<Word>((static_cast<Word>(hi) << 8) | lo); }
+
+bool CrossesPage(const Word base, const Word addr) { return (base ^ addr) & 0xFF00; }
+
+unsigned LowestLane(const u32 lanes) {
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctz(lanes));
+#else
+    unsigned lane = 0;
+    while (!(lanes >> lane & 1))
+        ++lane;
+    return lane;
+#endif
+}
+
+Vec GroupMask(const u32 group) {
+    alignas(32) Byte mask[LANES];
+    for (unsigned lane = 0; lane < LANES; ++lane)
+        mask[lane] = group >> lane & 1 ? 0xFF : 0x00;
+    return Vec::Load(mask);
+}
+
+// True when every lane of the group holds the leader's byte.
+bool Uniform(const Byte *bytes, const u32 group, const unsigned leader) {
+    return ((Vec::Load(bytes) == Vec::Splat(bytes[leader])).Bits() & group) == group;
+}
+
+// The lanes of one group at one instruction, as seen by the addressing modes.
+struct View {
+    const Byte *memory;
+    const Byte *x;
+    const Byte *y;
+    u32 group;
+    unsigned leader;
+
+    [[nodiscard]] const Byte *Row(const Word address) const { return memory + static_cast<std::size_t>(address) * LANES; }
+    [[nodiscard]] Byte At(const Word address, const unsigned lane) const { return Row(address)[lane]; }
+};
+
+// Resolves the operand address of every lane in the group. Returns true when the lanes share one address, which is
+// then stored for the leader. crossed collects the lanes whose indexed address left the base page.
+bool Resolve(const View &view, const AddressingMode mode, const Word operand, Word *addresses, u32 &crossed) {
+    const u32 group = view.group;
+    const unsigned leader = view.leader;
+    const Byte zp = static_cast<Byte>(operand);
+    switch (mode) {
+    case AddressingMode::ZeroPage:
+    case AddressingMode::Absolute:
+        addresses[leader] = operand;
+        return true;
+    case AddressingMode::ZeroPageX:
+    case AddressingMode::ZeroPageY: {
+        const Byte *index = mode == AddressingMode::ZeroPageX ? view.x : view.y;
+        if (Uniform(index, group, leader)) {
+            addresses[leader] = static_cast<Byte>(zp + index[leader]);
+            return true;
+        }
+        for (u32 lanes = group; lanes; lanes &= lanes - 1) {
+            const unsigned lane = LowestLane(lanes);
+            addresses[lane] = static_cast<Byte>(zp + index[lane]);
+        }
+        return false;
+    }
+    case AddressingMode::AbsoluteX:
+    case AddressingMode::AbsoluteY: {
+        const Byte *index = mode == AddressingMode::AbsoluteX ? view.x : view.y;
+        if (Uniform(index, group, leader)) {
+            addresses[leader] = static_cast<Word>(operand + index[leader]);
+            crossed = CrossesPage(operand, addresses[leader]) ? group : 0;
+            return true;
+        }
+        for (u32 lanes = group; lanes; lanes &= lanes - 1) {
+            const unsigned lane = LowestLane(lanes);
+            addresses[lane] = static_cast<Word>(operand + index[lane]);
+            if (CrossesPage(operand, addresses[lane]))
+                crossed |= 1u << lane;
+        }
+        return false;
+    }
+    case AddressingMode::IndexedIndirectX:
+        if (Uniform(view.x, group, leader)) {
+            const Byte pointer = static_cast<Byte>(zp + view.x[leader]);
+            const Byte *lo = view.Row(pointer);
+            const Byte *hi = view.Row(static_cast<Byte>(pointer + 1));
+            if (Uniform(lo, group, leader) && Uniform(hi, group, leader)) {
+                addresses[leader] = MakeWord(lo[leader], hi[leader]);
+                return true;
+            }
+        }
+        for (u32 lanes = group; lanes; lanes &= lanes - 1) {
+            const unsigned lane = LowestLane(lanes);
+            const Byte pointer = static_cast<Byte>(zp + view.x[lane]);
+            addresses[lane] = MakeWord(view.At(pointer, lane), view.At(static_cast<Byte>(pointer + 1), lane));
+        }
+        return false;
+    case AddressingMode::IndirectIndexedY: {
+        const Byte *lo = view.Row(zp);
+        const Byte *hi = view.Row(static_cast<Byte>(zp + 1));
+        if (Uniform(lo, group, leader) && Uniform(hi, group, leader) && Uniform(view.y, group, leader)) {
+            const Word base = MakeWord(lo[leader], hi[leader]);
+            addresses[leader] = static_cast<Word>(base + view.y[leader]);
+            crossed = CrossesPage(base, addresses[leader]) ? group : 0;
+            return true;
+        }
+        for (u32 lanes = group; lanes; lanes &= lanes - 1) {
+            const unsigned lane = LowestLane(lanes);
+            const Word base = MakeWord(lo[lane], hi[lane]);
+            addresses[lane] = static_cast<Word>(base + view.y[lane]);
+            if (CrossesPage(base, addresses[lane]))
+                crossed |= 1u << lane;
+        }
+        return false;
+    }
+    default:
+        return true;
+    }
+}
+
+} // namespace
+
+Lockstep::Lockstep(const unsigned lanes) : lane_count(lanes), memory(static_cast<std::size_t>(MAX_MEM) * MAX_LANES) {
+    if (lanes == 0 || lanes > MAX_LANES)
+        throw std::invalid_argument("Lockstep lane count must be between 1 and MAX_LANES");
+    // Same status as a freshly constructed CPU: only the hardwired unused bit is set
+    for (Byte &status : p)
+        status = 0x20;
+}
+
+unsigned Lockstep::Lanes() const { return lane_count; }
+
+void Lockstep::Load(const unsigned lane, const CPU &cpu, const Memory &source) {
+    if (lane >= lane_count)
+        throw std::out_of_range("Lockstep lane out of range");
+    for (u32 addr = 0; addr < MAX_MEM; ++addr)
+        memory[addr * MAX_LANES + lane] = source.ReadByte(static_cast<Word>(addr));
+    a[lane] = cpu.A;
+    x[lane] = cpu.X;
+    y[lane] = cpu.Y;
+    p[lane] = cpu.StatusRegister();
+    pc[lane] = cpu.PC;
+    sp[lane] = cpu.SP;
+    cycles[lane] = cpu.cycles;
+}
+
+void Lockstep::Store(const unsigned lane, CPU &cpu, Memory &destination) const {
+    if (lane >= lane_count)
+        throw std::out_of_range("Lockstep lane out of range");
+    for (u32 addr = 0; addr < MAX_MEM; ++addr)
+        destination.WriteByte(static_cast<Word>(addr), memory[addr * MAX_LANES + lane]);
+    cpu.A = a[lane];
+    cpu.X = x[lane];
+    cpu.Y = y[lane];
+    cpu.SetStatusRegister(p[lane]);
+    cpu.PC = pc[lane];
+    cpu.SP = sp[lane];
+    cpu.cycles = cycles[lane];
+}
+
+Byte Lockstep::ReadByte(const unsigned lane, const Word address) const {
+    if (lane >= lane_count)
+        throw std::out_of_range("Lockstep lane out of range");
+    return memory[static_cast<std::size_t>(address) * MAX_LANES + lane];
+}
+
+void Lockstep::Execute(const u32 exec_cycles) {
+    budget = exec_cycles;
+    u32 pending = 0;
+    for (unsigned lane = 0; lane < lane_count; ++lane) {
+        start[lane] = cycles[lane];
+        if (exec_cycles > 0)
+            pending |= 1u << lane;
+    }
+    while (pending) {
+        // The furthest-behind lane leads, which lets lanes that took different paths meet again at the same PC.
+        unsigned leader = LowestLane(pending);
+        for (u32 lanes = pending; lanes; lanes &= lanes - 1) {
+            const unsigned lane = LowestLane(lanes);
+            if (Elapsed(lane) < Elapsed(leader))
+                leader = lane;
+        }
+        u32 group = 0;
+        for (u32 lanes = pending; lanes; lanes &= lanes - 1) {
+            const unsigned lane = LowestLane(lanes);
+            if (pc[lane] == pc[leader])
+                group |= 1u << lane;
+        }
+        pending &= ~RunGroup(group, leader);
+    }
+}
+
+// Runs the lanes of a group, which all start at the leader's PC, one instruction at a time until every lane has
+// either run its budget (returned as finished) or left the group because its instruction bytes differ.
+// PC and the cycles all lanes have in common are only written back when the group changes.
+u32 Lockstep::RunGroup(u32 group, const unsigned leader) {
+    u32 finished = 0;
+    Word at = pc[leader];
+    u32 spent = 0;
+    u32 slack = Slack(group);
+    Vec active = GroupMask(group);
+    for (;;) {
+        const View view{memory.data(), x, y, group, leader};
+        const Byte opcode = view.At(at, leader);
+        const Kernel kernel = KernelFor(opcode);
+        const Byte length = kernel.kind == Kind::None ? 1 : OPCODES[opcode].length;
+        u32 same = group;
+        for (Byte i = 0; i < length; ++i) {
+            const Byte *row = view.Row(static_cast<Word>(at + i));
+            same &= (Vec::Load(row) == Vec::Splat(row[leader])).Bits();
+        }
+        if (same != group) {
+            Flush(group, at, spent);
+            spent = 0;
+            group = same;
+            slack = Slack(group);
+            active = GroupMask(group);
+            continue;
+        }
+        if (kernel.kind == Kind::None) {
+            Flush(group, at, spent);
+            for (u32 lanes = group; lanes; lanes &= lanes - 1)
+                RunScalar(LowestLane(lanes));
+            return finished | group;
+        }
+
+        const Word operand = length == 3 ? MakeWord(view.At(static_cast<Word>(at + 1), leader),
+                                                     view.At(static_cast<Word>(at + 2), leader))
+                                         : view.At(static_cast<Word>(at + 1), leader);
+        u32 cost = kernel.cycles;
+        u32 penalised = 0;
+        Byte *reg = kernel.reg == Reg::A ? a : kernel.reg == Reg::X ? x : y;
+        if (kernel.kind == Kind::Load) {
+            Vec value{};
+            if (kernel.mode == AddressingMode::Immediate) {
+                value = Vec::Splat(static_cast<Byte>(operand));
+            } else {
+                Word addresses[MAX_LANES];
+                u32 crossed = 0;
+                const bool shared = Resolve(view, kernel.mode, operand, addresses, crossed);
+                crossed = kernel.page_cross ? crossed : 0;
+                if (shared) {
+                    value = Vec::Load(view.Row(addresses[leader]));
+                    cost += crossed ? 1 : 0;
+                } else {
+                    alignas(32) Byte gathered[MAX_LANES]{};
+                    for (u32 lanes = group; lanes; lanes &= lanes - 1) {
+                        const unsigned lane = LowestLane(lanes);
+                        gathered[lane] = view.At(addresses[lane], lane);
+                    }
+                    value = Vec::Load(gathered);
+                    penalised = crossed;
+                }
+            }
+            Vec::Select(active, value, Vec::Load(reg)).Store(reg);
+            const Vec status = Vec::Load(p);
+            const Vec updated = (status & Vec::Splat(0x7D)) | ((value == Vec::Splat(0x00)) & Vec::Splat(0x02)) |
+                                (value & Vec::Splat(0x80));
+            Vec::Select(active, updated, status).Store(p);
+        } else if (kernel.kind == Kind::Store) {
+            Word addresses[MAX_LANES];
+            u32 crossed = 0;
+            if (Resolve(view, kernel.mode, operand, addresses, crossed)) {
+                Byte *row = memory.data() + static_cast<std::size_t>(addresses[leader]) * MAX_LANES;
+                Vec::Select(active, Vec::Load(reg), Vec::Load(row)).Store(row);
+            } else {
+                for (u32 lanes = group; lanes; lanes &= lanes - 1) {
+                    const unsigned lane = LowestLane(lanes);
+                    memory[static_cast<std::size_t>(addresses[lane]) * MAX_LANES + lane] = reg[lane];
+                }
+            }
+        }
+
+        at = static_cast<Word>(at + length);
+        spent += cost;
+        if (!penalised && cost < slack) {
+            slack -= cost;
+            continue;
+        }
+        Flush(group, at, spent);
+        spent = 0;
+        for (u32 lanes = penalised; lanes; lanes &= lanes - 1)
+            ++cycles[LowestLane(lanes)];
+        u32 done = 0;
+        for (u32 lanes = group; lanes; lanes &= lanes - 1) {
+            const unsigned lane = LowestLane(lanes);
+            if (Elapsed(lane) >= budget)
+                done |= 1u << lane;
+        }
+        finished |= done;
+        group &= ~done;
+        if (!group)
+            return finished;
+        slack = Slack(group);
+        active = GroupMask(group);
+    }
+}
+
+void Lockstep::Flush(const u32 group, const Word at, const u32 spent) {
+    for (u32 lanes = group; lanes; lanes &= lanes - 1) {
+        const unsigned lane = LowestLane(lanes);
+        pc[lane] = at;
+        cycles[lane] += spent;
+    }
+}
+
+u32 Lockstep::Slack(const u32 group) const {
+    u32 slack = ~0u;
+    for (u32 lanes = group; lanes; lanes &= lanes - 1) {
+        const unsigned lane = LowestLane(lanes);
+        if (budget - Elapsed(lane) < slack)
+            slack = budget - Elapsed(lane);
+    }
+    return slack;
+}
+
+void Lockstep::RunScalar(const unsigned lane) {
+    if (!scratch)
+        scratch = std::make_unique<Memory>();
+    CPU cpu(*scratch);
+    Store(lane, cpu, *scratch);
+    cpu.Execute(budget - Elapsed(lane));
+    Load(lane, cpu, *scratch);
+    ++fallbacks;
+}
+
+u32 Lockstep::ScalarFallbacks() const { return fallbacks; }
+
+const char *Lockstep::Isa() { return ISA; }
@@ -0,0 +1,7 @@
+#include "cpu6502/machine.hpp"
+
+Machine::Machine() : cpu(memory) {}
+
+Machine::Machine(const Machine &Other) : memory(Other.memory), cpu(memory, Other.cpu) {}
+
+Machine Machine::Fork() const { return *this; }
@@ -1,10 +1,174 @@
 #include "cpu6502/mem.hpp"
 
-Memory::Memory() = default;
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
 
-Byte Memory::ReadByte(const Word Address) const { return Data[Address]; }
+struct Memory::RamPage {
+    std::atomic<u32> refs{1};
+    Byte *bytes = storage;
+    // Set when bytes point into a save-state mapping, which then lives as long as the page.
+    std::shared_ptr<void> backing;
+    Byte storage[PAGE_BYTES]{};
+};
 
-void Memory::WriteByte(const Word Address, const Byte Value) { Data[Address] = Value; }
+// Shared by every fresh Memory without reference counting and always copied before a write.
+Memory::RamPage *Memory::ZeroPage() {
+    static RamPage zero;
+    return &zero;
+}
+Memory::Memory() {
+    for (u32 page = 0; page < PAGE_COUNT; ++page) {
+        Ram[page] = ZeroPage();
+        UnmapPage(static_cast<Byte>(page));
+    }
+}
+
+Memory::Memory(const Memory &Other) { Share(Other); }
+
+Memory &Memory::operator=(const Memory &Other) {
+    if (this != &Other) {
+        for (u32 page = 0; page < PAGE_COUNT; ++page) {
+            if (CodePages[page])
+                NotifyCodeWrite(static_cast<Byte>(page));
+        }
+        Share(Other);
+    }
+    return *this;
+}
+
+Memory::~Memory() {
+    for (RamPage *page : Ram)
+        Drop(page);
+}
+
+Memory Memory::Fork() const { return *this; }
+
+void Memory::Share(const Memory &Other) {
+    std::memcpy(HostRead, Other.HostRead, sizeof(HostRead));
+    std::memcpy(HostWrite, Other.HostWrite, sizeof(HostWrite));
+    std::memcpy(Devices, Other.Devices, sizeof(Devices));
+    for (u32 page = 0; page < PAGE_COUNT; ++page) {
+        ReadPages[page] = Devices[page] || ReadWatched[page] ? nullptr : HostRead[page];
+        RamPage *shared = Other.Ram[page];
+        // Pages already shared with Other, which after a previous fork is most of them, need no reference update.
+        if (Ram[page] != shared) {
+            Drop(Ram[page]);
+            Ram[page] = shared;
+            if (shared != ZeroPage())
+                shared->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        // Both sides now copy an internal page before writing it. The source store is skipped when it already
+        // does, so forking an already shared Memory only reads it.
+        if (HostRead[page] == shared->bytes) {
+            WritePages[page] = nullptr;
+            if (Other.WritePages[page])
+                Other.WritePages[page] = nullptr;
+        } else {
+            WritePages[page] = Devices[page] || WriteWatched[page] ? nullptr : HostWrite[page];
+        }
+    }
+}
+
+void Memory::Drop(RamPage *page) {
+    if (page && page != ZeroPage() && page->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete page;
+}
+
+bool Memory::IsInternalPage(const Byte Page) const { return HostRead[Page] == Ram[Page]->bytes; }
+
+void Memory::RefreshPage(const Byte Page) {
+    ReadPages[Page] = Devices[Page] || ReadWatched[Page] ? nullptr : HostRead[Page];
+    WritePages[Page] =
+        Devices[Page] || CodePages[Page] || WriteWatched[Page] || IsSharedPage(Page) ? nullptr : HostWrite[Page];
+}
+
+Byte Memory::ReadSlow(const Word Address) const {
+    const Byte page = static_cast<Byte>(Address >> 8);
+    const Byte value = Devices[page] ? Devices[page]->Read(Address) : HostRead[page][Address & 0xFF];
+    if (ReadWatched[page])
+        Watcher->OnWatchedAccess(Address, value, false);
+    return value;
+}
+
+void Memory::WriteSlow(const Word Address, const Byte Value) {
+    const Byte page = static_cast<Byte>(Address >> 8);
+    if (Devices[page]) {
+        Devices[page]->Write(Address, Value);
+    } else if (HostWrite[page]) {
+        if (IsSharedPage(page))
+            OwnPage(page, true);
+        HostWrite[page][Address & 0xFF] = Value;
+        if (CodePages[page])
+            NotifyCodeWrite(page);
+        else
+            RefreshPage(page);
+    }
+    // Writes to ROM are ignored but still reported.
+    if (WriteWatched[page])
+        Watcher->OnWatchedAccess(Address, Value, true);
+}
+
+void Memory::OwnPage(const Byte Page, const bool KeepContents) {
+    auto *copy = new RamPage;
+    if (KeepContents)
+        std::memcpy(copy->bytes, Ram[Page]->bytes, PAGE_BYTES);
+    Drop(Ram[Page]);
+    Ram[Page] = copy;
+    HostRead[Page] = copy->bytes;
+    HostWrite[Page] = copy->bytes;
+}
+
+void Memory::WriteBlock(const Word Address, const Byte *Bytes, const std::size_t Size) {
+    if (Address + Size > MAX_MEM)
+        throw std::out_of_range("Memory block exceeds the address space");
+    u32 address = Address;
+    const Byte *end = Bytes + Size;
+    while (Bytes != end) {
+        const Byte page = static_cast<Byte>(address >> 8);
+        const u32 offset = address & 0xFF;
+        const u32 chunk = std::min(PAGE_BYTES - offset, static_cast<u32>(end - Bytes));
+        if (Devices[page]) {
+            for (u32 i = 0; i < chunk; ++i)
+                Devices[page]->Write(static_cast<Word>(address + i), Bytes[i]);
+        } else if (HostWrite[page]) {
+            // A shared page that is overwritten in full is replaced without copying its old contents.
+            if (IsSharedPage(page))
+                OwnPage(page, chunk != PAGE_BYTES);
+            std::memcpy(HostWrite[page] + offset, Bytes, chunk);
+            if (CodePages[page])
+                NotifyCodeWrite(page);
+            else
+                RefreshPage(page);
+        }
+        address += chunk;
+        Bytes += chunk;
+    }
+}
+
+const Byte *Memory::InternalPage(const Byte Page) const { return Ram[Page]->bytes; }
+
+void Memory::AdoptPage(const Byte Page, Byte *Bytes, std::shared_ptr<void> Backing) {
+    if (CodePages[Page])
+        NotifyCodeWrite(Page);
+    RamPage *page = ZeroPage();
+    if (Bytes) {
+        page = new RamPage;
+        page->bytes = Bytes;
+        page->backing = std::move(Backing);
+    }
+    const bool internal = IsInternalPage(Page);
+    Drop(Ram[Page]);
+    Ram[Page] = page;
+    if (internal)
+        MapRam(Page, page->bytes);
+}
+
+Word Memory::PeekWord(const Word Address) const {
+    return static_cast<Word>(PeekByte(Address) | PeekByte(static_cast<Word>(Address + 1)) << 8);
+}
 
 Word Memory::ReadWord(const Word Address) const {
     const Byte lo = ReadByte(Address);
@@ -18,3 +182,83 @@ void Memory::WriteWord(const Word Address, const Word Value) {
     WriteByte(Address, lo);
     WriteByte(static_cast<Word>(Address + 1), hi);
 }
+
+void Memory::MapRam(const Byte Page, Byte *Host) {
+    HostRead[Page] = Host;
+    HostWrite[Page] = Host;
+    Devices[Page] = nullptr;
+    if (CodePages[Page])
+        NotifyCodeWrite(Page);
+    RefreshPage(Page);
+}
+
+void Memory::MapRom(const Byte Page, const Byte *Host) {
+    HostRead[Page] = Host;
+    HostWrite[Page] = nullptr;
+    Devices[Page] = nullptr;
+    if (CodePages[Page])
+        NotifyCodeWrite(Page);
+    RefreshPage(Page);
+}
+
+void Memory::MapDevice(const Byte FirstPage, const Byte LastPage, BusDevice *Device) {
+    for (u32 page = FirstPage; page <= LastPage; ++page) {
+        Devices[page] = Device;
+        if (CodePages[page])
+            NotifyCodeWrite(static_cast<Byte>(page));
+        RefreshPage(static_cast<Byte>(page));
+    }
+}
+
+void Memory::UnmapPage(const Byte Page) { MapRam(Page, Ram[Page]->bytes); }
+
+bool Memory::IsDevicePage(const Byte Page) const { return Devices[Page] != nullptr; }
+
+bool Memory::IsSharedPage(const Byte Page) const {
+    return IsInternalPage(Page) && (Ram[Page] == ZeroPage() || Ram[Page]->refs.load(std::memory_order_acquire) > 1);
+}
+
+void Memory::MarkCodePage(const Byte Page) {
+    CodePages[Page] = CodeListener != nullptr;
+    RefreshPage(Page);
+}
+
+void Memory::SetCodeWriteListener(CodeWriteListener *Listener) {
+    if (Listener && CodeListener && CodeListener != Listener)
+        throw std::logic_error("Memory already has a code write listener");
+    CodeListener = Listener;
+    for (u32 page = 0; page < PAGE_COUNT; ++page) {
+        CodePages[page] = false;
+        RefreshPage(static_cast<Byte>(page));
+    }
+}
+
+void Memory::RemoveCodeWriteListener(const CodeWriteListener *Listener) {
+    if (CodeListener == Listener)
+        SetCodeWriteListener(nullptr);
+}
+
+void Memory::NotifyCodeWrite(const Byte page) {
+    CodePages[page] = false;
+    RefreshPage(page);
+    CodeListener->OnCodeWrite(page);
+}
+
+void Memory::WatchPage(const Byte Page, const bool Reads, const bool Writes) {
+    ReadWatched[Page] = Reads && Watcher != nullptr;
+    WriteWatched[Page] = Writes && Watcher != nullptr;
+    RefreshPage(Page);
+}
+
+void Memory::SetWatchListener(WatchListener *Listener) {
+    if (Listener && Watcher && Watcher != Listener)
+        throw std::logic_error("Memory already has a watch listener");
+    Watcher = Listener;
+    for (u32 page = 0; page < PAGE_COUNT; ++page)
+        WatchPage(static_cast<Byte>(page), false, false);
+}
+
+void Memory::RemoveWatchListener(const WatchListener *Listener) {
+    if (Watcher == Listener)
+        SetWatchListener(nullptr);
+}
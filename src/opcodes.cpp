@@ -0,0 +1,70 @@
+#include "cpu6502/opcodes.hpp"
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+
+std::string Disassemble(const Word pc, const Byte opcode, const Word operand) {
+    const OpcodeInfo &info = OPCODES[opcode];
+    std::ostringstream out;
+    out << std::hex << std::uppercase << std::setfill('0');
+    if (info.mnemonic == Mnemonic::Illegal) {
+        out << ".byte $" << std::setw(2) << static_cast<u32>(opcode);
+        return out.str();
+    }
+    out << MnemonicName(info.mnemonic);
+    const u32 zp = operand & 0xFF;
+    switch (info.mode) {
+    case AddressingMode::Implied:
+        break;
+    case AddressingMode::Accumulator:
+        out << " A";
+        break;
+    case AddressingMode::Immediate:
+        out << " #$" << std::setw(2) << zp;
+        break;
+    case AddressingMode::ZeroPage:
+        out << " $" << std::setw(2) << zp;
+        break;
+    case AddressingMode::ZeroPageX:
+        out << " $" << std::setw(2) << zp << ",X";
+        break;
+    case AddressingMode::ZeroPageY:
+        out << " $" << std::setw(2) << zp << ",Y";
+        break;
+    case AddressingMode::Absolute:
+        out << " $" << std::setw(4) << operand;
+        break;
+    case AddressingMode::AbsoluteX:
+        out << " $" << std::setw(4) << operand << ",X";
+        break;
+    case AddressingMode::AbsoluteY:
+        out << " $" << std::setw(4) << operand << ",Y";
+        break;
+    case AddressingMode::Indirect:
+        out << " ($" << std::setw(4) << operand << ')';
+        break;
+    case AddressingMode::IndexedIndirectX:
+        out << " ($" << std::setw(2) << zp << ",X)";
+        break;
+    case AddressingMode::IndirectIndexedY:
+        out << " ($" << std::setw(2) << zp << "),Y";
+        break;
+    case AddressingMode::Relative:
+        out << " $" << std::setw(4) << static_cast<Word>(pc + 2 + static_cast<std::int8_t>(zp));
+        break;
+    }
+    return out.str();
+}
+
+Byte Disassemble(const Memory &memory, const Word pc, std::string &text) {
+    const Byte opcode = memory.ReadByte(pc);
+    const Byte length = OPCODES[opcode].length;
+    Word operand = 0;
+    if (length == 3)
+        operand = memory.ReadWord(static_cast<Word>(pc + 1));
+    else if (length == 2)
+        operand = memory.ReadByte(static_cast<Word>(pc + 1));
+    text = Disassemble(pc, opcode, operand);
+    return length;
+}
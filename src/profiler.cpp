@@ -0,0 +1,132 @@
+#include "cpu6502/profiler.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <ostream>
+
+namespace {
+void WriteShare(std::ostream &out, const u64 part, const u64 total) {
+    const double share = total != 0 ? 100.0 * static_cast<double>(part) / static_cast<double>(total) : 0.0;
+    out << std::fixed << std::setprecision(1) << std::setw(7) << share << "%\n";
+}
+} // namespace
+
+Profiler::Profiler() { Clear(); }
+
+void Profiler::Clear() {
+    pc_executions.assign(MAX_MEM, 0);
+    pc_cycles.assign(MAX_MEM, 0);
+    pc_crosses.assign(MAX_MEM, 0);
+    pc_opcodes.assign(MAX_MEM, 0);
+    std::fill(std::begin(opcode_executions), std::end(opcode_executions), 0);
+    std::fill(std::begin(opcode_cycles), std::end(opcode_cycles), 0);
+    std::fill(std::begin(opcode_crosses), std::end(opcode_crosses), 0);
+    frames.assign(1, {0, NO_FRAME, NO_FRAME, NO_FRAME, 0});
+    frame = 0;
+    pending_crosses = 0;
+}
+
+u64 Profiler::Executions(const Word pc) const { return pc_executions[pc]; }
+
+u64 Profiler::Cycles(const Word pc) const { return pc_cycles[pc]; }
+
+u64 Profiler::PageCrosses(const Word pc) const { return pc_crosses[pc]; }
+
+u64 Profiler::OpcodeExecutions(const Byte opcode) const { return opcode_executions[opcode]; }
+
+u64 Profiler::OpcodeCycles(const Byte opcode) const { return opcode_cycles[opcode]; }
+
+u64 Profiler::OpcodePageCrosses(const Byte opcode) const { return opcode_crosses[opcode]; }
+
+u64 Profiler::TotalExecutions() const {
+    return std::accumulate(std::begin(opcode_executions), std::end(opcode_executions), u64{0});
+}
+
+u64 Profiler::TotalCycles() const {
+    return std::accumulate(std::begin(opcode_cycles), std::end(opcode_cycles), u64{0});
+}
+
+void Profiler::Call(const Word target) {
+    u32 child = frames[frame].first_child;
+    while (child != NO_FRAME && frames[child].entry != target)
+        child = frames[child].next_sibling;
+    if (child == NO_FRAME) {
+        child = static_cast<u32>(frames.size());
+        frames.push_back({target, frame, NO_FRAME, frames[frame].first_child, 0});
+        frames[frame].first_child = child;
+    }
+    frame = child;
+}
+
+void Profiler::Return() {
+    if (frames[frame].parent != NO_FRAME)
+        frame = frames[frame].parent;
+}
+
+void Profiler::Report(std::ostream &out, const std::size_t top) const {
+    const std::ios::fmtflags flags = out.flags();
+    const char fill = out.fill(' ');
+    const u64 total = TotalCycles();
+    out << "instructions " << TotalExecutions() << ", cycles " << total << '\n';
+
+    std::vector<Word> hot;
+    for (u32 pc = 0; pc < MAX_MEM; ++pc) {
+        if (pc_executions[pc] != 0)
+            hot.push_back(static_cast<Word>(pc));
+    }
+    const auto by_cycles = [this](const Word a, const Word b) {
+        return pc_cycles[a] != pc_cycles[b] ? pc_cycles[a] > pc_cycles[b] : a < b;
+    };
+    const std::size_t shown = std::min(top, hot.size());
+    std::partial_sort(hot.begin(), hot.begin() + static_cast<std::ptrdiff_t>(shown), hot.end(), by_cycles);
+    out << "  PC  OP   EXECUTIONS       CYCLES  PAGE-X   SHARE\n";
+    for (std::size_t i = 0; i < shown; ++i) {
+        const Word pc = hot[i];
+        out << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << pc << "  " << std::setw(2)
+            << static_cast<u32>(pc_opcodes[pc]) << std::dec << std::setfill(' ') << std::setw(13)
+            << pc_executions[pc] << std::setw(13) << pc_cycles[pc] << std::setw(8) << pc_crosses[pc];
+        WriteShare(out, pc_cycles[pc], total);
+    }
+
+    std::vector<u32> opcodes;
+    for (u32 opcode = 0; opcode < 256; ++opcode) {
+        if (opcode_executions[opcode] != 0)
+            opcodes.push_back(opcode);
+    }
+    std::sort(opcodes.begin(), opcodes.end(), [this](const u32 a, const u32 b) {
+        return opcode_cycles[a] != opcode_cycles[b] ? opcode_cycles[a] > opcode_cycles[b] : a < b;
+    });
+    out << "      OP   EXECUTIONS       CYCLES  PAGE-X   SHARE\n";
+    for (const u32 opcode : opcodes) {
+        out << "      " << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << opcode << std::dec
+            << std::setfill(' ') << std::setw(13) << opcode_executions[opcode] << std::setw(13)
+            << opcode_cycles[opcode] << std::setw(8) << opcode_crosses[opcode];
+        WriteShare(out, opcode_cycles[opcode], total);
+    }
+    out.fill(fill);
+    out.flags(flags);
+}
+
+void Profiler::WriteFrame(std::ostream &out, const u32 index) const {
+    if (frames[index].parent == NO_FRAME) {
+        out << "root";
+        return;
+    }
+    WriteFrame(out, frames[index].parent);
+    out << ";$" << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << frames[index].entry
+        << std::dec;
+}
+
+void Profiler::WriteFolded(std::ostream &out) const {
+    const std::ios::fmtflags flags = out.flags();
+    const char fill = out.fill();
+    for (u32 index = 0; index < frames.size(); ++index) {
+        if (frames[index].cycles == 0)
+            continue;
+        WriteFrame(out, index);
+        out << ' ' << frames[index].cycles << '\n';
+    }
+    out.fill(fill);
+    out.flags(flags);
+}
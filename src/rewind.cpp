@@ -0,0 +1,145 @@
+#include <cpu6502/debugger.hpp>
+#include <cpu6502/rewind.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+Rewind::Rewind(CPU &processor, const u32 checkpoint_interval, const std::size_t journal_bytes)
+    : cpu(processor), interval(checkpoint_interval), journal_limit(journal_bytes) {
+    if (interval == 0)
+        throw std::invalid_argument("Rewind: checkpoint interval must be positive");
+    Checkpoint();
+}
+
+u32 Rewind::Age(const u32 cycle) const { return cycle - snapshots.front().cycles; }
+
+std::size_t Rewind::Diverged(const Memory &older, const Memory &newer) {
+    std::size_t bytes = 0;
+    for (u32 page = 0; page < PAGE_COUNT; ++page) {
+        if (older.Ram[page] != newer.Ram[page] && older.Ram[page] != Memory::ZeroPage())
+            bytes += PAGE_BYTES;
+    }
+    return bytes;
+}
+
+void Rewind::Restore(const Snapshot &snapshot) {
+    cpu.mem = snapshot.memory;
+    cpu.PC = snapshot.pc;
+    cpu.SP = snapshot.sp;
+    cpu.A = snapshot.a;
+    cpu.X = snapshot.x;
+    cpu.Y = snapshot.y;
+    cpu.SetStatusRegister(snapshot.p);
+    cpu.irq_line = snapshot.irq;
+    cpu.nmi_pending = snapshot.nmi;
+    cpu.irq_delayed = snapshot.irq_delayed;
+    cpu.cycles = snapshot.cycles;
+    cpu.cli_cycles = snapshot.cycles;
+}
+
+void Rewind::Truncate() {
+    const u32 age = Age(cpu.cycles);
+    while (snapshots.size() > 1 && Age(snapshots.back().cycles) > age)
+        snapshots.pop_back();
+    journal -= snapshots.back().bytes;
+    snapshots.back().bytes = 0;
+    latest = cpu.cycles;
+}
+
+void Rewind::Replay(const u32 count, std::vector<u32> *starts) {
+    // Breakpoints and watchpoints were reported on the way forward, so the replay does not stop at them again.
+    Debugger *attached = cpu.debugger;
+    cpu.debugger = nullptr;
+    const u32 start = cpu.cycles;
+    while (cpu.cycles - start < count) {
+        const u32 before = cpu.cycles;
+        if (starts)
+            starts->push_back(before);
+        cpu.Execute(starts ? 1 : count - (before - start));
+        if (cpu.cycles == before)
+            break;
+    }
+    cpu.SetDebugger(attached);
+}
+
+std::size_t Rewind::Nearest(const u32 cycle) const {
+    const u32 age = Age(cycle);
+    std::size_t index = snapshots.size() - 1;
+    while (index > 0 && Age(snapshots[index].cycles) > age)
+        --index;
+    return index;
+}
+
+void Rewind::Checkpoint() {
+    // A second checkpoint at the same cycle replaces the first, in case the host changed the state in between.
+    if (!snapshots.empty()) {
+        Truncate();
+        if (snapshots.back().cycles == cpu.cycles)
+            snapshots.pop_back();
+    }
+    if (!snapshots.empty()) {
+        Snapshot &newest = snapshots.back();
+        newest.bytes = Diverged(newest.memory, cpu.mem);
+        journal += newest.bytes;
+    }
+    snapshots.push_back({cpu.mem, cpu.PC, cpu.SP, cpu.A, cpu.X, cpu.Y, cpu.StatusRegister(), cpu.irq_line,
+                         cpu.nmi_pending, cpu.IrqDelayed(), cpu.cycles, 0});
+    while (journal > journal_limit && snapshots.size() > 1) {
+        journal -= snapshots.front().bytes;
+        snapshots.pop_front();
+    }
+    latest = cpu.cycles;
+}
+
+void Rewind::Execute(const u32 exec_cycles) {
+    Truncate();
+    const u32 start = cpu.cycles;
+    while (cpu.cycles - start < exec_cycles) {
+        const u32 since = cpu.cycles - snapshots.back().cycles;
+        if (since >= interval) {
+            Checkpoint();
+            continue;
+        }
+        const u32 chunk = std::min(exec_cycles - (cpu.cycles - start), interval - since);
+        const u32 before = cpu.cycles;
+        cpu.Execute(chunk);
+        // A watchpoint hit by the chunk's last instruction stops the run without cutting the chunk short.
+        if (cpu.cycles - before < chunk || (cpu.debugger && cpu.debugger->LastStop().kind != StopKind::None))
+            break;
+    }
+    latest = cpu.cycles;
+}
+
+bool Rewind::StepBack(const u32 count) {
+    if (count == 0)
+        return true;
+    const u32 now = cpu.cycles;
+    std::vector<u32> starts;
+    // Replays from successively older checkpoints until one holds enough instructions before now.
+    for (std::size_t index = Nearest(now) + 1; index-- > 0;) {
+        const Snapshot &snapshot = snapshots[index];
+        if (snapshot.cycles == now)
+            continue;
+        Restore(snapshot);
+        starts.clear();
+        Replay(now - snapshot.cycles, &starts);
+        if (starts.size() >= count) {
+            const u32 target = starts[starts.size() - count];
+            Restore(snapshot);
+            Replay(target - snapshot.cycles, nullptr);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Rewind::SeekCycle(const u32 cycle) {
+    if (Age(cycle) > std::max(Age(cpu.cycles), Age(latest)))
+        return false;
+    const Snapshot &snapshot = snapshots[Nearest(cycle)];
+    Restore(snapshot);
+    Replay(cycle - snapshot.cycles, nullptr);
+    return true;
+}
+
+std::size_t Rewind::JournalBytes() const { return journal + Diverged(snapshots.back().memory, cpu.mem); }
@@ -0,0 +1,162 @@
+#include "cpu6502/savestate.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CPU6502_SAVESTATE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define CPU6502_SAVESTATE_MMAP 0
+#endif
+
+namespace {
+constexpr char MAGIC[4] = {'S', '6', '5', 'S'};
+// Page data starts one page into the file so that no stored page straddles a host page boundary.
+constexpr std::size_t DATA_OFFSET = PAGE_BYTES;
+
+// Header layout; multi-byte fields are little-endian.
+constexpr std::size_t VERSION_AT = 4;
+constexpr std::size_t PC_AT = 6;
+constexpr std::size_t SP_AT = 8;
+constexpr std::size_t A_AT = 10;
+constexpr std::size_t X_AT = 11;
+constexpr std::size_t Y_AT = 12;
+constexpr std::size_t P_AT = 13;
+// Bit 0 is the IRQ line, bit 1 a pending NMI and bit 2 an IRQ held back by the CLI just run; zero in version 1.
+constexpr std::size_t LINES_AT = 14;
+constexpr std::size_t CYCLES_AT = 16;
+constexpr std::size_t STORED_AT = 20;
+constexpr std::size_t BITMAP_AT = 24;
+
+void Put16(Byte *at, const u32 value) {
+    at[0] = static_cast<Byte>(value);
+    at[1] = static_cast<Byte>(value >> 8);
+}
+
+void Put32(Byte *at, const u32 value) {
+    Put16(at, value);
+    Put16(at + 2, value >> 16);
+}
+
+Word Get16(const Byte *at) { return static_cast<Word>(at[0] | at[1] << 8); }
+
+u32 Get32(const Byte *at) { return Get16(at) | static_cast<u32>(Get16(at + 2)) << 16; }
+
+bool IsZeroPage(const Byte *bytes) {
+    for (u32 i = 0; i < PAGE_BYTES; ++i) {
+        if (bytes[i] != 0)
+            return false;
+    }
+    return true;
+}
+
+// Maps the whole file privately, or reads it into the heap where mmap is not available. The returned owner releases
+// the bytes once the last page pointing into them is gone.
+std::shared_ptr<void> MapFile(const std::string &path, std::size_t &size) {
+#if CPU6502_SAVESTATE_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("SaveState cannot open " + path);
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        throw std::runtime_error("SaveState cannot read " + path);
+    }
+    size = static_cast<std::size_t>(info.st_size);
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error("SaveState cannot map " + path);
+    return {mapping, [size](void *bytes) { munmap(bytes, size); }};
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+        throw std::runtime_error("SaveState cannot open " + path);
+    size = static_cast<std::size_t>(in.tellg());
+    std::shared_ptr<Byte> bytes(new Byte[size], std::default_delete<Byte[]>());
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char *>(bytes.get()), static_cast<std::streamsize>(size)))
+        throw std::runtime_error("SaveState cannot read " + path);
+    return bytes;
+#endif
+}
+} // namespace
+
+void SaveState::Save(const std::string &Path, const CPU &cpu, const Memory &memory) {
+    std::vector<Byte> file(DATA_OFFSET);
+    std::memcpy(file.data(), MAGIC, sizeof(MAGIC));
+    Put16(&file[VERSION_AT], VERSION);
+    Put16(&file[PC_AT], cpu.PC);
+    Put16(&file[SP_AT], cpu.SP);
+    file[A_AT] = cpu.A;
+    file[X_AT] = cpu.X;
+    file[Y_AT] = cpu.Y;
+    file[P_AT] = cpu.StatusRegister();
+    file[LINES_AT] = static_cast<Byte>((cpu.irq_line ? 1 : 0) | (cpu.nmi_pending ? 2 : 0) | (cpu.IrqDelayed() ? 4 : 0));
+    Put32(&file[CYCLES_AT], cpu.cycles);
+
+    u32 stored = 0;
+    for (u32 page = 0; page < PAGE_COUNT; ++page) {
+        const Byte *bytes = memory.InternalPage(static_cast<Byte>(page));
+        if (IsZeroPage(bytes))
+            continue;
+        file[BITMAP_AT + page / 8] = static_cast<Byte>(file[BITMAP_AT + page / 8] | 1 << (page % 8));
+        file.insert(file.end(), bytes, bytes + PAGE_BYTES);
+        ++stored;
+    }
+    Put32(&file[STORED_AT], stored);
+
+    std::ofstream out(Path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(file.data()), static_cast<std::streamsize>(file.size()));
+    if (!out.flush())
+        throw std::runtime_error("SaveState cannot write " + Path);
+}
+
+void SaveState::Load(const std::string &Path, CPU &cpu, Memory &memory) {
+    std::size_t size = 0;
+    const std::shared_ptr<void> mapping = MapFile(Path, size);
+    Byte *file = static_cast<Byte *>(mapping.get());
+    if (size < DATA_OFFSET || std::memcmp(file, MAGIC, sizeof(MAGIC)) != 0)
+        throw std::runtime_error("SaveState " + Path + " is not a save state");
+    const Word version = Get16(&file[VERSION_AT]);
+    if (version != 1 && version != VERSION)
+        throw std::runtime_error("SaveState " + Path + " has an unsupported version");
+    u32 stored = 0;
+    for (u32 page = 0; page < PAGE_COUNT; ++page)
+        stored += static_cast<u32>(file[BITMAP_AT + page / 8] >> (page % 8) & 1);
+    if (stored != Get32(&file[STORED_AT]))
+        throw std::runtime_error("SaveState " + Path + " page bitmap does not match its page count");
+    if (size < DATA_OFFSET + static_cast<std::size_t>(stored) * PAGE_BYTES)
+        throw std::runtime_error("SaveState " + Path + " is truncated");
+
+    Byte *data = file + DATA_OFFSET;
+    for (u32 page = 0; page < PAGE_COUNT; ++page) {
+        if ((file[BITMAP_AT + page / 8] >> (page % 8) & 1) != 0) {
+            memory.AdoptPage(static_cast<Byte>(page), data, mapping);
+            data += PAGE_BYTES;
+        } else {
+            memory.AdoptPage(static_cast<Byte>(page), nullptr, nullptr);
+        }
+    }
+
+    cpu.PC = Get16(&file[PC_AT]);
+    cpu.SP = Get16(&file[SP_AT]);
+    cpu.A = file[A_AT];
+    cpu.X = file[X_AT];
+    cpu.Y = file[Y_AT];
+    cpu.SetStatusRegister(file[P_AT]);
+    cpu.cycles = Get32(&file[CYCLES_AT]);
+    const Byte lines = version == 1 ? 0 : file[LINES_AT];
+    cpu.irq_line = (lines & 1) != 0;
+    cpu.nmi_pending = (lines & 2) != 0;
+    cpu.irq_delayed = (lines & 4) != 0;
+    cpu.cli_cycles = cpu.cycles;
+}
@@ -0,0 +1,63 @@
+#include "cpu6502/scheduler.hpp"
+
+#include <utility>
+
+// Heap comparator: the earliest event, and among equal cycles the first scheduled, ends up at the front.
+bool Scheduler::Later(const Entry &a, const Entry &b) { return a.when != b.when ? a.when > b.when : a.id > b.id; }
+
+u64 Scheduler::Now() const { return clock ? now + static_cast<u32>(*clock - clock_start) : now; }
+
+u64 Scheduler::NextEvent() const { return heap.empty() ? NO_EVENT : heap.front().when; }
+
+std::size_t Scheduler::Pending() const { return callbacks.size(); }
+
+Scheduler::EventId Scheduler::Schedule(const u64 when, Callback callback) {
+    const EventId id = next_id++;
+    callbacks.emplace(id, std::move(callback));
+    heap.push_back({when, id});
+    std::push_heap(heap.begin(), heap.end(), Later);
+    if (clock && when < slice_end && !stopped_for_event) {
+        stopped_for_event = true;
+        stop(running);
+    }
+    return id;
+}
+
+Scheduler::EventId Scheduler::ScheduleIn(const u64 delay, Callback callback) {
+    return Schedule(Now() + delay, std::move(callback));
+}
+
+bool Scheduler::Cancel(const EventId id) {
+    if (callbacks.erase(id) == 0)
+        return false;
+    DropCancelled();
+    return true;
+}
+
+void Scheduler::Clear() {
+    heap.clear();
+    callbacks.clear();
+}
+
+void Scheduler::PopFront() {
+    std::pop_heap(heap.begin(), heap.end(), Later);
+    heap.pop_back();
+}
+
+void Scheduler::DropCancelled() {
+    while (!heap.empty() && callbacks.count(heap.front().id) == 0)
+        PopFront();
+}
+
+void Scheduler::Fire() {
+    while (!heap.empty() && heap.front().when <= now) {
+        const Entry due = heap.front();
+        PopFront();
+        // Taken out first so the callback can schedule, or cancel, further events.
+        auto found = callbacks.find(due.id);
+        Callback callback = std::move(found->second);
+        callbacks.erase(found);
+        callback(due.when);
+        DropCancelled();
+    }
+}
@@ -0,0 +1,270 @@
+#include "cpu6502/stepped.hpp"
+
+#include <cpu6502/opcodes.hpp>
+#include <new>
+#include <utility>
+
+namespace {
+// Frames carry a pointer back to their pool in front of the coroutine state.
+constexpr std::size_t FRAME_HEADER = alignof(std::max_align_t);
+
+Word MakeWord(const Byte lo, const Byte hi) { return static_cast<Word>((static_cast<Word>(hi) << 8) | lo); }
+
+bool CrossesPage(const Word base, const Word addr) { return (base ^ addr) & 0xFF00; }
+
+bool IsStore(const Mnemonic mnemonic) {
+    return mnemonic == Mnemonic::STA || mnemonic == Mnemonic::STX || mnemonic == Mnemonic::STY;
+}
+} // namespace
+
+SteppedCPU::FramePool::~FramePool() { Drain(); }
+
+void SteppedCPU::FramePool::Drain() {
+    while (free) {
+        Block *next = free->next;
+        ::operator delete(free);
+        free = next;
+    }
+}
+
+void *SteppedCPU::FramePool::Allocate(const std::size_t size) {
+    if (size <= block_size && free) {
+        Block *block = free;
+        free = block->next;
+        return block;
+    }
+    if (size > block_size) {
+        // Pooled blocks are all block_size bytes, so smaller ones are dropped when a larger frame shows up.
+        Drain();
+        block_size = size;
+    }
+    return ::operator new(block_size);
+}
+
+void SteppedCPU::FramePool::Release(void *frame, const std::size_t size) {
+    if (size != block_size) {
+        ::operator delete(frame);
+        return;
+    }
+    auto *block = static_cast<Block *>(frame);
+    block->next = free;
+    free = block;
+}
+
+void *SteppedCPU::Instruction::promise_type::operator new(const std::size_t size, SteppedCPU &core) {
+    auto *block = static_cast<unsigned char *>(core.pool.Allocate(FRAME_HEADER + size));
+    *reinterpret_cast<FramePool **>(block) = &core.pool;
+    return block + FRAME_HEADER;
+}
+
+void SteppedCPU::Instruction::promise_type::operator delete(void *frame, const std::size_t size) {
+    unsigned char *block = static_cast<unsigned char *>(frame) - FRAME_HEADER;
+    (*reinterpret_cast<FramePool **>(block))->Release(block, FRAME_HEADER + size);
+}
+
+void SteppedCPU::Instruction::promise_type::unhandled_exception() { throw; }
+
+SteppedCPU::Instruction::Instruction(Instruction &&Other) noexcept : handle(std::exchange(Other.handle, {})) {}
+
+SteppedCPU::Instruction &SteppedCPU::Instruction::operator=(Instruction &&Other) noexcept {
+    if (this != &Other) {
+        if (handle)
+            handle.destroy();
+        handle = std::exchange(Other.handle, {});
+    }
+    return *this;
+}
+
+SteppedCPU::Instruction::~Instruction() {
+    if (handle)
+        handle.destroy();
+}
+
+SteppedCPU::SteppedCPU(CPU &core) : cpu(core) {}
+
+SteppedCPU::Cycle SteppedCPU::Read(const Word address) {
+    access = {address, 0, BusOp::Read};
+    return {*this};
+}
+
+SteppedCPU::Cycle SteppedCPU::Write(const Word address, const Byte value) {
+    access = {address, value, BusOp::Write};
+    return {*this};
+}
+
+SteppedCPU::Cycle SteppedCPU::Idle(const Word address) {
+    access = {address, 0, BusOp::Idle};
+    return {*this};
+}
+
+SteppedCPU::Cycle SteppedCPU::Push(const Byte value) {
+    const auto address = static_cast<Word>(0x0100 | (cpu.SP & 0xFF));
+    cpu.SP = static_cast<Byte>(cpu.SP - 1);
+    return Write(address, value);
+}
+
+SteppedCPU::Cycle SteppedCPU::Pull() {
+    cpu.SP = static_cast<Byte>(cpu.SP + 1);
+    return Read(static_cast<Word>(0x0100 | cpu.SP));
+}
+
+SteppedCPU::Instruction SteppedCPU::Run() {
+    // A pending interrupt runs as a BRK whose opcode and padding fetches are internal cycles.
+    const bool interrupt = cpu.nmi_pending || (cpu.irq_line && !cpu.PS.I && !cpu.IrqDelayed());
+    Byte opcode = 0x00;
+    if (interrupt) {
+        co_await Idle(cpu.PC);
+    } else {
+        opcode = co_await Read(cpu.PC);
+        cpu.PC++;
+    }
+    if (!IsImplemented(opcode)) {
+        cpu.UnknownOpcode();
+        co_return;
+    }
+    const OpcodeInfo &info = OPCODES[opcode];
+    if (info.mnemonic == Mnemonic::BRK) {
+        const Word vector = interrupt && cpu.nmi_pending ? 0xFFFA : 0xFFFE;
+        if (interrupt)
+            cpu.nmi_pending = false;
+        co_await Idle(cpu.PC);
+        if (!interrupt)
+            cpu.PC++;
+        co_await Push(static_cast<Byte>(cpu.PC >> 8));
+        co_await Push(static_cast<Byte>(cpu.PC));
+        co_await Push(static_cast<Byte>((cpu.StatusRegister() & 0xEF) | 0x20 | (interrupt ? 0x00 : 0x10)));
+        cpu.PS.I = 1;
+        const Byte lo = co_await Read(vector);
+        const Byte hi = co_await Read(static_cast<Word>(vector + 1));
+        cpu.PC = MakeWord(lo, hi);
+        co_return;
+    }
+    if (info.mnemonic == Mnemonic::RTI) {
+        co_await Idle(cpu.PC);
+        co_await Idle(static_cast<Word>(0x0100 | (cpu.SP & 0xFF)));
+        const Byte P = co_await Pull();
+        cpu.SetStatusRegister(static_cast<Byte>((P & 0xCF) | (cpu.StatusRegister() & 0x30)));
+        const Byte lo = co_await Pull();
+        const Byte hi = co_await Pull();
+        cpu.PC = MakeWord(lo, hi);
+        cpu.RaisePending();
+        co_return;
+    }
+    Word operand = 0;
+    if (info.length >= 2) {
+        operand = co_await Read(cpu.PC);
+        cpu.PC++;
+    }
+    if (info.length == 3) {
+        const Byte hi = co_await Read(cpu.PC);
+        cpu.PC++;
+        operand = MakeWord(static_cast<Byte>(operand), hi);
+    }
+
+    const auto zp = static_cast<Byte>(operand);
+    // Indexed writes always spend the cycle that fixes up the high byte; indexed reads only when it changes.
+    const bool fixup_always = info.penalty != PageCrossPenalty::IndexedRead;
+    Word address = operand;
+    switch (info.mode) {
+    case AddressingMode::Implied:
+        for (Byte cycle = info.length; cycle < info.cycles; ++cycle)
+            co_await Idle(cpu.PC);
+        switch (info.mnemonic) {
+        case Mnemonic::CLI:
+            cpu.CLI();
+            break;
+        case Mnemonic::SEI:
+            cpu.SEI();
+            break;
+        case Mnemonic::NOP:
+            break;
+        default:
+            cpu.UnknownOpcode();
+            break;
+        }
+        co_return;
+    case AddressingMode::ZeroPage:
+        address = zp;
+        break;
+    case AddressingMode::ZeroPageX:
+    case AddressingMode::ZeroPageY:
+        co_await Idle(zp);
+        address = static_cast<Byte>(zp + (info.mode == AddressingMode::ZeroPageX ? cpu.X : cpu.Y));
+        break;
+    case AddressingMode::AbsoluteX:
+    case AddressingMode::AbsoluteY:
+        address = static_cast<Word>(operand + (info.mode == AddressingMode::AbsoluteX ? cpu.X : cpu.Y));
+        if (fixup_always || CrossesPage(operand, address))
+            co_await Idle(static_cast<Word>((operand & 0xFF00) | (address & 0x00FF)));
+        break;
+    case AddressingMode::IndexedIndirectX: {
+        co_await Idle(zp);
+        const auto pointer = static_cast<Byte>(zp + cpu.X);
+        const Byte lo = co_await Read(pointer);
+        const Byte hi = co_await Read(static_cast<Byte>(pointer + 1));
+        address = MakeWord(lo, hi);
+        break;
+    }
+    case AddressingMode::IndirectIndexedY: {
+        const Byte lo = co_await Read(zp);
+        const Byte hi = co_await Read(static_cast<Byte>(zp + 1));
+        const Word base = MakeWord(lo, hi);
+        address = static_cast<Word>(base + cpu.Y);
+        if (fixup_always || CrossesPage(base, address))
+            co_await Idle(static_cast<Word>((base & 0xFF00) | (address & 0x00FF)));
+        break;
+    }
+    default:
+        break;
+    }
+
+    if (IsStore(info.mnemonic)) {
+        const Byte value = info.mnemonic == Mnemonic::STA ? cpu.A : info.mnemonic == Mnemonic::STX ? cpu.X : cpu.Y;
+        co_await Write(address, value);
+        co_return;
+    }
+    Byte value = zp;
+    if (info.mode != AddressingMode::Immediate)
+        value = co_await Read(address);
+    switch (info.mnemonic) {
+    case Mnemonic::LDA:
+        cpu.LDA(value);
+        break;
+    case Mnemonic::LDX:
+        cpu.LDX(value);
+        break;
+    case Mnemonic::LDY:
+        cpu.LDY(value);
+        break;
+    default:
+        // Implemented by the interpreter but not by this core yet.
+        cpu.UnknownOpcode();
+        break;
+    }
+}
+
+const BusAccess &SteppedCPU::Step() {
+    if (!current.handle) {
+        current = Run();
+        current.handle.resume();
+    }
+    if (access.op == BusOp::Read)
+        access.value = cpu.mem.ReadByte(access.address);
+    else if (access.op == BusOp::Write)
+        cpu.mem.WriteByte(access.address, access.value);
+    cpu.cycles++;
+    // Kept for the caller; resuming the instruction already sets up its next access.
+    last = access;
+    current.handle.resume();
+    if (current.handle.done())
+        current = Instruction();
+    return last;
+}
+
+bool SteppedCPU::AtInstructionBoundary() const { return !current.handle; }
+
+void SteppedCPU::Execute(const u32 exec_cycles) {
+    const u32 start = cpu.cycles;
+    while (cpu.cycles - start < exec_cycles || !AtInstructionBoundary())
+        Step();
+}
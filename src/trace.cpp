@@ -0,0 +1,52 @@
+#include "cpu6502/trace.hpp"
+
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+
+TraceRing::TraceRing(const std::size_t capacity) {
+    std::size_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+    records = std::make_unique<InstructionRecord[]>(size);
+    mask = size - 1;
+}
+
+std::size_t TraceRing::Capacity() const { return mask + 1; }
+
+std::size_t TraceRing::Size() const { return recorded < Capacity() ? static_cast<std::size_t>(recorded) : Capacity(); }
+
+u64 TraceRing::Recorded() const { return recorded; }
+
+const InstructionRecord &TraceRing::Record(const std::size_t index) const {
+    if (index >= Size())
+        throw std::out_of_range("TraceRing record out of range");
+    return records[(recorded - Size() + index) & mask];
+}
+
+void TraceRing::Clear() { recorded = 0; }
+
+void TraceRing::Dump(std::ostream &out, std::size_t count) const {
+    if (count == 0 || count > Size())
+        count = Size();
+    const std::ios::fmtflags flags = out.flags();
+    const char fill = out.fill('0');
+    out << std::hex << std::uppercase;
+    for (std::size_t i = Size() - count; i < Size(); ++i) {
+        const InstructionRecord &record = Record(i);
+        out << std::setw(4) << record.pc << "  " << std::setw(2) << static_cast<u32>(record.opcode);
+        // Operand bytes as they appear in memory, padded to the longest instruction.
+        for (u32 byte = 1; byte < 3; ++byte) {
+            if (byte < record.length)
+                out << ' ' << std::setw(2) << (record.operand >> (8 * (byte - 1)) & 0xFF);
+            else
+                out << "   ";
+        }
+        out << "  A:" << std::setw(2) << static_cast<u32>(record.a) << " X:" << std::setw(2)
+            << static_cast<u32>(record.x) << " Y:" << std::setw(2) << static_cast<u32>(record.y) << " SP:"
+            << std::setw(2) << static_cast<u32>(record.sp) << " P:" << std::setw(2) << static_cast<u32>(record.p)
+            << std::dec << " CYC:" << record.cycles << std::hex << '\n';
+    }
+    out.fill(fill);
+    out.flags(flags);
+}
@@ -0,0 +1,380 @@
+#include "cpu6502/tracefile.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+constexpr char MAGIC[4] = {'S', '6', '5', 'T'};
+constexpr u32 VERSION = 1;
+constexpr std::size_t HEADER_BYTES = 8;
+constexpr std::size_t RECORD_BYTES = 16;
+constexpr std::size_t CHUNK_HEADER_BYTES = 8;
+constexpr std::size_t TOC_ENTRY_BYTES = 20;
+constexpr std::size_t FOOTER_BYTES = 16;
+
+// Delta record mask: instruction length in bits 0-1, then one bit per field that is stored.
+constexpr Byte PC_JUMP = 1 << 2;
+constexpr Byte A_CHANGED = 1 << 3;
+constexpr Byte X_CHANGED = 1 << 4;
+constexpr Byte Y_CHANGED = 1 << 5;
+constexpr Byte SP_CHANGED = 1 << 6;
+constexpr Byte P_CHANGED = 1 << 7;
+
+void Put(std::vector<Byte> &out, const u64 value, const u32 bytes) {
+    for (u32 i = 0; i < bytes; ++i)
+        out.push_back(static_cast<Byte>(value >> (8 * i)));
+}
+
+u64 Get(const Byte *at, const u32 bytes) {
+    u64 value = 0;
+    for (u32 i = 0; i < bytes; ++i)
+        value |= static_cast<u64>(at[i]) << (8 * i);
+    return value;
+}
+
+void PutVarint(std::vector<Byte> &out, u32 value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<Byte>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<Byte>(value));
+}
+
+void PutRecord(std::vector<Byte> &out, const InstructionRecord &record) {
+    Put(out, record.pc, 2);
+    Put(out, record.operand, 2);
+    for (const Byte field : {record.opcode, record.length, record.a, record.x, record.y, record.sp, record.p, Byte{0}})
+        out.push_back(field);
+    Put(out, record.cycles, 4);
+}
+
+InstructionRecord GetRecord(const Byte *at) {
+    return {static_cast<Word>(Get(at, 2)), static_cast<Word>(Get(at + 2, 2)), at[4], at[5], at[6], at[7], at[8],
+            at[9], at[10], static_cast<u32>(Get(at + 12, 4))};
+}
+
+void PutDelta(std::vector<Byte> &out, const InstructionRecord &previous, const InstructionRecord &record) {
+    const auto next_pc = static_cast<Word>(previous.pc + previous.length);
+    Byte mask = static_cast<Byte>(record.length & 3);
+    mask |= record.pc != next_pc ? PC_JUMP : 0;
+    mask |= record.a != previous.a ? A_CHANGED : 0;
+    mask |= record.x != previous.x ? X_CHANGED : 0;
+    mask |= record.y != previous.y ? Y_CHANGED : 0;
+    mask |= record.sp != previous.sp ? SP_CHANGED : 0;
+    mask |= record.p != previous.p ? P_CHANGED : 0;
+    out.push_back(mask);
+    out.push_back(record.opcode);
+    Put(out, record.operand, record.length > 0 ? record.length - 1u : 0u);
+    if (mask & PC_JUMP) {
+        // Zigzag-encoded signed 16-bit distance from the fall-through PC.
+        const auto delta = static_cast<std::int16_t>(record.pc - next_pc);
+        PutVarint(out, static_cast<u32>(delta < 0 ? -2 * delta - 1 : 2 * delta));
+    }
+    if (mask & A_CHANGED)
+        out.push_back(record.a);
+    if (mask & X_CHANGED)
+        out.push_back(record.x);
+    if (mask & Y_CHANGED)
+        out.push_back(record.y);
+    if (mask & SP_CHANGED)
+        out.push_back(record.sp);
+    if (mask & P_CHANGED)
+        out.push_back(record.p);
+    PutVarint(out, record.cycles - previous.cycles);
+}
+
+// Single-producer, single-consumer ring of batches.
+class BatchQueue {
+public:
+    struct Batch {
+        InstructionRecord *records;
+        std::size_t count;
+    };
+
+    void Push(const Batch batch) {
+        const std::size_t tail = tail_index.load(std::memory_order_relaxed);
+        slots[tail % TraceFileWriter::BATCHES] = batch;
+        tail_index.store(tail + 1, std::memory_order_release);
+    }
+
+    bool Pop(Batch &batch) {
+        const std::size_t head = head_index.load(std::memory_order_relaxed);
+        if (head == tail_index.load(std::memory_order_acquire))
+            return false;
+        batch = slots[head % TraceFileWriter::BATCHES];
+        head_index.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] bool Empty() const {
+        return head_index.load(std::memory_order_acquire) == tail_index.load(std::memory_order_acquire);
+    }
+
+private:
+    // At most BATCHES batches exist, so a push never finds the ring full.
+    Batch slots[TraceFileWriter::BATCHES]{};
+    alignas(64) std::atomic<std::size_t> head_index{0};
+    alignas(64) std::atomic<std::size_t> tail_index{0};
+};
+} // namespace
+
+struct TraceFileWriter::Stream {
+    std::ofstream out;
+    std::unique_ptr<InstructionRecord[]> storage;
+    BatchQueue full;
+    BatchQueue empty;
+    std::atomic<bool> stopping{false};
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread writer;
+
+    // Writer thread state.
+    bool started = false;
+    InstructionRecord previous{};
+    u64 cycle = 0;
+    std::vector<Byte> chunk;
+    std::vector<Byte> toc;
+    u32 chunk_count = 0;
+
+    void Run();
+    void WriteChunk(const BatchQueue::Batch &batch);
+};
+
+void TraceFileWriter::Stream::Run() {
+    for (;;) {
+        BatchQueue::Batch batch{};
+        if (full.Pop(batch)) {
+            WriteChunk(batch);
+            empty.Push(batch);
+            continue;
+        }
+        if (stopping.load(std::memory_order_acquire) && full.Empty())
+            return;
+        // The producer notifies without the lock, so a missed wakeup only costs one timeout.
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait_for(lock, std::chrono::milliseconds(1),
+                      [this] { return !full.Empty() || stopping.load(std::memory_order_acquire); });
+    }
+}
+
+void TraceFileWriter::Stream::WriteChunk(const BatchQueue::Batch &batch) {
+    if (batch.count == 0)
+        return;
+    const InstructionRecord *records = batch.records;
+    cycle = started ? cycle + (records[0].cycles - previous.cycles) : records[0].cycles;
+    started = true;
+    Put(toc, cycle, 8);
+    Put(toc, static_cast<u64>(out.tellp()), 8);
+    Put(toc, batch.count, 4);
+    ++chunk_count;
+
+    chunk.clear();
+    PutRecord(chunk, records[0]);
+    for (std::size_t i = 1; i < batch.count; ++i) {
+        PutDelta(chunk, records[i - 1], records[i]);
+        cycle += records[i].cycles - records[i - 1].cycles;
+    }
+    previous = records[batch.count - 1];
+
+    std::vector<Byte> header;
+    Put(header, batch.count, 4);
+    Put(header, chunk.size(), 4);
+    out.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+    out.write(reinterpret_cast<const char *>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+}
+
+TraceFileWriter::TraceFileWriter(const std::string &Path, const std::size_t chunk_records)
+    : chunk_size(std::max<std::size_t>(chunk_records, 1)), stream(std::make_unique<Stream>()) {
+    stream->out.open(Path, std::ios::binary | std::ios::trunc);
+    if (!stream->out)
+        throw std::runtime_error("TraceFileWriter cannot create " + Path);
+    std::vector<Byte> header(MAGIC, MAGIC + sizeof(MAGIC));
+    Put(header, VERSION, 2);
+    Put(header, 0, 2);
+    stream->out.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+
+    stream->storage = std::make_unique<InstructionRecord[]>(chunk_size * BATCHES);
+    batch = stream->storage.get();
+    for (std::size_t i = 1; i < BATCHES; ++i)
+        stream->empty.Push({stream->storage.get() + i * chunk_size, 0});
+    stream->writer = std::thread(&Stream::Run, stream.get());
+}
+
+TraceFileWriter::~TraceFileWriter() {
+    try {
+        Close();
+    } catch (const std::exception &) {
+        // Destructors must not throw; call Close to see write errors.
+    }
+}
+
+void TraceFileWriter::Submit() {
+    stream->full.Push({batch, used});
+    stream->wake.notify_one();
+    BatchQueue::Batch next{};
+    while (!stream->empty.Pop(next))
+        std::this_thread::yield();
+    batch = next.records;
+    used = 0;
+}
+
+void TraceFileWriter::Close() {
+    if (!stream)
+        return;
+    const std::unique_ptr<Stream> closing = std::move(stream);
+    if (used > 0)
+        closing->full.Push({batch, used});
+    closing->stopping.store(true, std::memory_order_release);
+    closing->wake.notify_one();
+    closing->writer.join();
+
+    std::vector<Byte> footer;
+    Put(footer, static_cast<u64>(closing->out.tellp()), 8);
+    Put(footer, closing->chunk_count, 4);
+    footer.insert(footer.end(), MAGIC, MAGIC + sizeof(MAGIC));
+    closing->out.write(reinterpret_cast<const char *>(closing->toc.data()),
+                       static_cast<std::streamsize>(closing->toc.size()));
+    closing->out.write(reinterpret_cast<const char *>(footer.data()), static_cast<std::streamsize>(footer.size()));
+    if (!closing->out.flush())
+        throw std::runtime_error("TraceFileWriter could not write the trace");
+}
+
+TraceFileReader::TraceFileReader(const std::string &Path) : file(Path, std::ios::binary) {
+    if (!file)
+        throw std::runtime_error("TraceFileReader cannot open " + Path);
+    Byte header[HEADER_BYTES]{};
+    Byte footer[FOOTER_BYTES]{};
+    file.read(reinterpret_cast<char *>(header), sizeof(header));
+    file.seekg(-static_cast<std::streamoff>(FOOTER_BYTES), std::ios::end);
+    file.read(reinterpret_cast<char *>(footer), sizeof(footer));
+    if (!file || std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || std::memcmp(footer + 12, MAGIC, sizeof(MAGIC)) != 0)
+        throw std::runtime_error("TraceFileReader " + Path + " is not a complete trace");
+    if (Get(header + 4, 2) != VERSION)
+        throw std::runtime_error("TraceFileReader " + Path + " has an unsupported version");
+
+    const auto chunk_count = static_cast<std::size_t>(Get(footer + 8, 4));
+    std::vector<Byte> toc(chunk_count * TOC_ENTRY_BYTES);
+    file.seekg(static_cast<std::streamoff>(Get(footer, 8)));
+    file.read(reinterpret_cast<char *>(toc.data()), static_cast<std::streamsize>(toc.size()));
+    if (!file)
+        throw std::runtime_error("TraceFileReader " + Path + " has a truncated table of contents");
+    for (std::size_t i = 0; i < chunk_count; ++i) {
+        const Byte *entry = toc.data() + i * TOC_ENTRY_BYTES;
+        chunks.push_back({Get(entry, 8), Get(entry + 8, 8)});
+        count += Get(entry + 16, 4);
+    }
+}
+
+u64 TraceFileReader::Count() const { return count; }
+
+std::size_t TraceFileReader::Chunks() const { return chunks.size(); }
+
+void TraceFileReader::LoadChunk(const std::size_t index) {
+    Byte header[CHUNK_HEADER_BYTES]{};
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(chunks[index].offset));
+    file.read(reinterpret_cast<char *>(header), sizeof(header));
+    data.resize(static_cast<std::size_t>(Get(header + 4, 4)));
+    file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!file || data.size() < RECORD_BYTES)
+        throw std::runtime_error("TraceFileReader chunk is truncated");
+    remaining = static_cast<u32>(Get(header, 4));
+    position = 0;
+    cycle = chunks[index].first_cycle;
+    next_chunk = index + 1;
+}
+
+bool TraceFileReader::Next(InstructionRecord &record) {
+    if (buffered) {
+        buffered = false;
+        record = previous;
+        return true;
+    }
+    if (remaining == 0) {
+        if (next_chunk == chunks.size())
+            return false;
+        LoadChunk(next_chunk);
+    }
+    --remaining;
+    if (position == 0) {
+        previous = GetRecord(data.data());
+        position = RECORD_BYTES;
+        record = previous;
+        return true;
+    }
+
+    const Byte *at = data.data() + position;
+    const Byte *const end = data.data() + data.size();
+    auto byte = [&] {
+        if (at == end)
+            throw std::runtime_error("TraceFileReader chunk is corrupt");
+        return *at++;
+    };
+    auto varint = [&] {
+        u32 value = 0;
+        for (u32 shift = 0;; shift += 7) {
+            const Byte next = byte();
+            value |= static_cast<u32>(next & 0x7F) << shift;
+            if ((next & 0x80) == 0 || shift >= 28)
+                return value;
+        }
+    };
+
+    InstructionRecord next = previous;
+    const Byte mask = byte();
+    next.length = mask & 3;
+    next.opcode = byte();
+    next.operand = 0;
+    for (u32 i = 1; i < next.length; ++i)
+        next.operand = static_cast<Word>(next.operand | byte() << (8 * (i - 1)));
+    next.pc = static_cast<Word>(previous.pc + previous.length);
+    if (mask & PC_JUMP) {
+        const u32 zigzag = varint();
+        const auto delta = static_cast<std::int32_t>(zigzag >> 1) ^ -static_cast<std::int32_t>(zigzag & 1);
+        next.pc = static_cast<Word>(next.pc + delta);
+    }
+    if (mask & A_CHANGED)
+        next.a = byte();
+    if (mask & X_CHANGED)
+        next.x = byte();
+    if (mask & Y_CHANGED)
+        next.y = byte();
+    if (mask & SP_CHANGED)
+        next.sp = byte();
+    if (mask & P_CHANGED)
+        next.p = byte();
+    const u32 elapsed = varint();
+    next.cycles = previous.cycles + elapsed;
+    cycle += elapsed;
+
+    position = static_cast<std::size_t>(at - data.data());
+    previous = next;
+    record = next;
+    return true;
+}
+
+void TraceFileReader::SeekCycle(const u64 target) {
+    buffered = false;
+    remaining = 0;
+    next_chunk = chunks.size();
+    if (chunks.empty())
+        return;
+    const auto after = std::upper_bound(chunks.begin(), chunks.end(), target,
+                                        [](const u64 value, const Chunk &chunk) { return value < chunk.first_cycle; });
+    LoadChunk(after == chunks.begin() ? 0 : static_cast<std::size_t>(after - chunks.begin() - 1));
+    InstructionRecord record{};
+    while (Next(record)) {
+        if (cycle >= target) {
+            buffered = true;
+            return;
+        }
+    }
+}
+
+u64 TraceFileReader::Cycle() const { return cycle; }
@@ -0,0 +1,139 @@
+#include <cpu6502/batch.hpp>
+#include <gtest/gtest.h>
+
+namespace {
+// LDX $10; LDA $11; LDY $20,X; STA $0300; STY $0301; NOP
+void LoadImage(Memory &memory) {
+    memory.WriteByte(0xFFFC, 0x00);
+    memory.WriteByte(0xFFFD, 0x80);
+    Word addr = 0x8000;
+    for (const Byte b :
+         std::initializer_list<Byte>{0xA6, 0x10, 0xA5, 0x11, 0xB4, 0x20, 0x8D, 0x00, 0x03, 0x8C, 0x01, 0x03, 0xEA})
+        memory.WriteByte(addr++, b);
+    for (Word zp = 0x20; zp < 0x40; ++zp)
+        memory.WriteByte(zp, static_cast<Byte>(zp * 3));
+}
+
+constexpr u32 PROGRAM_CYCLES = 3 + 3 + 4 + 4 + 4 + 2;
+
+std::vector<MemoryPatch> JobPatches(const u32 job) {
+    return {{0x10, static_cast<Byte>(job % 32)}, {0x11, static_cast<Byte>(job)}};
+}
+} // namespace
+
+TEST(BatchRunnerTest, ResultsMatchSequentialExecution) {
+    Memory image;
+    LoadImage(image);
+
+    BatchRunner runner(image);
+    runner.AddCapture(0x0300, 2);
+    constexpr u32 JOBS = 1000;
+    runner.Reserve(JOBS, JOBS * 2);
+    for (u32 job = 0; job < JOBS; ++job)
+        runner.AddJob(JobPatches(job), {0x11, 0x22, static_cast<Byte>(job), 0x61});
+    runner.Run(PROGRAM_CYCLES, 4);
+
+    ASSERT_EQ(runner.CaptureBytes(), 2u);
+    for (u32 job = 0; job < JOBS; ++job) {
+        Memory memory = image;
+        for (const MemoryPatch &patch : JobPatches(job))
+            memory.WriteByte(patch.address, patch.value);
+        CPU cpu(memory);
+        cpu.Reset();
+        cpu.A = 0x11;
+        cpu.X = 0x22;
+        cpu.Y = static_cast<Byte>(job);
+        cpu.SetStatusRegister(0x61);
+        cpu.Execute(PROGRAM_CYCLES);
+
+        const BatchResult &result = runner.Result(job);
+        EXPECT_EQ(result.PC, cpu.PC);
+        EXPECT_EQ(result.SP, cpu.SP);
+        EXPECT_EQ(result.A, cpu.A);
+        EXPECT_EQ(result.X, cpu.X);
+        EXPECT_EQ(result.Y, cpu.Y);
+        EXPECT_EQ(result.P, cpu.StatusRegister());
+        EXPECT_EQ(result.cycles, cpu.cycles);
+        EXPECT_EQ(runner.Captured(job)[0], memory.ReadByte(0x0300));
+        EXPECT_EQ(runner.Captured(job)[1], memory.ReadByte(0x0301));
+    }
+}
+
+TEST(BatchRunnerTest, JobsDoNotSeeEachOthersWrites) {
+    Memory image;
+    LoadImage(image);
+
+    BatchRunner runner(image);
+    runner.AddCapture(0x0010, 2);
+    runner.AddCapture(0x0300, 1);
+    runner.AddJob({{0x11, 0x42}});
+    runner.AddJob({});
+    runner.Run(PROGRAM_CYCLES, 1);
+
+    EXPECT_EQ(runner.Captured(0)[1], 0x42);
+    EXPECT_EQ(runner.Captured(0)[2], 0x42);
+    EXPECT_EQ(runner.Captured(1)[1], 0x00);
+    EXPECT_EQ(runner.Captured(1)[2], 0x00);
+    EXPECT_EQ(image.ReadByte(0x0300), 0x00);
+}
+
+TEST(BatchRunnerTest, ReportsThroughputForEveryThreadCount) {
+    Memory image;
+    LoadImage(image);
+
+    BatchRunner runner(image);
+    for (u32 job = 0; job < 64; ++job)
+        runner.AddJob(JobPatches(job));
+    for (const unsigned threads : {1u, 3u, 8u, 100u}) {
+        runner.Run(PROGRAM_CYCLES, threads);
+        EXPECT_EQ(runner.Stats().jobs, 64u);
+        EXPECT_LE(runner.Stats().threads, 64u);
+        EXPECT_GT(runner.Stats().JobsPerSecond(), 0.0);
+        EXPECT_EQ(runner.Result(63).cycles, 6 + PROGRAM_CYCLES);
+    }
+}
+
+TEST(BatchRunnerTest, RejectsCaptureRangePastEndOfMemory) {
+    Memory image;
+    BatchRunner runner(image);
+    EXPECT_THROW(runner.AddCapture(0xFFF0, 0x20), std::out_of_range);
+}
+
+TEST(BatchRunnerTest, UnseededJobsStartWithTheResetStatus) {
+    Memory image;
+    LoadImage(image);
+
+    BatchRunner runner(image);
+    runner.AddJob({});
+    runner.Run(0, 1);
+
+    Memory memory = image;
+    CPU cpu(memory);
+    cpu.Reset();
+    EXPECT_EQ(runner.Result(0).P, cpu.StatusRegister());
+}
+
+TEST(BatchRunnerTest, RejectsImagesWithHostPagesOrDevices) {
+    struct NullDevice : BusDevice {
+        Byte Read(Word) override { return 0; }
+        void Write(Word, Byte) override {}
+    };
+
+    Memory image;
+    LoadImage(image);
+    BatchRunner runner(image);
+    runner.AddJob({});
+
+    Byte host[PAGE_BYTES]{};
+    image.MapRam(0x40, host);
+    EXPECT_THROW(runner.Run(PROGRAM_CYCLES, 1), std::invalid_argument);
+    image.UnmapPage(0x40);
+
+    NullDevice device;
+    image.MapDevice(0xD0, 0xD0, &device);
+    EXPECT_THROW(runner.Run(PROGRAM_CYCLES, 1), std::invalid_argument);
+    image.UnmapPage(0xD0);
+
+    runner.Run(PROGRAM_CYCLES, 1);
+    EXPECT_EQ(runner.Result(0).PC, 0x800D);
+}
@@ -0,0 +1,146 @@
+#include <cpu6502/block_cache.hpp>
+#include <gtest/gtest.h>
+
+#include "test_program.hpp"
+
+namespace {
+void ExpectSameState(const CPU &expected, const CPU &actual) {
+    EXPECT_EQ(actual.PC, expected.PC);
+    EXPECT_EQ(actual.SP, expected.SP);
+    EXPECT_EQ(actual.A, expected.A);
+    EXPECT_EQ(actual.X, expected.X);
+    EXPECT_EQ(actual.Y, expected.Y);
+    EXPECT_EQ(actual.cycles, expected.cycles);
+}
+} // namespace
+
+TEST(BlockCacheTest, MatchesInterpreterCyclesAndRegisters) {
+    Memory reference_memory;
+    Memory cached_memory;
+    for (Memory *memory : {&reference_memory, &cached_memory}) {
+        memory->WriteByte(0x0015, 0x11);
+        memory->WriteByte(0x0085, 0x34);
+        memory->WriteByte(0x0086, 0x12);
+        memory->WriteByte(0x1234, 0x33);
+        memory->WriteByte(0x210E, 0x99);
+        LoadProgram(*memory, 0x8000,
+                    {
+                        0xA2, 0x05,       // LDX #$05
+                        0xB5, 0x10,       // LDA $10,X
+                        0x85, 0x40,       // STA $40
+                        0xA1, 0x80,       // LDA ($80,X)
+                        0x8D, 0x00, 0x20, // STA $2000
+                        0xA2, 0x10,       // LDX #$10
+                        0xBD, 0xFE, 0x20, // LDA $20FE,X (page cross)
+                        0x9D, 0xFE, 0x20, // STA $20FE,X
+                        0xEA,             // NOP
+                    });
+    }
+
+    CPU reference(reference_memory);
+    CPU cached(cached_memory);
+    reference.Reset();
+    cached.Reset();
+    BlockCache cache(cached);
+
+    reference.Execute(33);
+    cache.Execute(33);
+
+    ExpectSameState(reference, cached);
+    EXPECT_EQ(cached.A, 0x99);
+    EXPECT_EQ(cached_memory.ReadByte(0x2000), 0x33);
+    EXPECT_EQ(cached_memory.ReadByte(0x210E), 0x99);
+}
+
+TEST(BlockCacheTest, StopsAtCycleBudgetInsideBlock) {
+    Memory memory;
+    LoadProgram(memory, 0x8000, {0xA9, 0x01, 0xA2, 0x02, 0xA0, 0x03});
+
+    CPU cpu(memory);
+    cpu.Reset();
+    BlockCache cache(cpu);
+    const u32 start_cycles = cpu.cycles;
+
+    cache.Execute(3);
+
+    EXPECT_EQ(cpu.PC, 0x8004);
+    EXPECT_EQ(cpu.A, 0x01);
+    EXPECT_EQ(cpu.X, 0x02);
+    EXPECT_EQ(cpu.Y, 0x00);
+    EXPECT_EQ(cpu.cycles, start_cycles + 4);
+
+    cache.Execute(2);
+
+    EXPECT_EQ(cpu.PC, 0x8006);
+    EXPECT_EQ(cpu.Y, 0x03);
+}
+
+TEST(BlockCacheTest, ReusesBlockOnReentry) {
+    Memory memory;
+    memory.WriteByte(0x0042, 0x7F);
+    LoadProgram(memory, 0x8000, {0xA5, 0x42, 0x85, 0x43});
+
+    CPU cpu(memory);
+    BlockCache cache(cpu);
+    for (int i = 0; i < 3; ++i) {
+        cpu.Reset();
+        cache.Execute(6);
+        EXPECT_EQ(cpu.PC, 0x8004);
+        EXPECT_EQ(cpu.cycles, 12u);
+    }
+    EXPECT_EQ(memory.ReadByte(0x0043), 0x7F);
+}
+
+TEST(BlockCacheTest, SelfModifyingStoreInvalidatesCurrentBlock) {
+    Memory memory;
+    LoadProgram(memory, 0x8000,
+                {
+                    0xA9, 0x55,       // LDA #$55
+                    0x8D, 0x07, 0x80, // STA $8007 (operand of the LDX below)
+                    0xEA,             // NOP
+                    0xA2, 0x00,       // LDX #$00 -> becomes LDX #$55
+                });
+
+    CPU cpu(memory);
+    cpu.Reset();
+    BlockCache cache(cpu);
+
+    cache.Execute(10);
+
+    EXPECT_EQ(cpu.PC, 0x8008);
+    EXPECT_EQ(cpu.X, 0x55);
+}
+
+TEST(BlockCacheTest, HostWriteInvalidatesDecodedBlock) {
+    Memory memory;
+    LoadProgram(memory, 0x8000, {0xA9, 0x01});
+
+    CPU cpu(memory);
+    BlockCache cache(cpu);
+    cpu.Reset();
+    cache.Execute(2);
+    EXPECT_EQ(cpu.A, 0x01);
+
+    memory.WriteByte(0x8001, 0x02);
+    cpu.Reset();
+    cache.Execute(2);
+    EXPECT_EQ(cpu.A, 0x02);
+}
+
+TEST(BlockCacheTest, WriteToNextPageInvalidatesStraddlingInstruction) {
+    Memory memory;
+    LoadProgram(memory, 0x80FE, {0xAD, 0x34, 0x12}); // LDA $1234, high operand byte on page $81
+    memory.WriteByte(0x1234, 0x11);
+    memory.WriteByte(0x2234, 0x22);
+
+    CPU cpu(memory);
+    BlockCache cache(cpu);
+    cpu.Reset();
+    cache.Execute(4);
+    EXPECT_EQ(cpu.A, 0x11);
+
+    memory.WriteByte(0x8100, 0x22);
+    cpu.Reset();
+    cache.Execute(4);
+    EXPECT_EQ(cpu.A, 0x22);
+}
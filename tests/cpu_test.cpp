@@ -1,5 +1,6 @@
 #include <cpu6502/cpu.hpp>
 #include <gtest/gtest.h>
+#include <vector>
 
 TEST(CPUTest, CPUConstructorInitializesDefaults) {
     Memory memory;
@@ -52,7 +53,7 @@ TEST(CPUTest, Execute_NOP_Consumes2CyclesAndAdvancesPC) {
     EXPECT_EQ(cpu.cycles, start_cycles + 2);
 }
 
-#ifdef NDEBUG
+#if defined(NDEBUG) || defined(FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION)
 TEST(CPUTest, Execute_UnknownOpcode_SkipsInReleaseBuild) {
     Memory memory;
     memory.WriteByte(0xFFFC, 0x00);
@@ -848,3 +849,281 @@ TEST(CPUTest, Execute_STYZeroPageX_Consumes4CyclesAndWraps) {
     EXPECT_EQ(cpu.PC, 0x8002);
     EXPECT_EQ(cpu.cycles, start + 4);
 }
+
+TEST(CPUTest, StatusRegister_ReflectsLoadsAndReset) {
+    Memory memory;
+    memory.WriteByte(0xFFFC, 0x00);
+    memory.WriteByte(0xFFFD, 0x80);
+    memory.WriteByte(0x8000, 0xA9); // LDA #$00
+    memory.WriteByte(0x8001, 0x00);
+    memory.WriteByte(0x8002, 0xA2); // LDX #$80
+    memory.WriteByte(0x8003, 0x80);
+    memory.WriteByte(0x8004, 0xA0); // LDY #$01
+    memory.WriteByte(0x8005, 0x01);
+
+    CPU cpu(memory);
+    EXPECT_EQ(cpu.StatusRegister(), 0x20);
+    cpu.Reset();
+    EXPECT_EQ(cpu.StatusRegister(), 0x24);
+
+    cpu.Execute(2);
+    EXPECT_EQ(cpu.StatusRegister(), 0x26);
+    cpu.Execute(2);
+    EXPECT_EQ(cpu.StatusRegister(), 0xA4);
+    cpu.Execute(2);
+    EXPECT_EQ(cpu.StatusRegister(), 0x24);
+}
+
+TEST(CPUTest, SetStatusRegister_RoundTripsEveryByte) {
+    Memory memory;
+    CPU cpu(memory);
+    for (u32 p = 0; p < 0x100; ++p) {
+        cpu.SetStatusRegister(static_cast<Byte>(p));
+        ASSERT_EQ(cpu.StatusRegister(), p);
+    }
+}
+
+namespace {
+class RecordingObserver final : public InstructionObserver {
+public:
+    std::vector<InstructionRecord> records;
+    void OnInstruction(const InstructionRecord &record) override { records.push_back(record); }
+};
+
+void LoadPolicyProgram(Memory &memory) {
+    memory.WriteByte(0xFFFC, 0x00);
+    memory.WriteByte(0xFFFD, 0x80);
+    memory.WriteByte(0x0010, 0x34);
+    memory.WriteByte(0x8000, 0xA9); // LDA #$80
+    memory.WriteByte(0x8001, 0x80);
+    memory.WriteByte(0x8002, 0xA6); // LDX $10
+    memory.WriteByte(0x8003, 0x10);
+    memory.WriteByte(0x8004, 0x8D); // STA $0200
+    memory.WriteByte(0x8005, 0x00);
+    memory.WriteByte(0x8006, 0x02);
+    memory.WriteByte(0x8007, 0x02); // not implemented
+    memory.WriteByte(0x8008, 0xEA); // NOP
+}
+} // namespace
+
+TEST(CPUTest, FunctionalCPU_CountsInstructionsAndMatchesRegisters) {
+    Memory memory;
+    LoadPolicyProgram(memory);
+    FunctionalCPU cpu(memory);
+    cpu.Reset();
+    EXPECT_EQ(cpu.cycles, 0u);
+
+    cpu.Execute(3);
+
+    EXPECT_EQ(cpu.cycles, 3u);
+    EXPECT_EQ(cpu.PC, 0x8007);
+    EXPECT_EQ(cpu.A, 0x80);
+    EXPECT_EQ(cpu.X, 0x34);
+    EXPECT_EQ(memory.ReadByte(0x0200), 0x80);
+    EXPECT_EQ(cpu.StatusRegister(), 0x24);
+
+    // Unknown opcodes are skipped even in debug builds.
+    cpu.Execute(2);
+    EXPECT_EQ(cpu.PC, 0x8009);
+    EXPECT_EQ(cpu.cycles, 5u);
+}
+
+TEST(CPUTest, FunctionalCPU_ContinuesFromCycleAccurateState) {
+    Memory memory;
+    LoadPolicyProgram(memory);
+    CPU accurate(memory);
+    accurate.Reset();
+    accurate.Execute(2);
+
+    FunctionalCPU fast(memory, accurate);
+    fast.Execute(2);
+
+    EXPECT_EQ(fast.PC, 0x8007);
+    EXPECT_EQ(fast.X, 0x34);
+    EXPECT_EQ(accurate.StatusRegister(), 0xA4);
+    EXPECT_EQ(fast.StatusRegister(), 0x24);
+}
+
+TEST(CPUTest, TracingCPU_ReportsEveryInstructionBeforeItRuns) {
+    Memory memory;
+    LoadPolicyProgram(memory);
+    TracingCPU cpu(memory);
+    RecordingObserver observer;
+    cpu.Reset();
+    cpu.Execute(2);
+    cpu.SetObserver(&observer);
+
+    cpu.Execute(7);
+
+    ASSERT_EQ(observer.records.size(), 2u);
+    const InstructionRecord &load = observer.records[0];
+    EXPECT_EQ(load.pc, 0x8002);
+    EXPECT_EQ(load.opcode, 0xA6);
+    EXPECT_EQ(load.operand, 0x0010);
+    EXPECT_EQ(load.a, 0x80);
+    EXPECT_EQ(load.x, 0x00);
+    EXPECT_EQ(load.sp, 0xFD);
+    EXPECT_EQ(load.p, 0xA4);
+    EXPECT_EQ(load.cycles, 8u);
+    const InstructionRecord &store = observer.records[1];
+    EXPECT_EQ(store.pc, 0x8004);
+    EXPECT_EQ(store.operand, 0x0200);
+    EXPECT_EQ(store.x, 0x34);
+    EXPECT_EQ(store.cycles, 11u);
+    EXPECT_EQ(cpu.cycles, 15u);
+}
+
+namespace {
+// Asserts IRQ on the CPU whenever it writes the device page.
+class IrqDevice final : public BusDevice {
+public:
+    CPU *cpu = nullptr;
+
+    Byte Read(Word) override { return 0x00; }
+    void Write(Word, const Byte Value) override { cpu->SetIRQ(Value != 0); }
+};
+
+// NOPs from $8000 with handlers at $9000 (IRQ and BRK) and $9100 (NMI): each loads a marker into Y and returns.
+void LoadInterruptProgram(Memory &memory) {
+    memory.WriteWord(0xFFFC, 0x8000);
+    memory.WriteWord(0xFFFE, 0x9000);
+    memory.WriteWord(0xFFFA, 0x9100);
+    for (u32 addr = 0x8000; addr < 0x8100; ++addr)
+        memory.WriteByte(static_cast<Word>(addr), 0xEA);
+    const Byte irq[] = {0xA0, 0x11, 0x40};
+    memory.WriteBlock(0x9000, irq, sizeof(irq));
+    const Byte nmi[] = {0xA0, 0x22, 0x40};
+    memory.WriteBlock(0x9100, nmi, sizeof(nmi));
+}
+} // namespace
+
+TEST(CPUTest, BRK_PushesReturnAddressAndStatusThenRTIReturns) {
+    Memory memory;
+    LoadInterruptProgram(memory);
+    memory.WriteByte(0x8000, 0x00);
+    CPU cpu(memory);
+    cpu.Reset();
+    cpu.SetStatusRegister(0x21);
+
+    cpu.Execute(7);
+    EXPECT_EQ(cpu.PC, 0x9000);
+    EXPECT_EQ(cpu.cycles, 6u + 7u);
+    EXPECT_EQ(cpu.SP, 0x00FA);
+    EXPECT_EQ(memory.ReadByte(0x01FD), 0x80);
+    EXPECT_EQ(memory.ReadByte(0x01FC), 0x02);
+    // B and the unused bit are set in the pushed copy only.
+    EXPECT_EQ(memory.ReadByte(0x01FB), 0x31);
+    EXPECT_EQ(cpu.StatusRegister(), 0x25);
+
+    cpu.Execute(8);
+    EXPECT_EQ(cpu.Y, 0x11);
+    EXPECT_EQ(cpu.PC, 0x8002);
+    EXPECT_EQ(cpu.SP, 0x00FD);
+    EXPECT_EQ(cpu.StatusRegister(), 0x21);
+    EXPECT_EQ(cpu.cycles, 6u + 7u + 2u + 6u);
+}
+
+TEST(CPUTest, IRQ_IsMaskedByIAndTakenOneInstructionAfterCLI) {
+    Memory memory;
+    LoadInterruptProgram(memory);
+    // SEI; NOP; CLI; NOP...
+    const Byte program[] = {0x78, 0xEA, 0x58};
+    memory.WriteBlock(0x8000, program, sizeof(program));
+    CPU cpu(memory);
+    cpu.Reset();
+    cpu.SetIRQ(true);
+
+    cpu.Execute(4);
+    EXPECT_EQ(cpu.PC, 0x8002);
+    cpu.Execute(2);
+    EXPECT_EQ(cpu.PC, 0x8003);
+    // The instruction after CLI still runs before the IRQ.
+    cpu.Execute(9);
+    EXPECT_EQ(cpu.PC, 0x9000);
+    EXPECT_EQ(memory.ReadByte(0x01FC), 0x04);
+    // The pushed status has B clear.
+    EXPECT_EQ(memory.ReadByte(0x01FB) & 0x10, 0x00);
+    EXPECT_EQ(cpu.cycles, 6u + 6u + 2u + 7u);
+
+    // The line is still asserted when the handler returns, so the IRQ is taken again right after RTI.
+    cpu.Execute(8);
+    EXPECT_EQ(cpu.PC, 0x8004);
+    cpu.Execute(7);
+    EXPECT_EQ(cpu.PC, 0x9000);
+    cpu.SetIRQ(false);
+    cpu.Execute(8);
+    EXPECT_EQ(cpu.PC, 0x8004);
+}
+
+TEST(CPUTest, IRQ_IsNotTakenBetweenCLIAndSEI) {
+    Memory memory;
+    LoadInterruptProgram(memory);
+    // SEI; CLI; SEI; NOP...
+    const Byte program[] = {0x78, 0x58, 0x78};
+    memory.WriteBlock(0x8000, program, sizeof(program));
+    CPU cpu(memory);
+    cpu.Reset();
+    cpu.SetIRQ(true);
+
+    cpu.Execute(100);
+    EXPECT_EQ(cpu.Y, 0x00);
+    EXPECT_EQ(cpu.SP, 0xFD);
+    EXPECT_EQ(cpu.StatusRegister() & 0x04, 0x04);
+}
+
+TEST(CPUTest, NMI_IsTakenOnceEvenWithIMasked) {
+    Memory memory;
+    LoadInterruptProgram(memory);
+    CPU cpu(memory);
+    cpu.Reset();
+    cpu.TriggerNMI();
+
+    cpu.Execute(7);
+    EXPECT_EQ(cpu.PC, 0x9100);
+    cpu.Execute(8);
+    EXPECT_EQ(cpu.Y, 0x22);
+    EXPECT_EQ(cpu.PC, 0x8000);
+    cpu.Execute(4);
+    EXPECT_EQ(cpu.PC, 0x8002);
+}
+
+TEST(CPUTest, DeviceRaisedIRQIsTakenAtTheNextInstruction) {
+    Memory memory;
+    LoadInterruptProgram(memory);
+    IrqDevice device;
+    memory.MapDevice(0xD0, 0xD0, &device);
+    // CLI; LDA #$01; STA $D000; NOP...
+    const Byte program[] = {0x58, 0xA9, 0x01, 0x8D, 0x00, 0xD0};
+    memory.WriteBlock(0x8000, program, sizeof(program));
+    CPU cpu(memory);
+    device.cpu = &cpu;
+    cpu.Reset();
+
+    cpu.Execute(100);
+    EXPECT_EQ(cpu.Y, 0x11);
+    EXPECT_EQ(memory.ReadByte(0x01FC), 0x06);
+}
+
+TEST(CPUTest, RequestStop_EndsExecuteAtTheNextInstruction) {
+    Memory memory;
+    LoadInterruptProgram(memory);
+    CPU cpu(memory);
+    cpu.Reset();
+
+    cpu.RequestStop();
+    cpu.Execute(100);
+    EXPECT_EQ(cpu.PC, 0x8000);
+    cpu.Execute(4);
+    EXPECT_EQ(cpu.PC, 0x8002);
+}
+
+TEST(CPUTest, Reset_ClearsARequestedStop) {
+    Memory memory;
+    LoadInterruptProgram(memory);
+    CPU cpu(memory);
+    cpu.RequestStop();
+    cpu.Reset();
+
+    cpu.Execute(4);
+    EXPECT_EQ(cpu.PC, 0x8002);
+}
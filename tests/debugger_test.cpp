@@ -0,0 +1,199 @@
+#include <cpu6502/block_cache.hpp>
+#include <cpu6502/debugger.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+namespace {
+// LDA #$05; LDX #$03; STA $0205; LDA $0310; NOP; NOP from $8000.
+void LoadProgram(Memory &memory) {
+    memory.WriteWord(0xFFFC, 0x8000);
+    const Byte program[] = {0xA9, 0x05, 0xA2, 0x03, 0x8D, 0x05, 0x02, 0xAD, 0x10, 0x03, 0xEA, 0xEA};
+    memory.WriteBlock(0x8000, program, sizeof(program));
+}
+} // namespace
+
+TEST(DebuggerTest, BreakpointStopsBeforeTheInstructionAndResumingRunsIt) {
+    Memory memory;
+    LoadProgram(memory);
+    CPU cpu(memory);
+    Debugger debugger(memory);
+    cpu.SetDebugger(&debugger);
+    const u32 id = debugger.AddBreakpoint(0x8004);
+    cpu.Reset();
+
+    cpu.Execute(100);
+    EXPECT_EQ(cpu.PC, 0x8004);
+    EXPECT_EQ(cpu.cycles, 10u);
+    EXPECT_EQ(memory.ReadByte(0x0205), 0x00);
+    const StopReason stop = debugger.LastStop();
+    EXPECT_EQ(stop.kind, StopKind::Breakpoint);
+    EXPECT_EQ(stop.id, id);
+    EXPECT_EQ(stop.pc, 0x8004);
+    EXPECT_EQ(stop.value, 0x8D);
+
+    cpu.Execute(4);
+    EXPECT_EQ(cpu.PC, 0x8007);
+    EXPECT_EQ(memory.ReadByte(0x0205), 0x05);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::None);
+}
+
+TEST(DebuggerTest, ConditionalBreakpointStopsOnlyWhenEveryConditionHolds) {
+    Memory memory;
+    LoadProgram(memory);
+    memory.WriteByte(0x0010, 0x42);
+    CPU cpu(memory);
+    Debugger debugger(memory);
+    cpu.SetDebugger(&debugger);
+    debugger.AddBreakpoint(0x8004, {{DebugOperand::X, DebugCompare::Equal, 0x04}});
+    debugger.AddBreakpoint(0x8007, {{DebugOperand::X, DebugCompare::Equal, 0x03},
+                                    {DebugOperand::Memory, DebugCompare::Equal, 0x42, 0x0010}});
+    cpu.Reset();
+
+    cpu.Execute(100);
+    EXPECT_EQ(cpu.PC, 0x8007);
+    EXPECT_EQ(debugger.LastStop().pc, 0x8007);
+    EXPECT_EQ(memory.ReadByte(0x0205), 0x05);
+}
+
+TEST(DebuggerTest, WriteWatchpointStopsAfterTheWritingInstruction) {
+    Memory memory;
+    LoadProgram(memory);
+    CPU cpu(memory);
+    Debugger debugger(memory);
+    cpu.SetDebugger(&debugger);
+    debugger.AddWatchpoint(0x0200, 0x02FF, false, true);
+    cpu.Reset();
+
+    cpu.Execute(100);
+    EXPECT_EQ(cpu.PC, 0x8007);
+    const StopReason stop = debugger.LastStop();
+    EXPECT_EQ(stop.kind, StopKind::Watchpoint);
+    EXPECT_EQ(stop.address, 0x0205);
+    EXPECT_EQ(stop.value, 0x05);
+    EXPECT_TRUE(stop.write);
+    EXPECT_EQ(stop.cycles, cpu.cycles);
+}
+
+TEST(DebuggerTest, WatchpointHitByTheLastInstructionOfABudgetStops) {
+    Memory memory;
+    LoadProgram(memory);
+    CPU cpu(memory);
+    Debugger debugger(memory);
+    cpu.SetDebugger(&debugger);
+    debugger.AddWatchpoint(0x0205, 0x0205, false, true);
+    cpu.Reset();
+
+    cpu.Execute(2);
+    cpu.Execute(2);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::None);
+    cpu.Execute(4);
+    EXPECT_EQ(cpu.PC, 0x8007);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::Watchpoint);
+    EXPECT_EQ(debugger.LastStop().address, 0x0205);
+
+    cpu.Execute(1);
+    EXPECT_EQ(cpu.PC, 0x800A);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::None);
+}
+
+TEST(DebuggerTest, ReadWatchpointChecksTheValueRead) {
+    Memory memory;
+    LoadProgram(memory);
+    memory.WriteByte(0x0310, 0x11);
+    CPU cpu(memory);
+    Debugger debugger(memory);
+    cpu.SetDebugger(&debugger);
+    debugger.AddWatchpoint(0x0200, 0x03FF, true, false, {{DebugOperand::Value, DebugCompare::Equal, 0x7E}});
+    cpu.Reset();
+
+    cpu.Execute(14);
+    EXPECT_EQ(cpu.PC, 0x800B);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::None);
+
+    memory.WriteByte(0x0310, 0x7E);
+    cpu.Reset();
+    cpu.Execute(100);
+    EXPECT_EQ(cpu.PC, 0x800A);
+    EXPECT_EQ(debugger.LastStop().address, 0x0310);
+    EXPECT_FALSE(debugger.LastStop().write);
+}
+
+TEST(DebuggerTest, HostAccessesAndRemovedPointsDoNotStop) {
+    Memory memory;
+    LoadProgram(memory);
+    CPU cpu(memory);
+    Debugger debugger(memory);
+    cpu.SetDebugger(&debugger);
+    const u32 watch = debugger.AddWatchpoint(0x0205, 0x0205, true, true);
+    const u32 breakpoint = debugger.AddBreakpoint(0x8002);
+    cpu.Reset();
+
+    memory.WriteByte(0x0205, 0x01);
+    EXPECT_EQ(memory.ReadByte(0x0205), 0x01);
+    debugger.Remove(breakpoint);
+    cpu.Execute(2);
+    EXPECT_EQ(cpu.PC, 0x8002);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::None);
+
+    debugger.Remove(watch);
+    cpu.Execute(100);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::None);
+    EXPECT_EQ(memory.ReadByte(0x0205), 0x05);
+}
+
+TEST(DebuggerTest, BlockCacheStopsAtWatchpoints) {
+    Memory memory;
+    LoadProgram(memory);
+    CPU cpu(memory);
+    BlockCache cache(cpu);
+    Debugger debugger(memory);
+    cpu.SetDebugger(&debugger);
+    debugger.AddWatchpoint(0x0205, 0x0205, false, true);
+    cpu.Reset();
+
+    cache.Execute(100);
+    EXPECT_EQ(cpu.PC, 0x8007);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::Watchpoint);
+}
+
+TEST(DebuggerTest, BlockCacheDecodingAheadDoesNotHitReadWatchpoints) {
+    Memory memory;
+    memory.WriteWord(0xFFFC, 0x8000);
+    // LDA #$01; LDA #$02; LDA #$03; LDA #$04
+    const Byte program[] = {0xA9, 0x01, 0xA9, 0x02, 0xA9, 0x03, 0xA9, 0x04};
+    memory.WriteBlock(0x8000, program, sizeof(program));
+    CPU cpu(memory);
+    BlockCache cache(cpu);
+    Debugger debugger(memory);
+    cpu.SetDebugger(&debugger);
+    debugger.AddWatchpoint(0x8006, 0x8006, true, false);
+    cpu.Reset();
+
+    cache.Execute(2);
+    EXPECT_EQ(cpu.PC, 0x8002);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::None);
+    cache.Execute(4);
+    EXPECT_EQ(cpu.PC, 0x8006);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::None);
+}
+
+TEST(DebuggerTest, SecondDebuggerOnTheSameMemoryIsRejected) {
+    Memory memory;
+    LoadProgram(memory);
+    CPU cpu(memory);
+    Debugger debugger(memory);
+    cpu.SetDebugger(&debugger);
+    debugger.AddWatchpoint(0x0205, 0x0205, false, true);
+    cpu.Reset();
+
+    EXPECT_THROW(Debugger{memory}, std::logic_error);
+    cpu.Execute(100);
+    EXPECT_EQ(cpu.PC, 0x8007);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::Watchpoint);
+}
+
+TEST(DebuggerTest, RejectsReversedWatchRange) {
+    Memory memory;
+    Debugger debugger(memory);
+    EXPECT_THROW(debugger.AddWatchpoint(0x0300, 0x0200, true, true), std::invalid_argument);
+}
@@ -0,0 +1,182 @@
+// Runs the functional test ROMs listed in a manifest on CPU and FunctionalCPU in parallel. A ROM passes when it
+// traps at its success address, the way Klaus Dormann's 6502 functional tests report success, and fails on a trap
+// anywhere else or when it runs out of cycles. In optimized builds each run must also reach the manifest's
+// throughput floor, so a slow core fails the same way a wrong one does.
+//
+// Manifest lines: file load start success max_cycles min_mips min_mhz. load is the address of raw images and start
+// the PC to begin at; "-" uses the image's own addresses and the reset vector. min_mips applies to FunctionalCPU,
+// which counts instructions, and min_mhz to the cycle-accurate CPU.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cpu6502/cpu.hpp>
+#include <cpu6502/loader.hpp>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+// Cycles run between trap probes; a trapped ROM spends at most this much past its trap.
+constexpr u32 SLICE = 1 << 16;
+
+struct Rom {
+    std::string name;
+    std::string path;
+    bool has_load = false;
+    Word load = 0;
+    bool has_start = false;
+    Word start = 0;
+    Word success = 0;
+    u64 max_cycles = 0;
+    double min_rate = 0.0;
+    bool functional = false;
+};
+
+struct Outcome {
+    bool trapped = false;
+    Word pc = 0;
+    u64 count = 0;
+    double seconds = 0.0;
+    std::string error;
+};
+
+u32 ParseNumber(const std::string &text) {
+    return static_cast<u32>(text[0] == '$' ? std::stoul(text.substr(1), nullptr, 16) : std::stoul(text, nullptr, 0));
+}
+
+std::vector<Rom> ReadManifest(const std::string &path) {
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error("cannot read " + path);
+    const std::string dir = path.substr(0, path.find_last_of('/') + 1);
+    std::vector<Rom> roms;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string file, load, start, success, max_cycles, min_mips, min_mhz;
+        if (!(fields >> file) || file[0] == '#')
+            continue;
+        if (!(fields >> load >> start >> success >> max_cycles >> min_mips >> min_mhz))
+            throw std::runtime_error(path + ": incomplete line for " + file);
+        Rom rom;
+        rom.path = file[0] == '/' ? file : dir + file;
+        rom.has_load = load != "-";
+        rom.load = rom.has_load ? static_cast<Word>(ParseNumber(load)) : Word{0};
+        rom.has_start = start != "-";
+        rom.start = rom.has_start ? static_cast<Word>(ParseNumber(start)) : Word{0};
+        rom.success = static_cast<Word>(ParseNumber(success));
+        rom.max_cycles = std::stoull(max_cycles);
+        rom.name = file + " (CPU)";
+        rom.min_rate = std::stod(min_mhz);
+        roms.push_back(rom);
+        rom.name = file + " (FunctionalCPU)";
+        rom.functional = true;
+        rom.min_rate = std::stod(min_mips);
+        roms.push_back(rom);
+    }
+    return roms;
+}
+
+std::string Hex(const Word address) {
+    char text[8];
+    std::snprintf(text, sizeof(text), "$%04X", address);
+    return text;
+}
+
+// Runs SLICE at a time and then probes one instruction: a trap is an instruction that leaves PC where it was.
+template <typename Policy> Outcome Run(const Rom &rom) {
+    Outcome outcome;
+    const auto memory = std::make_unique<Memory>();
+    try {
+        LoadOptions options;
+        options.base = rom.load;
+        ImageLoader::LoadFile(*memory, rom.path, ImageLoader::FormatForPath(rom.path), options);
+    } catch (const std::exception &error) {
+        outcome.error = error.what();
+        return outcome;
+    }
+    BasicCPU<Policy> cpu(*memory);
+    const auto start = std::chrono::steady_clock::now();
+    cpu.Reset();
+    if (rom.has_start)
+        cpu.PC = rom.start;
+    const u32 first = cpu.cycles;
+    while (cpu.cycles - first < rom.max_cycles) {
+        cpu.Execute(SLICE);
+        const Word pc = cpu.PC;
+        cpu.Execute(1);
+        if (cpu.PC == pc) {
+            outcome.trapped = true;
+            break;
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    outcome.pc = cpu.PC;
+    outcome.count = cpu.cycles - first;
+    outcome.seconds = elapsed.count();
+    return outcome;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s MANIFEST\n", argv[0]);
+        return 2;
+    }
+    std::vector<Rom> roms;
+    try {
+        roms = ReadManifest(argv[1]);
+    } catch (const std::exception &error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 2;
+    }
+
+    std::vector<Outcome> outcomes(roms.size());
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] {
+        for (std::size_t i = next++; i < roms.size(); i = next++)
+            outcomes[i] = roms[i].functional ? Run<FunctionalPolicy>(roms[i]) : Run<CycleAccuratePolicy>(roms[i]);
+    };
+    const unsigned threads =
+        std::max(1u, std::min(std::thread::hardware_concurrency(), static_cast<unsigned>(roms.size())));
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread &thread : pool)
+        thread.join();
+
+    int failures = 0;
+    for (std::size_t i = 0; i < roms.size(); ++i) {
+        const Rom &rom = roms[i];
+        const Outcome &outcome = outcomes[i];
+        const double rate = outcome.seconds > 0.0 ? static_cast<double>(outcome.count) / outcome.seconds / 1e6 : 0.0;
+        const char *unit = rom.functional ? "M instructions/s" : "MHz";
+        std::string verdict = "ok";
+        if (!outcome.error.empty())
+            verdict = "FAILED: " + outcome.error;
+        else if (!outcome.trapped)
+            verdict = "FAILED: no trap within the cycle budget";
+        else if (outcome.pc != rom.success)
+            verdict = "FAILED: trapped at " + Hex(outcome.pc);
+#ifdef NDEBUG
+        else if (rate < rom.min_rate)
+            verdict = "FAILED: below the " + std::to_string(rom.min_rate) + " " + unit + " floor";
+#endif
+        if (verdict != "ok")
+            ++failures;
+        std::printf("%-40s %s, %llu %s in %.3f s, %.1f %s\n", rom.name.c_str(), verdict.c_str(),
+                    static_cast<unsigned long long>(outcome.count), rom.functional ? "instructions" : "cycles",
+                    outcome.seconds, rate, unit);
+    }
+#ifndef NDEBUG
+    std::printf("Throughput floors are only checked in optimized builds.\n");
+#endif
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+#include <cpu6502/gdb_stub.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+// Scripted client: sends one packet, checks its ack and returns the acked reply.
+class Client {
+    int fd;
+    std::string input;
+
+    char Next() {
+        while (input.empty()) {
+            char buffer[4096];
+            const ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+            if (received <= 0)
+                return '\0';
+            input.append(buffer, static_cast<std::size_t>(received));
+        }
+        const char c = input[0];
+        input.erase(0, 1);
+        return c;
+    }
+
+public:
+    explicit Client(const int Socket) : fd(Socket) {}
+    ~Client() { close(fd); }
+
+    void Send(const std::string &bytes) const {
+        ASSERT_EQ(send(fd, bytes.data(), bytes.size(), 0), static_cast<ssize_t>(bytes.size()));
+    }
+
+    std::string Reply() {
+        while (Next() != '$') {
+        }
+        std::string payload;
+        for (char c = Next(); c != '#'; c = Next())
+            payload += c;
+        Next();
+        Next();
+        Send("+");
+        return payload;
+    }
+
+    std::string Transact(const std::string &payload) {
+        unsigned sum = 0;
+        for (const char c : payload)
+            sum += static_cast<unsigned char>(c);
+        char checksum[4];
+        std::snprintf(checksum, sizeof(checksum), "%02x", sum & 0xFF);
+        Send("$" + payload + "#" + checksum);
+        EXPECT_EQ(Next(), '+');
+        return Reply();
+    }
+};
+
+// LDA #$05; LDX #$03; STA $0205; LDA $0310; NOP; NOP from $8000, then BRKs through $0000 forever.
+class GdbStubTest : public ::testing::Test {
+protected:
+    Memory memory;
+    CPU cpu{memory};
+    GdbStub stub{cpu};
+    std::thread server;
+    std::unique_ptr<Client> client;
+
+    void SetUp() override {
+        memory.WriteWord(0xFFFC, 0x8000);
+        const Byte program[] = {0xA9, 0x05, 0xA2, 0x03, 0x8D, 0x05, 0x02, 0xAD, 0x10, 0x03, 0xEA, 0xEA};
+        memory.WriteBlock(0x8000, program, sizeof(program));
+        cpu.Reset();
+        int sockets[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+        server = std::thread([this, socket = sockets[0]] { stub.Serve(socket); });
+        client = std::make_unique<Client>(sockets[1]);
+    }
+
+    void TearDown() override {
+        client->Transact("D");
+        server.join();
+    }
+};
+} // namespace
+
+TEST_F(GdbStubTest, ReadsAndWritesRegistersAndMemoryBlocks) {
+    EXPECT_NE(client->Transact("qSupported:swbreak+").find("PacketSize=4000"), std::string::npos);
+    EXPECT_EQ(client->Transact("?"), "S05");
+    // a, x, y, p and sp, then pc little endian
+    EXPECT_EQ(client->Transact("g"), "00000024fd0080");
+    EXPECT_EQ(client->Transact("p5"), "0080");
+    EXPECT_EQ(client->Transact("P1=7f"), "OK");
+    EXPECT_EQ(cpu.X, 0x7F);
+
+    EXPECT_EQ(client->Transact("m8000,c"), "a905a2038d0502ad1003eaea");
+    EXPECT_EQ(client->Transact("M0200,3:abcdef"), "OK");
+    // '#' escaped as '}' followed by '#' ^ 0x20
+    EXPECT_EQ(client->Transact("X0203,2:}\x03" "a"), "OK");
+    EXPECT_EQ(client->Transact("m0200,5"), "abcdef2361");
+    EXPECT_EQ(client->Transact("mfffe,4"), "0000");
+    // One reply carries up to half the packet size, so a page is one transfer.
+    EXPECT_EQ(client->Transact("m0000,100").size(), 512u);
+}
+
+TEST_F(GdbStubTest, StepsAndStopsAtBreakpoints) {
+    EXPECT_EQ(client->Transact("Z0,8004,1"), "OK");
+    EXPECT_EQ(client->Transact("c"), "S05");
+    EXPECT_EQ(cpu.PC, 0x8004);
+    EXPECT_EQ(client->Transact("s"), "S05");
+    EXPECT_EQ(cpu.PC, 0x8007);
+    EXPECT_EQ(memory.ReadByte(0x0205), 0x05);
+
+    // Continuing from a breakpoint runs it instead of stopping again.
+    EXPECT_EQ(client->Transact("Z0,800a,1"), "OK");
+    EXPECT_EQ(client->Transact("c8004"), "S05");
+    EXPECT_EQ(cpu.PC, 0x800A);
+    EXPECT_EQ(client->Transact("z0,800a,1"), "OK");
+    EXPECT_EQ(client->Transact("s"), "S05");
+    EXPECT_EQ(cpu.PC, 0x800B);
+}
+
+TEST_F(GdbStubTest, WatchpointsReportTheirAddress) {
+    EXPECT_EQ(client->Transact("Z2,0200,8"), "OK");
+    EXPECT_EQ(client->Transact("Z3,0310,1"), "OK");
+    EXPECT_EQ(client->Transact("c"), "T05watch:0205;");
+    EXPECT_EQ(cpu.PC, 0x8007);
+    EXPECT_EQ(client->Transact("c"), "T05rwatch:0310;");
+    EXPECT_EQ(cpu.PC, 0x800A);
+    EXPECT_EQ(client->Transact("Z9,0,1"), "E01");
+}
+
+TEST_F(GdbStubTest, SteppingAWatchedStoreReportsTheWatch) {
+    EXPECT_EQ(client->Transact("Z2,0205,1"), "OK");
+    EXPECT_EQ(client->Transact("Z0,8004,1"), "OK");
+    EXPECT_EQ(client->Transact("c"), "S05");
+    EXPECT_EQ(client->Transact("s"), "T05watch:0205;");
+    EXPECT_EQ(cpu.PC, 0x8007);
+}
+
+TEST_F(GdbStubTest, InterruptStopsARunningContinue) {
+    client->Send("$c#63");
+    client->Send("\x03");
+    EXPECT_EQ(client->Reply(), "S02");
+    EXPECT_EQ(client->Transact("?"), "S02");
+}
+
+TEST(GdbStubListenTest, ServesOverAUnixSocket) {
+    char directory[] = "/tmp/cpu6502_gdbXXXXXX";
+    ASSERT_NE(mkdtemp(directory), nullptr);
+    const std::string path = std::string(directory) + "/gdb.sock";
+    Memory memory;
+    CPU cpu(memory);
+    GdbStub stub(cpu);
+    const int listener = GdbStub::Listen(path);
+    std::thread server([&] { stub.Serve(GdbStub::Accept(listener)); });
+
+    const int socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::snprintf(address.sun_path, sizeof(address.sun_path), "%s", path.c_str());
+    ASSERT_EQ(connect(socket_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)), 0);
+    {
+        Client client(socket_fd);
+        EXPECT_EQ(client.Transact("QStartNoAckMode"), "OK");
+        client.Send("$k#6b");
+    }
+    server.join();
+    close(listener);
+    unlink(path.c_str());
+    rmdir(directory);
+    EXPECT_THROW(GdbStub::Listen("localhost:99999"), std::runtime_error);
+}
@@ -0,0 +1,320 @@
+#include <cpu6502/block_cache.hpp>
+#include <cpu6502/jit.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+#include "test_program.hpp"
+
+namespace {
+void LoadMixedProgram(Memory &memory) {
+    memory.WriteByte(0x0015, 0x11);
+    memory.WriteByte(0x0085, 0x34);
+    memory.WriteByte(0x0086, 0x12);
+    memory.WriteByte(0x1234, 0x80);
+    memory.WriteByte(0x00F0, 0xF8);
+    memory.WriteByte(0x00F1, 0x20);
+    memory.WriteByte(0x210E, 0x99);
+    memory.WriteByte(0x2108, 0x00);
+    LoadProgram(memory, 0x8000,
+                {
+                    0xA2, 0x05,       // LDX #$05
+                    0xB5, 0x10,       // LDA $10,X
+                    0x85, 0x40,       // STA $40
+                    0xA1, 0x80,       // LDA ($80,X)
+                    0x8D, 0x00, 0x20, // STA $2000
+                    0xA2, 0x10,       // LDX #$10
+                    0xBD, 0xFE, 0x20, // LDA $20FE,X (page cross)
+                    0x9D, 0xFE, 0x20, // STA $20FE,X
+                    0xA0, 0x10,       // LDY #$10
+                    0xB1, 0xF0,       // LDA ($F0),Y (page cross)
+                    0x91, 0xF0,       // STA ($F0),Y
+                    0x96, 0x40,       // STX $40,Y
+                    0xB6, 0x40,       // LDX $40,Y
+                    0xEA,             // NOP
+                    0x8C, 0x01, 0x20, // STY $2001
+                });
+}
+
+class CountingDevice final : public BusDevice {
+public:
+    u32 reads = 0;
+
+    Byte Read(const Word Address) override {
+        ++reads;
+        return static_cast<Byte>(Address + reads);
+    }
+    void Write(Word, Byte) override {}
+};
+
+// Raises IRQ on a write to its first byte and drops it on a write to any other.
+class IrqSwitchDevice final : public BusDevice {
+public:
+    CPU *cpu = nullptr;
+
+    Byte Read(Word) override { return 0x00; }
+    void Write(const Word Address, Byte) override { cpu->SetIRQ((Address & 0xFF) == 0x00); }
+};
+
+class JitTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Memory memory;
+        CPU cpu(memory);
+        if (!Jit(cpu).Available())
+            GTEST_SKIP() << "native code generation is not available on this host";
+    }
+};
+} // namespace
+
+TEST_F(JitTest, HotBlockIsCompiledAndMatchesInterpreter) {
+    Memory reference_memory;
+    Memory jit_memory;
+    LoadMixedProgram(reference_memory);
+    LoadMixedProgram(jit_memory);
+
+    CPU reference(reference_memory);
+    CPU cpu(jit_memory);
+    Jit jit(cpu, 1);
+    jit.EnableDifferential();
+
+    for (int run = 0; run < 3; ++run) {
+        reference.Reset();
+        cpu.Reset();
+        reference.Execute(56);
+        jit.Execute(56);
+
+        EXPECT_EQ(cpu.PC, reference.PC);
+        EXPECT_EQ(cpu.A, reference.A);
+        EXPECT_EQ(cpu.X, reference.X);
+        EXPECT_EQ(cpu.Y, reference.Y);
+        EXPECT_EQ(cpu.cycles, reference.cycles);
+    }
+    EXPECT_FALSE(jit.Diverged()) << jit.DivergenceReport();
+    EXPECT_EQ(jit.CompiledBlocks(), 1u);
+    EXPECT_GE(jit.NativeBlockRuns(), 3u);
+    EXPECT_EQ(jit_memory.ReadByte(0x2000), 0x80);
+    EXPECT_EQ(jit_memory.ReadByte(0x2001), 0x10);
+}
+
+TEST_F(JitTest, StoresToForkedPagesAndWrappedPointersMatchTheInterpreter) {
+    Memory image;
+    image.WriteByte(0x00FF, 0x10);
+    image.WriteByte(0x0000, 0x30);
+    image.WriteByte(0x3011, 0x5A);
+    image.WriteWord(0x0020, 0x0400);
+    // LDY #$01; LDA ($FF),Y; STA $0300; STA ($20),Y; STY $0301
+    LoadProgram(image, 0x8000, {0xA0, 0x01, 0xB1, 0xFF, 0x8D, 0x00, 0x03, 0x91, 0x20, 0x8C, 0x01, 0x03});
+
+    // A fork shares every page with the image, so the first store to each takes the slow path and copies it.
+    Memory memory = image.Fork();
+    CPU cpu(memory);
+    Jit jit(cpu, 1);
+    jit.EnableDifferential();
+    cpu.Reset();
+    jit.Execute(21);
+
+    EXPECT_FALSE(jit.Diverged()) << jit.DivergenceReport();
+    EXPECT_EQ(jit.NativeBlockRuns(), 1u);
+    EXPECT_EQ(cpu.A, 0x5A);
+    EXPECT_EQ(memory.ReadByte(0x0300), 0x5A);
+    EXPECT_EQ(memory.ReadByte(0x0401), 0x5A);
+    EXPECT_EQ(memory.ReadByte(0x0301), 0x01);
+    EXPECT_EQ(image.ReadByte(0x0300), 0x00);
+}
+
+TEST_F(JitTest, BlockIsInterpretedUntilHot) {
+    Memory memory;
+    LoadProgram(memory, 0x8000, {0xA9, 0x01});
+
+    CPU cpu(memory);
+    Jit jit(cpu, 3);
+    for (int run = 0; run < 2; ++run) {
+        cpu.Reset();
+        jit.Execute(2);
+    }
+    EXPECT_EQ(jit.CompiledBlocks(), 0u);
+
+    cpu.Reset();
+    jit.Execute(2);
+    EXPECT_EQ(jit.CompiledBlocks(), 1u);
+    EXPECT_EQ(cpu.A, 0x01);
+    EXPECT_EQ(cpu.PC, 0x8002);
+}
+
+TEST_F(JitTest, NativeBlockStopsAtCycleBudget) {
+    Memory memory;
+    LoadProgram(memory, 0x8000, {0xA9, 0x01, 0xA2, 0x02, 0xA0, 0x03});
+
+    CPU cpu(memory);
+    Jit jit(cpu, 1);
+    cpu.Reset();
+    const u32 start_cycles = cpu.cycles;
+
+    jit.Execute(3);
+
+    EXPECT_EQ(jit.CompiledBlocks(), 1u);
+    EXPECT_EQ(cpu.PC, 0x8004);
+    EXPECT_EQ(cpu.X, 0x02);
+    EXPECT_EQ(cpu.Y, 0x00);
+    EXPECT_EQ(cpu.cycles, start_cycles + 4);
+}
+
+TEST_F(JitTest, NativeBlockRunsAcrossCycleCounterWrap) {
+    Memory memory;
+    LoadProgram(memory, 0x8000, {0xA9, 0x01, 0xA2, 0x02, 0xA0, 0x03, 0xEA});
+
+    CPU cpu(memory);
+    Jit jit(cpu, 1);
+    jit.EnableDifferential();
+    cpu.Reset();
+    cpu.cycles = 0xFFFFFFFA;
+
+    jit.Execute(8);
+    EXPECT_EQ(jit.NativeBlockRuns(), 1u);
+    EXPECT_EQ(cpu.PC, 0x8007);
+    EXPECT_EQ(cpu.cycles, 2u);
+
+    cpu.Reset();
+    cpu.cycles = 0xFFFFFFFD;
+    jit.Execute(3);
+    EXPECT_EQ(cpu.PC, 0x8004);
+    EXPECT_EQ(cpu.X, 0x02);
+    EXPECT_EQ(cpu.cycles, 1u);
+    EXPECT_FALSE(jit.Diverged()) << jit.DivergenceReport();
+}
+
+TEST_F(JitTest, SelfModifyingStoreLeavesBlockAndRecompiles) {
+    Memory memory;
+    LoadProgram(memory, 0x8000,
+                {
+                    0xA9, 0x55,       // LDA #$55
+                    0x8D, 0x07, 0x80, // STA $8007 (operand of the LDX below)
+                    0xEA,             // NOP
+                    0xA2, 0x00,       // LDX #$00 -> becomes LDX #$55
+                });
+
+    CPU cpu(memory);
+    Jit jit(cpu, 1);
+    jit.EnableDifferential();
+    cpu.Reset();
+
+    jit.Execute(10);
+
+    EXPECT_EQ(cpu.PC, 0x8008);
+    EXPECT_EQ(cpu.X, 0x55);
+    EXPECT_FALSE(jit.Diverged()) << jit.DivergenceReport();
+}
+
+TEST_F(JitTest, RewrittenPageFallsBackToInterpreter) {
+    Memory memory;
+    LoadProgram(memory, 0x8000, {0xA9, 0x01});
+
+    CPU cpu(memory);
+    Jit jit(cpu, 1);
+    for (Byte value = 1; value <= Jit::SMC_PAGE_LIMIT + 2; ++value) {
+        memory.WriteByte(0x8001, value);
+        cpu.Reset();
+        jit.Execute(2);
+        EXPECT_EQ(cpu.A, value);
+    }
+    EXPECT_EQ(jit.CompiledBlocks(), Jit::SMC_PAGE_LIMIT);
+}
+
+TEST_F(JitTest, UntranslatableOpcodeIsInterpreted) {
+    Memory memory;
+    // LDA #$01; BRK with its handler at the LDX #$02 after the padding byte
+    LoadProgram(memory, 0x8000, {0xA9, 0x01, 0x00, 0xEA, 0xA2, 0x02});
+    memory.WriteWord(0xFFFE, 0x8004);
+
+    CPU cpu(memory);
+    Jit jit(cpu, 1);
+    jit.EnableDifferential();
+    cpu.Reset();
+    const u32 start_cycles = cpu.cycles;
+
+    jit.Execute(11);
+
+    EXPECT_EQ(cpu.PC, 0x8006);
+    EXPECT_EQ(cpu.X, 0x02);
+    EXPECT_EQ(cpu.cycles, start_cycles + 11);
+    EXPECT_FALSE(jit.Diverged()) << jit.DivergenceReport();
+}
+
+TEST_F(JitTest, DeviceReadsInNativeBlockGoThroughTheBus) {
+    Memory memory;
+    CountingDevice device;
+    memory.MapDevice(0xD0, 0xD0, &device);
+    memory.WriteByte(0x0010, 0x20);
+    memory.WriteByte(0x0011, 0xD0);
+    // LDA $D004; LDY #$01; LDA ($10),Y
+    LoadProgram(memory, 0x8000, {0xAD, 0x04, 0xD0, 0xA0, 0x01, 0xB1, 0x10});
+
+    CPU cpu(memory);
+    Jit jit(cpu, 1);
+    for (u32 run = 1; run <= 2; ++run) {
+        cpu.Reset();
+        jit.Execute(11);
+        EXPECT_EQ(cpu.A, static_cast<Byte>(0x21 + 2 * run));
+    }
+    EXPECT_EQ(jit.CompiledBlocks(), 1u);
+    EXPECT_EQ(jit.NativeBlockRuns(), 2u);
+    EXPECT_EQ(device.reads, 4u);
+}
+
+TEST_F(JitTest, StoreRaisingAnIrqLeavesTheBlockLikeTheInterpreter) {
+    auto load = [](Memory &memory) {
+        // CLI; LDA #$01; STA $D000 (raises IRQ); LDX #$05; STX $40; LDY #$07; STY $41; NOP
+        LoadProgram(memory, 0x8000,
+                    {0x58, 0xA9, 0x01, 0x8D, 0x00, 0xD0, 0xA2, 0x05, 0x86, 0x40, 0xA0, 0x07, 0x84, 0x41, 0xEA});
+        // The handler records $40 in $60, drops IRQ and returns: LDA $40; STA $60; LDA #$00; STA $D001; RTI
+        const Byte handler[] = {0xA5, 0x40, 0x85, 0x60, 0xA9, 0x00, 0x8D, 0x01, 0xD0, 0x40};
+        memory.WriteBlock(0xFF00, handler, sizeof(handler));
+        memory.WriteWord(0xFFFE, 0xFF00);
+    };
+    Memory reference_memory;
+    Memory jit_memory;
+    load(reference_memory);
+    load(jit_memory);
+    IrqSwitchDevice reference_device;
+    IrqSwitchDevice jit_device;
+    reference_memory.MapDevice(0xD0, 0xD0, &reference_device);
+    jit_memory.MapDevice(0xD0, 0xD0, &jit_device);
+    CPU reference(reference_memory);
+    CPU cpu(jit_memory);
+    reference_device.cpu = &reference;
+    jit_device.cpu = &cpu;
+    Jit jit(cpu, 1);
+
+    for (int run = 0; run < 2; ++run) {
+        reference_memory.WriteByte(0x0040, 0x00);
+        jit_memory.WriteByte(0x0040, 0x00);
+        reference.Reset();
+        cpu.Reset();
+        reference.Execute(45);
+        jit.Execute(45);
+
+        EXPECT_EQ(cpu.PC, reference.PC);
+        EXPECT_EQ(cpu.X, reference.X);
+        EXPECT_EQ(cpu.Y, reference.Y);
+        EXPECT_EQ(cpu.cycles, reference.cycles);
+        EXPECT_EQ(jit_memory.ReadByte(0x0060), 0x00);
+        EXPECT_EQ(jit_memory.ReadByte(0x0041), reference_memory.ReadByte(0x0041));
+    }
+    EXPECT_GE(jit.NativeBlockRuns(), 2u);
+}
+
+TEST_F(JitTest, BlockCacheOnTheSameMemoryIsRejectedAndTheJitStillSeesCodeWrites) {
+    Memory memory;
+    LoadProgram(memory, 0x8000, {0xA9, 0x01, 0xEA});
+    CPU cpu(memory);
+    cpu.Reset();
+    Jit jit(cpu, 1);
+    jit.Execute(2);
+    ASSERT_EQ(jit.CompiledBlocks(), 1u);
+
+    EXPECT_THROW(BlockCache{cpu}, std::logic_error);
+    memory.WriteByte(0x8001, 0x55);
+    cpu.PC = 0x8000;
+    jit.Execute(2);
+    EXPECT_EQ(cpu.A, 0x55);
+}
@@ -0,0 +1,98 @@
+#include <cpu6502/cpu.hpp>
+#include <cpu6502/loader.hpp>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+ImageInfo LoadHex(Memory &memory, const std::string &text, const LoadOptions &options = {}) {
+    return ImageLoader::Load(memory, reinterpret_cast<const Byte *>(text.data()), text.size(), ImageFormat::IntelHex,
+                             options);
+}
+} // namespace
+
+TEST(LoaderTest, RawImageLoadsAtBaseAndSetsResetVector) {
+    Memory memory;
+    std::vector<Byte> image(600);
+    for (std::size_t i = 0; i < image.size(); ++i)
+        image[i] = static_cast<Byte>(i * 3);
+
+    LoadOptions options;
+    options.base = 0xC010;
+    options.set_reset_vector = true;
+    const ImageInfo info = ImageLoader::Load(memory, image.data(), image.size(), ImageFormat::Raw, options);
+
+    EXPECT_EQ(info.first, 0xC010);
+    EXPECT_EQ(info.last, 0xC010 + 599);
+    EXPECT_EQ(info.bytes, 600u);
+    EXPECT_EQ(info.entry, 0xC010);
+    EXPECT_EQ(memory.ReadWord(0xFFFC), 0xC010);
+    for (std::size_t i = 0; i < image.size(); ++i)
+        ASSERT_EQ(memory.ReadByte(static_cast<Word>(0xC010 + i)), image[i]) << i;
+}
+
+TEST(LoaderTest, PrgImageUsesItsLoadAddressAndRuns) {
+    Memory memory;
+    // Load address $0801, then LDA #$42; STA $0200
+    const std::vector<Byte> prg{0x01, 0x08, 0xA9, 0x42, 0x8D, 0x00, 0x02};
+    LoadOptions options;
+    options.set_reset_vector = true;
+    const ImageInfo info = ImageLoader::Load(memory, prg.data(), prg.size(), ImageFormat::Prg, options);
+
+    EXPECT_EQ(info.first, 0x0801);
+    EXPECT_EQ(info.bytes, 5u);
+    CPU cpu(memory);
+    cpu.Reset();
+    cpu.Execute(6);
+    EXPECT_EQ(memory.ReadByte(0x0200), 0x42);
+
+    const Byte truncated[1]{0x01};
+    EXPECT_THROW(ImageLoader::Load(memory, truncated, 1, ImageFormat::Prg), std::runtime_error);
+}
+
+TEST(LoaderTest, IntelHexDataExtendedAddressAndStartRecords) {
+    Memory memory;
+    // The extended linear address record moves the data record to $A0030, past the end of the bus.
+    const std::string hex = ":0300300002337A1E\n:02000004000AF0\n:0300300002337A1E\n:00000001FF\n";
+    EXPECT_THROW(LoadHex(memory, hex), std::out_of_range);
+    EXPECT_EQ(memory.ReadByte(0x0030), 0x00);
+
+    const std::string valid = ":04100000A9428D0074\n"
+                              ":021004000200E8\n"
+                              ":0400000500001000E7\n"
+                              ":00000001FF\n";
+    LoadOptions options;
+    options.set_reset_vector = true;
+    const ImageInfo info = LoadHex(memory, valid, options);
+
+    EXPECT_EQ(info.first, 0x1000);
+    EXPECT_EQ(info.last, 0x1005);
+    EXPECT_EQ(info.bytes, 6u);
+    EXPECT_EQ(info.entry, 0x1000);
+    EXPECT_EQ(memory.ReadWord(0xFFFC), 0x1000);
+    EXPECT_EQ(memory.ReadByte(0x1001), 0x42);
+    EXPECT_EQ(memory.ReadWord(0x1003), 0x0200);
+}
+
+TEST(LoaderTest, IntelHexRejectsBadChecksumsAndMissingEof) {
+    Memory memory;
+    EXPECT_THROW(LoadHex(memory, ":0300300002337A1F\n:00000001FF\n"), std::runtime_error);
+    EXPECT_THROW(LoadHex(memory, ":0300300002337A1E\n"), std::runtime_error);
+    EXPECT_THROW(LoadHex(memory, "0300300002337A1E\n:00000001FF\n"), std::runtime_error);
+    EXPECT_EQ(memory.ReadByte(0x0030), 0x00);
+}
+
+TEST(LoaderTest, LoadFileGuessesFormatFromExtension) {
+    EXPECT_EQ(ImageLoader::FormatForPath("game.PRG"), ImageFormat::Prg);
+    EXPECT_EQ(ImageLoader::FormatForPath("rom.hex"), ImageFormat::IntelHex);
+    EXPECT_EQ(ImageLoader::FormatForPath("dir.v2/rom"), ImageFormat::Raw);
+
+    const std::string path = ::testing::TempDir() + "image.hex";
+    std::ofstream(path) << ":0300300002337A1E\r\n:00000001FF\r\n";
+    Memory memory;
+    ImageLoader::LoadFile(memory, path, ImageLoader::FormatForPath(path));
+    EXPECT_EQ(memory.ReadByte(0x0032), 0x7A);
+    EXPECT_THROW(ImageLoader::LoadFile(memory, path + ".missing", ImageFormat::Raw), std::runtime_error);
+}
@@ -0,0 +1,159 @@
+#include <cpu6502/lockstep.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "test_program.hpp"
+
+namespace {
+// Machine run alone through CPU::Execute, to compare a lane against.
+struct Machine {
+    std::unique_ptr<Memory> memory = std::make_unique<Memory>();
+    CPU cpu{*memory};
+};
+
+// LDX $10; LDY $11; LDA $20,X; STA $0300,Y; LDA $20FE,X; STA ($40),Y; LDA ($50,X); STA $0301; NOP
+void LoadKernelProgram(Memory &memory) {
+    LoadProgram(memory, 0x8000,
+                {0xA6, 0x10, 0xA4, 0x11, 0xB5, 0x20, 0x99, 0x00, 0x03, 0xBD, 0xFE, 0x20, 0x91, 0x40, 0xA1, 0x50, 0x8D,
+                 0x01, 0x03, 0xEA});
+}
+
+void SeedLane(Memory &memory, const unsigned lane) {
+    memory.WriteByte(0x0010, static_cast<Byte>(lane % 4));
+    memory.WriteByte(0x0011, static_cast<Byte>(lane % 3));
+    for (Word addr = 0x0020; addr < 0x0030; ++addr)
+        memory.WriteByte(addr, static_cast<Byte>(addr + lane * 7));
+    memory.WriteByte(0x0040, static_cast<Byte>(0x10 * lane));
+    memory.WriteByte(0x0041, 0x04);
+    for (Word addr = 0x0050; addr < 0x0058; ++addr)
+        memory.WriteByte(addr, lane % 2 ? 0x00 : 0x05);
+    for (Word addr = 0x20FE; addr < 0x2102; ++addr)
+        memory.WriteByte(addr, static_cast<Byte>(addr ^ lane));
+    memory.WriteByte(0x0500, 0x77);
+}
+
+void ExpectLaneMatches(const Lockstep &lockstep, const unsigned lane, const Machine &expected) {
+    Machine actual;
+    lockstep.Store(lane, actual.cpu, *actual.memory);
+    EXPECT_EQ(actual.cpu.PC, expected.cpu.PC) << "lane " << lane;
+    EXPECT_EQ(actual.cpu.SP, expected.cpu.SP) << "lane " << lane;
+    EXPECT_EQ(actual.cpu.A, expected.cpu.A) << "lane " << lane;
+    EXPECT_EQ(actual.cpu.X, expected.cpu.X) << "lane " << lane;
+    EXPECT_EQ(actual.cpu.Y, expected.cpu.Y) << "lane " << lane;
+    EXPECT_EQ(actual.cpu.cycles, expected.cpu.cycles) << "lane " << lane;
+    for (u32 addr = 0; addr < MAX_MEM; ++addr) {
+        if (actual.memory->ReadByte(static_cast<Word>(addr)) != expected.memory->ReadByte(static_cast<Word>(addr))) {
+            ADD_FAILURE() << "lane " << lane << " differs at $" << std::hex << addr;
+            return;
+        }
+    }
+}
+
+// Runs every lane for each budget in turn and checks it against the same machine run alone.
+void ExpectLockstepMatchesScalar(std::vector<Machine> &machines, const std::initializer_list<u32> budgets) {
+    Lockstep lockstep(static_cast<unsigned>(machines.size()));
+    for (unsigned lane = 0; lane < machines.size(); ++lane) {
+        machines[lane].cpu.Reset();
+        lockstep.Load(lane, machines[lane].cpu, *machines[lane].memory);
+    }
+    for (const u32 budget : budgets) {
+        lockstep.Execute(budget);
+        for (unsigned lane = 0; lane < machines.size(); ++lane) {
+            machines[lane].cpu.Execute(budget);
+            ExpectLaneMatches(lockstep, lane, machines[lane]);
+        }
+    }
+}
+} // namespace
+
+TEST(LockstepTest, LanesWithDifferentDataMatchScalarExecution) {
+    std::vector<Machine> machines(Lockstep::MAX_LANES);
+    for (unsigned lane = 0; lane < machines.size(); ++lane) {
+        LoadKernelProgram(*machines[lane].memory);
+        SeedLane(*machines[lane].memory, lane);
+    }
+    ExpectLockstepMatchesScalar(machines, {5, 1, 17, 9, 100});
+}
+
+TEST(LockstepTest, LanesWithDifferentCodeRunAsSeparateGroups) {
+    std::vector<Machine> machines(8);
+    for (unsigned lane = 0; lane < machines.size(); ++lane) {
+        LoadKernelProgram(*machines[lane].memory);
+        SeedLane(*machines[lane].memory, lane);
+        if (lane % 3 == 1)
+            machines[lane].memory->WriteByte(0x8004, 0xB4); // LDY $20,X instead of LDA $20,X
+    }
+    ExpectLockstepMatchesScalar(machines, {40});
+}
+
+TEST(LockstepTest, LanesStartingAtDifferentCyclesKeepTheirOwnBudget) {
+    std::vector<Machine> machines(5);
+    for (unsigned lane = 0; lane < machines.size(); ++lane) {
+        LoadKernelProgram(*machines[lane].memory);
+        SeedLane(*machines[lane].memory, lane);
+    }
+    Lockstep lockstep(static_cast<unsigned>(machines.size()));
+    for (unsigned lane = 0; lane < machines.size(); ++lane) {
+        machines[lane].cpu.Reset();
+        machines[lane].cpu.Execute(lane * 3);
+        lockstep.Load(lane, machines[lane].cpu, *machines[lane].memory);
+    }
+    lockstep.Execute(20);
+    for (unsigned lane = 0; lane < machines.size(); ++lane) {
+        machines[lane].cpu.Execute(20);
+        ExpectLaneMatches(lockstep, lane, machines[lane]);
+    }
+}
+
+TEST(LockstepTest, LanesRunAcrossTheCycleCounterWrap) {
+    std::vector<Machine> machines(4);
+    Lockstep lockstep(static_cast<unsigned>(machines.size()));
+    for (unsigned lane = 0; lane < machines.size(); ++lane) {
+        LoadKernelProgram(*machines[lane].memory);
+        SeedLane(*machines[lane].memory, lane);
+        machines[lane].cpu.Reset();
+        machines[lane].cpu.cycles = 0xFFFFFFF0 + lane * 5;
+        lockstep.Load(lane, machines[lane].cpu, *machines[lane].memory);
+    }
+    lockstep.Execute(30);
+    for (unsigned lane = 0; lane < machines.size(); ++lane) {
+        machines[lane].cpu.Execute(30);
+        ExpectLaneMatches(lockstep, lane, machines[lane]);
+    }
+}
+
+TEST(LockstepTest, SelfModifyingStoreSplitsOnlyTheModifiedLanes) {
+    std::vector<Machine> machines(4);
+    for (unsigned lane = 0; lane < machines.size(); ++lane) {
+        // LDA $10; STA $8005; LDA #$01; NOP
+        LoadProgram(*machines[lane].memory, 0x8000, {0xA5, 0x10, 0x8D, 0x05, 0x80, 0xA9, 0x01, 0xEA});
+        machines[lane].memory->WriteByte(0x0010, lane % 2 ? 0xA9 : 0xA0); // LDA #imm or LDY #imm
+    }
+    ExpectLockstepMatchesScalar(machines, {13});
+}
+
+TEST(LockstepTest, OpcodeWithoutKernelFallsBackToScalarCpu) {
+    std::vector<Machine> machines(6);
+    for (unsigned lane = 0; lane < machines.size(); ++lane) {
+        // LDA $10; BRK; LDX #$03
+        LoadProgram(*machines[lane].memory, 0x8000, {0xA5, 0x10, 0x00, 0xA2, 0x03});
+        machines[lane].memory->WriteByte(0x0010, static_cast<Byte>(lane));
+    }
+    ExpectLockstepMatchesScalar(machines, {20});
+
+    Lockstep lockstep(2);
+    for (unsigned lane = 0; lane < 2; ++lane) {
+        machines[lane].cpu.Reset();
+        lockstep.Load(lane, machines[lane].cpu, *machines[lane].memory);
+    }
+    lockstep.Execute(20);
+    EXPECT_EQ(lockstep.ScalarFallbacks(), 2u);
+}
+
+TEST(LockstepTest, RejectsInvalidLaneCounts) {
+    EXPECT_THROW(Lockstep(0), std::invalid_argument);
+    EXPECT_THROW(Lockstep(Lockstep::MAX_LANES + 1), std::invalid_argument);
+    Lockstep lockstep(2);
+    EXPECT_EQ(lockstep.Lanes(), 2u);
+    EXPECT_THROW((void)lockstep.ReadByte(2, 0x0000), std::out_of_range);
+}
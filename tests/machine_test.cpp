@@ -0,0 +1,42 @@
+#include <cpu6502/machine.hpp>
+#include <gtest/gtest.h>
+
+#include "test_program.hpp"
+
+TEST(MachineTest, ForkCopiesRegistersAndRunsIndependently) {
+    Machine machine;
+    // LDA $10; STA $0200; LDX #$07
+    LoadProgram(machine.memory, 0x8000, {0xA5, 0x10, 0x8D, 0x00, 0x02, 0xA2, 0x07});
+    machine.memory.WriteByte(0x0010, 0x42);
+    machine.cpu.Reset();
+    machine.cpu.Execute(3);
+
+    Machine fork = machine.Fork();
+    EXPECT_EQ(fork.cpu.PC, machine.cpu.PC);
+    EXPECT_EQ(fork.cpu.A, 0x42);
+    EXPECT_EQ(fork.cpu.cycles, machine.cpu.cycles);
+
+    fork.cpu.A = 0x99;
+    fork.cpu.Execute(6);
+    machine.cpu.Execute(6);
+
+    EXPECT_EQ(fork.memory.ReadByte(0x0200), 0x99);
+    EXPECT_EQ(machine.memory.ReadByte(0x0200), 0x42);
+    EXPECT_EQ(fork.cpu.X, 0x07);
+    EXPECT_EQ(fork.cpu.PC, machine.cpu.PC);
+}
+
+TEST(MachineTest, ForkOfForkSharesUntouchedPages) {
+    Machine machine;
+    machine.memory.WriteByte(0x1234, 0x56);
+
+    const Machine first = machine.Fork();
+    Machine second = first.Fork();
+    second.memory.WriteByte(0x1235, 0x01);
+
+    EXPECT_TRUE(first.memory.IsSharedPage(0x12));
+    EXPECT_TRUE(machine.memory.IsSharedPage(0x12));
+    EXPECT_FALSE(second.memory.IsSharedPage(0x12));
+    EXPECT_EQ(second.memory.ReadByte(0x1234), 0x56);
+    EXPECT_EQ(first.memory.ReadByte(0x1235), 0x00);
+}
@@ -1,5 +1,9 @@
 #include <cpu6502/mem.hpp>
+#include <cstddef>
 #include <gtest/gtest.h>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
 
 static constexpr Word SAMPLES[] = {0x0000, 0x0001, 0x00FF, 0x0100, 0x1234, 0x7FFF, 0xFFFE, 0xFFFF};
 
@@ -93,3 +97,270 @@ TEST(MemoryTest, WordAccessAtFFFFWrapsToZero) {
     EXPECT_EQ(mem.ReadByte(0x0000), static_cast<Byte>((value >> 8) & 0xFF));
     EXPECT_EQ(mem.ReadWord(addr), value);
 }
+
+namespace {
+class RecordingDevice final : public BusDevice {
+public:
+    std::vector<Word> reads;
+    std::vector<std::pair<Word, Byte>> writes;
+
+    Byte Read(const Word Address) override {
+        reads.push_back(Address);
+        return static_cast<Byte>(Address ^ 0x5A);
+    }
+    void Write(const Word Address, const Byte Value) override { writes.emplace_back(Address, Value); }
+};
+
+class PageListener final : public CodeWriteListener {
+public:
+    std::vector<Byte> pages;
+    void OnCodeWrite(const Byte page) override { pages.push_back(page); }
+};
+
+class AccessListener final : public WatchListener {
+public:
+    std::vector<std::tuple<Word, Byte, bool>> accesses;
+    void OnWatchedAccess(const Word Address, const Byte Value, const bool Write) override {
+        accesses.emplace_back(Address, Value, Write);
+    }
+};
+} // namespace
+
+TEST(MemoryTest, DevicePagesRouteReadsAndWrites) {
+    Memory mem;
+    RecordingDevice device;
+    mem.MapDevice(0xD0, 0xD1, &device);
+
+    EXPECT_TRUE(mem.IsDevicePage(0xD1));
+    EXPECT_FALSE(mem.IsDevicePage(0xD2));
+    EXPECT_EQ(mem.ReadByte(0xD012), 0x12 ^ 0x5A);
+    mem.WriteByte(0xD1FF, 0x77);
+    mem.WriteByte(0xD200, 0x66);
+
+    ASSERT_EQ(device.reads.size(), 1u);
+    EXPECT_EQ(device.reads[0], 0xD012);
+    ASSERT_EQ(device.writes.size(), 1u);
+    EXPECT_EQ(device.writes[0], std::make_pair(Word{0xD1FF}, Byte{0x77}));
+    EXPECT_EQ(mem.ReadByte(0xD200), 0x66);
+}
+
+TEST(MemoryTest, RomPagesIgnoreWrites) {
+    Memory mem;
+    Byte rom[PAGE_BYTES];
+    for (u32 i = 0; i < PAGE_BYTES; ++i)
+        rom[i] = static_cast<Byte>(i);
+    mem.MapRom(0xF0, rom);
+
+    mem.WriteByte(0xF010, 0xEE);
+
+    EXPECT_EQ(mem.ReadByte(0xF010), 0x10);
+    EXPECT_EQ(rom[0x10], 0x10);
+}
+
+TEST(MemoryTest, HostRamPageIsSharedWithHost) {
+    Memory mem;
+    Byte ram[PAGE_BYTES]{};
+    mem.MapRam(0x40, ram);
+
+    mem.WriteByte(0x4003, 0xAB);
+    ram[0x04] = 0xCD;
+
+    EXPECT_EQ(ram[0x03], 0xAB);
+    EXPECT_EQ(mem.ReadWord(0x4003), 0xCDAB);
+
+    mem.UnmapPage(0x40);
+    EXPECT_EQ(mem.ReadByte(0x4003), 0x00);
+}
+
+TEST(MemoryTest, CopyOwnsInternalRamAndSharesHostPages) {
+    Memory mem;
+    Byte ram[PAGE_BYTES]{};
+    mem.MapRam(0x40, ram);
+    mem.WriteByte(0x1000, 0x11);
+
+    Memory copy = mem;
+    copy.WriteByte(0x1000, 0x22);
+    copy.WriteByte(0x4000, 0x33);
+
+    EXPECT_EQ(mem.ReadByte(0x1000), 0x11);
+    EXPECT_EQ(copy.ReadByte(0x1000), 0x22);
+    EXPECT_EQ(mem.ReadByte(0x4000), 0x33);
+}
+
+TEST(MemoryTest, WritingOrRemappingMarkedCodePageNotifiesOnce) {
+    Memory mem;
+    PageListener listener;
+    RecordingDevice device;
+    mem.SetCodeWriteListener(&listener);
+
+    mem.MarkCodePage(0x80);
+    mem.WriteByte(0x8000, 0x01);
+    mem.WriteByte(0x8001, 0x02);
+    mem.MarkCodePage(0x90);
+    mem.MapDevice(0x90, 0x90, &device);
+
+    EXPECT_EQ(listener.pages, (std::vector<Byte>{0x80, 0x90}));
+    EXPECT_EQ(mem.ReadByte(0x8001), 0x02);
+}
+
+TEST(MemoryTest, SecondListenerIsRejectedAndOnlyTheOwnerRemovesItself) {
+    Memory mem;
+    PageListener first;
+    PageListener second;
+    AccessListener watcher;
+    AccessListener other_watcher;
+    mem.SetCodeWriteListener(&first);
+    mem.SetWatchListener(&watcher);
+
+    EXPECT_THROW(mem.SetCodeWriteListener(&second), std::logic_error);
+    EXPECT_THROW(mem.SetWatchListener(&other_watcher), std::logic_error);
+    mem.RemoveCodeWriteListener(&second);
+    mem.RemoveWatchListener(&other_watcher);
+    mem.MarkCodePage(0x80);
+    mem.WatchPage(0x20, true, false);
+    mem.WriteByte(0x8000, 0x01);
+    EXPECT_EQ(mem.ReadByte(0x2000), 0x00);
+    EXPECT_EQ(first.pages, (std::vector<Byte>{0x80}));
+    EXPECT_EQ(watcher.accesses.size(), 1u);
+
+    mem.RemoveCodeWriteListener(&first);
+    mem.RemoveWatchListener(&watcher);
+    mem.SetCodeWriteListener(&second);
+    mem.SetWatchListener(&other_watcher);
+}
+
+TEST(MemoryTest, WatchedPagesReportAccessesAfterThem) {
+    Memory mem;
+    AccessListener listener;
+    RecordingDevice device;
+    mem.SetWatchListener(&listener);
+    mem.MapDevice(0xD0, 0xD0, &device);
+    mem.WatchPage(0x20, true, false);
+    mem.WatchPage(0xD0, false, true);
+
+    mem.WriteByte(0x2001, 0x44);
+    EXPECT_EQ(mem.ReadByte(0x2001), 0x44);
+    mem.WriteByte(0xD005, 0x55);
+    EXPECT_EQ(mem.ReadByte(0xD005), 0x05 ^ 0x5A);
+    mem.WatchPage(0x20, false, false);
+    EXPECT_EQ(mem.ReadByte(0x2001), 0x44);
+
+    using Access = std::tuple<Word, Byte, bool>;
+    EXPECT_EQ(listener.accesses, (std::vector<Access>{{0x2001, 0x44, false}, {0xD005, 0x55, true}}));
+    ASSERT_EQ(device.writes.size(), 1u);
+}
+
+TEST(MemoryTest, PeekSkipsDevicesAndWatches) {
+    Memory mem;
+    AccessListener listener;
+    RecordingDevice device;
+    mem.SetWatchListener(&listener);
+    mem.MapDevice(0xD0, 0xD0, &device);
+    mem.WriteWord(0x20FF, 0x1234);
+    mem.WatchPage(0x20, true, true);
+    mem.WatchPage(0x21, true, true);
+
+    EXPECT_EQ(mem.PeekByte(0x20FF), 0x34);
+    EXPECT_EQ(mem.PeekWord(0x20FF), 0x1234);
+    EXPECT_EQ(mem.PeekByte(0xD005), 0x00);
+    EXPECT_TRUE(listener.accesses.empty());
+    EXPECT_TRUE(device.reads.empty());
+}
+
+TEST(MemoryTest, ForkSharesPagesUntilWritten) {
+    Memory mem;
+    mem.WriteByte(0x1000, 0x11);
+    mem.WriteByte(0x2000, 0x22);
+    EXPECT_FALSE(mem.IsSharedPage(0x10));
+
+    Memory fork = mem.Fork();
+    EXPECT_TRUE(mem.IsSharedPage(0x10));
+    EXPECT_TRUE(fork.IsSharedPage(0x20));
+
+    fork.WriteByte(0x1001, 0x33);
+    EXPECT_FALSE(fork.IsSharedPage(0x10));
+    EXPECT_FALSE(mem.IsSharedPage(0x10));
+    EXPECT_TRUE(fork.IsSharedPage(0x20));
+    EXPECT_EQ(fork.ReadByte(0x1000), 0x11);
+    EXPECT_EQ(fork.ReadByte(0x1001), 0x33);
+    EXPECT_EQ(mem.ReadByte(0x1001), 0x00);
+}
+
+TEST(MemoryTest, WritesToForkSourceStayOutOfFork) {
+    Memory mem;
+    mem.WriteWord(0x3000, 0x1234);
+    Memory fork = mem;
+
+    mem.WriteWord(0x3000, 0xABCD);
+
+    EXPECT_EQ(mem.ReadWord(0x3000), 0xABCD);
+    EXPECT_EQ(fork.ReadWord(0x3000), 0x1234);
+}
+
+TEST(MemoryTest, DiscardedForkLeavesSourcePagesPrivate) {
+    Memory mem;
+    mem.WriteByte(0x4000, 0x01);
+    {
+        const Memory fork = mem;
+        EXPECT_TRUE(mem.IsSharedPage(0x40));
+    }
+    EXPECT_FALSE(mem.IsSharedPage(0x40));
+    mem.WriteByte(0x4000, 0x02);
+    EXPECT_EQ(mem.ReadByte(0x4000), 0x02);
+}
+
+TEST(MemoryTest, AssignmentForksAndReleasesPreviousPages) {
+    Memory first;
+    Memory second;
+    first.WriteByte(0x5000, 0x55);
+    second.WriteByte(0x6000, 0x66);
+
+    second = first;
+    first.WriteByte(0x5000, 0x77);
+
+    EXPECT_EQ(second.ReadByte(0x5000), 0x55);
+    EXPECT_EQ(second.ReadByte(0x6000), 0x00);
+    EXPECT_EQ(first.ReadByte(0x5000), 0x77);
+}
+
+TEST(MemoryTest, WriteBlockSpansPagesRomAndDevices) {
+    Memory mem;
+    RecordingDevice device;
+    const Byte rom[PAGE_BYTES]{};
+    mem.MapRom(0x21, rom);
+    mem.MapDevice(0x22, 0x22, &device);
+    std::vector<Byte> block(3 * PAGE_BYTES);
+    for (std::size_t i = 0; i < block.size(); ++i)
+        block[i] = static_cast<Byte>(i + 1);
+
+    mem.WriteBlock(0x2080, block.data(), block.size());
+
+    EXPECT_EQ(mem.ReadByte(0x2080), 0x01);
+    EXPECT_EQ(mem.ReadByte(0x20FF), 0x80);
+    EXPECT_EQ(mem.ReadByte(0x2100), 0x00);
+    ASSERT_EQ(device.writes.size(), PAGE_BYTES);
+    EXPECT_EQ(device.writes.front(), std::make_pair(Word{0x2200}, Byte{0x81}));
+    EXPECT_EQ(mem.ReadByte(0x2300), 0x81);
+    EXPECT_EQ(mem.ReadByte(0x237F), 0x00);
+    EXPECT_THROW(mem.WriteBlock(0xFFFF, block.data(), 2), std::out_of_range);
+}
+
+TEST(MemoryTest, WriteBlockCopiesSharedPagesAndNotifiesCodePages) {
+    Memory mem;
+    PageListener listener;
+    mem.SetCodeWriteListener(&listener);
+    mem.WriteByte(0x3010, 0x11);
+    mem.WriteByte(0x3110, 0x22);
+    const Memory fork = mem;
+    mem.MarkCodePage(0x31);
+
+    std::vector<Byte> block(PAGE_BYTES + 1, 0xEE);
+    mem.WriteBlock(0x3000, block.data(), block.size());
+
+    EXPECT_EQ(mem.ReadByte(0x30FF), 0xEE);
+    EXPECT_EQ(mem.ReadByte(0x3100), 0xEE);
+    EXPECT_EQ(mem.ReadByte(0x3110), 0x22);
+    EXPECT_EQ(fork.ReadByte(0x3010), 0x11);
+    EXPECT_EQ(fork.ReadByte(0x3100), 0x00);
+    EXPECT_EQ(listener.pages, (std::vector<Byte>{0x31}));
+}
@@ -0,0 +1,113 @@
+#include <cpu6502/cpu.hpp>
+#include <cpu6502/opcodes.hpp>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+// Runs one instruction at $8000 with X and Y set to index, the operand bytes $F8 $30 and the pointer at $F8
+// holding $30F8. Returns the cycles it took and stores the PC it left behind in pc.
+u32 RunOne(const Byte opcode, const Byte index, Word &pc) {
+    Memory memory;
+    memory.WriteWord(0xFFFC, 0x8000);
+    memory.WriteWord(0x00F8, 0x30F8);
+    const Byte program[] = {opcode, 0xF8, 0x30};
+    memory.WriteBlock(0x8000, program, sizeof(program));
+    CPU cpu(memory);
+    cpu.Reset();
+    cpu.X = index;
+    cpu.Y = index;
+    const u32 start = cpu.cycles;
+    cpu.Execute(1);
+    pc = cpu.PC;
+    return cpu.cycles - start;
+}
+} // namespace
+
+TEST(OpcodesTest, TableCoversTheDocumentedInstructionSet) {
+    u32 documented = 0;
+    for (const OpcodeInfo &info : OPCODES) {
+        if (info.mnemonic != Mnemonic::Illegal)
+            ++documented;
+    }
+    EXPECT_EQ(documented, 151u);
+    EXPECT_EQ(OPCODES[0x02].mnemonic, Mnemonic::Illegal);
+    EXPECT_EQ(OPCODES[0xFF].length, 1);
+}
+
+TEST(OpcodesTest, DescribesLengthsCyclesPenaltiesAndFlags) {
+    static_assert(OPCODES[0xA9].mnemonic == Mnemonic::LDA && OPCODES[0xA9].length == 2);
+    EXPECT_EQ(OPCODES[0xBD].mode, AddressingMode::AbsoluteX);
+    EXPECT_EQ(OPCODES[0xBD].length, 3);
+    EXPECT_EQ(OPCODES[0xBD].cycles, 4);
+    EXPECT_EQ(OPCODES[0xBD].penalty, PageCrossPenalty::IndexedRead);
+    EXPECT_EQ(OPCODES[0x9D].cycles, 5);
+    EXPECT_EQ(OPCODES[0x9D].penalty, PageCrossPenalty::None);
+    EXPECT_EQ(OPCODES[0xFE].cycles, 7);
+    EXPECT_EQ(OPCODES[0xD0].penalty, PageCrossPenalty::Branch);
+    EXPECT_EQ(OPCODES[0x6C].mode, AddressingMode::Indirect);
+    EXPECT_EQ(OPCODES[0x69].flags, FLAG_N | FLAG_V | FLAG_Z | FLAG_C);
+    EXPECT_EQ(OPCODES[0x85].flags, 0);
+    EXPECT_EQ(OPCODES[0x0A].mode, AddressingMode::Accumulator);
+}
+
+TEST(OpcodesTest, InterpreterMatchesTableCyclesAndLengths) {
+    u32 checked = 0;
+    for (u32 code = 0; code < 256; ++code) {
+        const auto opcode = static_cast<Byte>(code);
+        if (!IsImplemented(opcode))
+            continue;
+        const OpcodeInfo &info = OPCODES[opcode];
+        Word pc = 0;
+        EXPECT_EQ(RunOne(opcode, 0x00, pc), info.cycles) << MnemonicName(info.mnemonic);
+        // BRK and RTI load PC from the vector and the stack.
+        if (info.mnemonic != Mnemonic::BRK && info.mnemonic != Mnemonic::RTI) {
+            EXPECT_EQ(pc, 0x8000 + info.length) << MnemonicName(info.mnemonic);
+        }
+        ++checked;
+    }
+    EXPECT_GT(checked, 0u);
+}
+
+TEST(OpcodesTest, InterpreterChargesPageCrossPenaltiesFromTable) {
+    for (u32 code = 0; code < 256; ++code) {
+        const auto opcode = static_cast<Byte>(code);
+        if (!IsImplemented(opcode))
+            continue;
+        const OpcodeInfo &info = OPCODES[opcode];
+        const bool indexed = info.mode == AddressingMode::AbsoluteX || info.mode == AddressingMode::AbsoluteY ||
+                             info.mode == AddressingMode::IndirectIndexedY;
+        if (!indexed)
+            continue;
+        const u32 extra = info.penalty == PageCrossPenalty::IndexedRead ? 1 : 0;
+        Word pc = 0;
+        EXPECT_EQ(RunOne(opcode, 0x10, pc), info.cycles + extra) << MnemonicName(info.mnemonic);
+    }
+}
+
+TEST(OpcodesTest, DisassemblesEveryAddressingMode) {
+    EXPECT_EQ(Disassemble(0x8000, 0xEA, 0x0000), "NOP");
+    EXPECT_EQ(Disassemble(0x8000, 0x0A, 0x0000), "ASL A");
+    EXPECT_EQ(Disassemble(0x8000, 0xA9, 0x0005), "LDA #$05");
+    EXPECT_EQ(Disassemble(0x8000, 0xA5, 0x0010), "LDA $10");
+    EXPECT_EQ(Disassemble(0x8000, 0xB5, 0x0010), "LDA $10,X");
+    EXPECT_EQ(Disassemble(0x8000, 0xB6, 0x0010), "LDX $10,Y");
+    EXPECT_EQ(Disassemble(0x8000, 0x8D, 0x1234), "STA $1234");
+    EXPECT_EQ(Disassemble(0x8000, 0xBD, 0x1234), "LDA $1234,X");
+    EXPECT_EQ(Disassemble(0x8000, 0x99, 0x1234), "STA $1234,Y");
+    EXPECT_EQ(Disassemble(0x8000, 0x6C, 0xFFFC), "JMP ($FFFC)");
+    EXPECT_EQ(Disassemble(0x8000, 0xA1, 0x0020), "LDA ($20,X)");
+    EXPECT_EQ(Disassemble(0x8000, 0xB1, 0x0020), "LDA ($20),Y");
+    EXPECT_EQ(Disassemble(0x8000, 0xD0, 0x00FC), "BNE $7FFE");
+    EXPECT_EQ(Disassemble(0x8000, 0x02, 0x0000), ".byte $02");
+}
+
+TEST(OpcodesTest, DisassemblesFromMemory) {
+    Memory memory;
+    const Byte program[] = {0xAD, 0x00, 0x02, 0xA9, 0x7F};
+    memory.WriteBlock(0x8000, program, sizeof(program));
+    std::string text;
+    EXPECT_EQ(Disassemble(memory, 0x8000, text), 3);
+    EXPECT_EQ(text, "LDA $0200");
+    EXPECT_EQ(Disassemble(memory, 0x8003, text), 2);
+    EXPECT_EQ(text, "LDA #$7F");
+}
@@ -0,0 +1,128 @@
+#include <cpu6502/profiler.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+namespace {
+// LDA #$80; LDX $10; STA $0200; NOP at $8000
+void LoadProfileProgram(Memory &memory) {
+    memory.WriteWord(0xFFFC, 0x8000);
+    memory.WriteByte(0x0010, 0x34);
+    const Byte program[] = {0xA9, 0x80, 0xA6, 0x10, 0x8D, 0x00, 0x02, 0xEA};
+    memory.WriteBlock(0x8000, program, sizeof(program));
+}
+} // namespace
+
+TEST(ProfilerTest, CountsExecutionsAndCyclesPerAddressAndOpcode) {
+    Memory memory;
+    LoadProfileProgram(memory);
+    ProfilingCPU cpu(memory);
+    Profiler profiler;
+    cpu.SetProfiler(&profiler);
+    cpu.Reset();
+    cpu.Execute(11);
+
+    EXPECT_EQ(cpu.cycles, 17u);
+    EXPECT_EQ(profiler.TotalExecutions(), 4u);
+    EXPECT_EQ(profiler.TotalCycles(), 11u);
+    EXPECT_EQ(profiler.Executions(0x8000), 1u);
+    EXPECT_EQ(profiler.Cycles(0x8000), 2u);
+    EXPECT_EQ(profiler.Cycles(0x8002), 3u);
+    EXPECT_EQ(profiler.Cycles(0x8004), 4u);
+    EXPECT_EQ(profiler.Cycles(0x8007), 2u);
+    EXPECT_EQ(profiler.Executions(0x8001), 0u);
+    EXPECT_EQ(profiler.OpcodeExecutions(0x8D), 1u);
+    EXPECT_EQ(profiler.OpcodeCycles(0xA6), 3u);
+
+    profiler.Clear();
+    EXPECT_EQ(profiler.TotalCycles(), 0u);
+    EXPECT_EQ(profiler.Executions(0x8000), 0u);
+}
+
+TEST(ProfilerTest, CountsPageCrossingPenalties) {
+    Memory memory;
+    memory.WriteWord(0xFFFC, 0x8000);
+    memory.WriteWord(0x0020, 0x00F8);
+    // LDX #$01; LDA $80FF,X; LDA $8000,X; LDY #$10; LDA ($20),Y
+    const Byte program[] = {0xA2, 0x01, 0xBD, 0xFF, 0x80, 0xBD, 0x00, 0x80, 0xA0, 0x10, 0xB1, 0x20};
+    memory.WriteBlock(0x8000, program, sizeof(program));
+    ProfilingCPU cpu(memory);
+    Profiler profiler;
+    cpu.SetProfiler(&profiler);
+    cpu.Reset();
+    cpu.Execute(19);
+
+    EXPECT_EQ(profiler.TotalExecutions(), 5u);
+    EXPECT_EQ(profiler.PageCrosses(0x8002), 1u);
+    EXPECT_EQ(profiler.Cycles(0x8002), 5u);
+    EXPECT_EQ(profiler.PageCrosses(0x8005), 0u);
+    EXPECT_EQ(profiler.Cycles(0x8005), 4u);
+    EXPECT_EQ(profiler.PageCrosses(0x800A), 1u);
+    EXPECT_EQ(profiler.Cycles(0x800A), 6u);
+    EXPECT_EQ(profiler.OpcodePageCrosses(0xBD), 1u);
+    EXPECT_EQ(profiler.OpcodePageCrosses(0xB1), 1u);
+}
+
+TEST(ProfilerTest, ChargesCyclesToCallFramesInFoldedOutput) {
+    Memory memory;
+    LoadProfileProgram(memory);
+    ProfilingCPU cpu(memory);
+    Profiler profiler;
+    cpu.SetProfiler(&profiler);
+    cpu.Reset();
+    cpu.Execute(2);
+    profiler.Call(0x9000);
+    cpu.Execute(3);
+    profiler.Call(0x9100);
+    cpu.Execute(4);
+    profiler.Return();
+    profiler.Return();
+    profiler.Return();
+    cpu.Execute(2);
+
+    std::ostringstream folded;
+    profiler.WriteFolded(folded);
+    EXPECT_EQ(folded.str(), "root 4\nroot;$9000 3\nroot;$9000;$9100 4\n");
+}
+
+TEST(ProfilerTest, ReportListsHottestAddressesFirst) {
+    Memory memory;
+    LoadProfileProgram(memory);
+    ProfilingCPU cpu(memory);
+    Profiler profiler;
+    cpu.SetProfiler(&profiler);
+    cpu.Reset();
+    cpu.Execute(11);
+
+    std::ostringstream report;
+    profiler.Report(report, 2);
+    std::istringstream lines(report.str());
+    std::string line;
+    std::getline(lines, line);
+    EXPECT_EQ(line, "instructions 4, cycles 11");
+    std::getline(lines, line);
+    std::getline(lines, line);
+    EXPECT_EQ(line.substr(0, 8), "8004  8D");
+    std::getline(lines, line);
+    EXPECT_EQ(line.substr(0, 8), "8002  A6");
+    std::getline(lines, line);
+    EXPECT_EQ(line.find("PC"), std::string::npos);
+    EXPECT_NE(line.find("OP"), std::string::npos);
+}
+
+TEST(ProfilerTest, ProfilingCPUWithoutProfilerMatchesCPU) {
+    Memory memory;
+    LoadProfileProgram(memory);
+    CPU reference(memory);
+    ProfilingCPU cpu(memory);
+    reference.Reset();
+    cpu.Reset();
+    reference.Execute(11);
+    cpu.Execute(11);
+
+    EXPECT_EQ(cpu.PC, reference.PC);
+    EXPECT_EQ(cpu.A, reference.A);
+    EXPECT_EQ(cpu.X, reference.X);
+    EXPECT_EQ(cpu.cycles, reference.cycles);
+    EXPECT_EQ(cpu.StatusRegister(), reference.StatusRegister());
+}
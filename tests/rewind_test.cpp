@@ -0,0 +1,161 @@
+#include <cpu6502/debugger.hpp>
+#include <cpu6502/rewind.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+constexpr u32 STORES = 40;
+
+// LDA #i; STA $0i00 + 2 + i % 8 pages, for i below STORES, from $8000: six cycles per pair, one page per store.
+Word StoreAddress(const u32 i) { return static_cast<Word>(((0x02 + i % 8) << 8) | i); }
+
+void LoadProgram(Memory &memory) {
+    memory.WriteWord(0xFFFC, 0x8000);
+    for (u32 i = 0; i < STORES; ++i) {
+        const Word address = StoreAddress(i);
+        const Byte pair[] = {0xA9, static_cast<Byte>(i + 1), 0x8D, static_cast<Byte>(address),
+                             static_cast<Byte>(address >> 8)};
+        memory.WriteBlock(static_cast<Word>(0x8000 + i * sizeof(pair)), pair, sizeof(pair));
+    }
+}
+
+struct Boundary {
+    Word pc;
+    Byte a;
+    u32 cycles;
+    Memory memory;
+};
+
+// Every instruction boundary of a plain run up to cycles.
+std::vector<Boundary> Reference(const u32 cycles) {
+    Memory memory;
+    LoadProgram(memory);
+    CPU cpu(memory);
+    cpu.Reset();
+    std::vector<Boundary> boundaries;
+    while (cpu.cycles <= cycles) {
+        boundaries.push_back({cpu.PC, cpu.A, cpu.cycles, memory});
+        cpu.Execute(1);
+    }
+    return boundaries;
+}
+
+void ExpectState(const CPU &cpu, const Memory &memory, const Boundary &expected) {
+    EXPECT_EQ(cpu.PC, expected.pc);
+    EXPECT_EQ(cpu.A, expected.a);
+    EXPECT_EQ(cpu.cycles, expected.cycles);
+    for (u32 i = 0; i < STORES; ++i)
+        EXPECT_EQ(memory.ReadByte(StoreAddress(i)), expected.memory.ReadByte(StoreAddress(i))) << i;
+}
+
+// Index of the boundary at a cycle count.
+std::size_t At(const std::vector<Boundary> &boundaries, const u32 cycles) {
+    std::size_t index = 0;
+    while (boundaries[index].cycles != cycles)
+        ++index;
+    return index;
+}
+} // namespace
+
+TEST(RewindTest, StepBackReturnsToEarlierInstructionBoundaries) {
+    Memory memory;
+    LoadProgram(memory);
+    CPU cpu(memory);
+    cpu.Reset();
+    Rewind rewind(cpu, 32);
+    rewind.Execute(200);
+    const std::vector<Boundary> boundaries = Reference(cpu.cycles);
+    const std::size_t end = At(boundaries, cpu.cycles);
+    EXPECT_GT(rewind.Checkpoints(), 5u);
+
+    ASSERT_TRUE(rewind.StepBack());
+    ExpectState(cpu, memory, boundaries[end - 1]);
+    // Across several checkpoints, undoing the stores after them.
+    ASSERT_TRUE(rewind.StepBack(20));
+    ExpectState(cpu, memory, boundaries[end - 21]);
+    ASSERT_TRUE(rewind.StepBack(static_cast<u32>(end - 21)));
+    ExpectState(cpu, memory, boundaries[0]);
+    EXPECT_FALSE(rewind.StepBack());
+    ExpectState(cpu, memory, boundaries[0]);
+}
+
+TEST(RewindTest, SeekCycleMovesBothWaysWithinTheHistory) {
+    Memory memory;
+    LoadProgram(memory);
+    CPU cpu(memory);
+    cpu.Reset();
+    Rewind rewind(cpu, 32);
+    rewind.Execute(200);
+    const u32 end = cpu.cycles;
+    const std::vector<Boundary> boundaries = Reference(end);
+
+    // Reset leaves the count at 6, so cycle 57 is inside the ninth pair's store and the seek lands after it.
+    ASSERT_TRUE(rewind.SeekCycle(57));
+    ExpectState(cpu, memory, boundaries[At(boundaries, 60)]);
+    ASSERT_TRUE(rewind.SeekCycle(end));
+    ExpectState(cpu, memory, boundaries[At(boundaries, end)]);
+    EXPECT_FALSE(rewind.SeekCycle(end + 1));
+
+    // Running from the past replaces the history after it.
+    ASSERT_TRUE(rewind.SeekCycle(54));
+    rewind.Execute(6);
+    ExpectState(cpu, memory, boundaries[At(boundaries, 60)]);
+    EXPECT_FALSE(rewind.SeekCycle(end));
+    EXPECT_TRUE(rewind.SeekCycle(6));
+    EXPECT_FALSE(rewind.SeekCycle(5));
+}
+
+TEST(RewindTest, JournalLimitDropsTheOldestCheckpoints) {
+    Memory memory;
+    LoadProgram(memory);
+    CPU cpu(memory);
+    cpu.Reset();
+    // Two stores, so two page copies, per interval.
+    Rewind rewind(cpu, 12, 4 * PAGE_BYTES);
+    rewind.Execute(200);
+
+    EXPECT_LE(rewind.JournalBytes(), 6 * PAGE_BYTES);
+    EXPECT_LT(rewind.Checkpoints(), 5u);
+    EXPECT_GT(rewind.OldestCycle(), 150u);
+    EXPECT_FALSE(rewind.SeekCycle(6));
+    const u32 end = cpu.cycles;
+    EXPECT_FALSE(rewind.StepBack(20));
+    EXPECT_EQ(cpu.cycles, end);
+    EXPECT_TRUE(rewind.StepBack(2));
+    EXPECT_EQ(cpu.cycles, end - 6);
+}
+
+TEST(RewindTest, ReplayDoesNotStopAtBreakpoints) {
+    Memory memory;
+    LoadProgram(memory);
+    CPU cpu(memory);
+    Debugger debugger(memory);
+    cpu.SetDebugger(&debugger);
+    debugger.AddBreakpoint(0x8014);
+    debugger.AddWatchpoint(0x0200, 0x09FF, false, true);
+    cpu.Reset();
+    Rewind rewind(cpu, 16);
+
+    // Every pair stops at its store's watchpoint; the breakpoint stops the fifth pair before it runs.
+    for (int i = 0; i < 5; ++i)
+        rewind.Execute(100);
+    EXPECT_EQ(cpu.PC, 0x8014);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::Breakpoint);
+    ASSERT_TRUE(rewind.StepBack(7));
+    EXPECT_EQ(cpu.PC, 0x8002);
+    ASSERT_TRUE(rewind.SeekCycle(30));
+    EXPECT_EQ(cpu.PC, 0x8014);
+    EXPECT_EQ(cpu.cycles, 30u);
+
+    // Still attached: the next run stops at the watchpoint after the breakpoint's store.
+    rewind.Execute(100);
+    EXPECT_EQ(cpu.PC, 0x8019);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::Watchpoint);
+}
+
+TEST(RewindTest, RejectsAZeroInterval) {
+    Memory memory;
+    CPU cpu(memory);
+    EXPECT_THROW(Rewind(cpu, 0), std::invalid_argument);
+}
@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+"""Generates load_store_test.hex, a self-checking functional test ROM for the instructions the core implements.
+
+The ROM follows the trap convention of Klaus Dormann's 6502 functional tests: it ends in a one-instruction loop at
+$8000 when every check passed, and in one at $F000 when a check failed. With no branches or jumps in the instruction
+set, BRK is the only jump: its vector low byte stays $00 and every check stores the high byte looked up from a table,
+either $90 (an RTI back to the byte after the BRK) or $F0. BRK at $8000 or $F000 vectors to itself, so those are the
+traps. The body repeats 256 * 128 times, counted with successor tables, so a run also measures throughput.
+
+Run it from this directory to regenerate the image: python3 make_load_store_test.py > load_store_test.hex
+"""
+
+import sys
+
+OPS = {
+    "lda#": 0xA9, "lda_zp": 0xA5, "lda_zpx": 0xB5, "lda_abs": 0xAD, "lda_absx": 0xBD, "lda_absy": 0xB9,
+    "lda_indx": 0xA1, "lda_indy": 0xB1, "ldx#": 0xA2, "ldx_zp": 0xA6, "ldx_zpy": 0xB6, "ldx_abs": 0xAE,
+    "ldx_absy": 0xBE, "ldy#": 0xA0, "ldy_zp": 0xA4, "ldy_zpx": 0xB4, "ldy_abs": 0xAC, "ldy_absx": 0xBC,
+    "sta_zp": 0x85, "sta_zpx": 0x95, "sta_abs": 0x8D, "sta_absx": 0x9D, "sta_absy": 0x99, "sta_indx": 0x81,
+    "sta_indy": 0x91, "stx_zp": 0x86, "stx_zpy": 0x96, "stx_abs": 0x8E, "sty_zp": 0x84, "sty_zpx": 0x94,
+    "sty_abs": 0x8C, "brk": 0x00, "rti": 0x40, "nop": 0xEA, "cli": 0x58, "sei": 0x78,
+}
+
+SCRATCH, INNER, OUTER = 0x02, 0x04, 0x05
+PASS_STUB, FAIL_TRAP, SUCCESS_TRAP = 0x9000, 0xF000, 0x8000
+CHECK_TABLE, NEXT, INNER_JUMP, OUTER_JUMP = 0xA000, 0xA200, 0xA300, 0xA400
+OUTER_CODE, BODY = 0x8200, 0x8300
+
+memory = {}
+
+
+def put(address, *values):
+    for value in values:
+        memory[address] = value & 0xFF
+        address += 1
+    return address
+
+
+def data(address):
+    return (address * 7 + 3) & 0xFF
+
+
+class Code:
+    def __init__(self, address):
+        self.pc = address
+
+    def op(self, name, operand=None):
+        opcode = OPS[name]
+        if operand is None:
+            self.pc = put(self.pc, opcode)
+        elif name.endswith(("abs", "absx", "absy")):
+            self.pc = put(self.pc, opcode, operand, operand >> 8)
+        else:
+            self.pc = put(self.pc, opcode, operand)
+
+    def jump(self, table, index):
+        """BRK to the page table[memory[index]] holds."""
+        self.op("ldx_zp", index)
+        self.op("lda_absx", table)
+        self.op("sta_abs", 0xFFFF)
+        self.op("brk")
+        self.op("nop")
+
+    def check(self, expected):
+        """Fails unless the scratch byte holds expected."""
+        self.jump(CHECK_TABLE - expected, SCRATCH)
+
+    def count(self, counter):
+        self.op("ldx_zp", counter)
+        self.op("lda_absx", NEXT)
+        self.op("sta_zp", counter)
+
+
+def build():
+    put(0xFFFA, FAIL_TRAP & 0xFF, FAIL_TRAP >> 8, BODY & 0xFF, BODY >> 8, 0x00, FAIL_TRAP >> 8)
+    put(SUCCESS_TRAP, OPS["brk"])
+    put(FAIL_TRAP, OPS["brk"])
+    put(PASS_STUB, OPS["rti"])
+    for offset in range(-255, 256):
+        put(CHECK_TABLE + offset, (PASS_STUB if offset == 0 else FAIL_TRAP) >> 8)
+    for value in range(256):
+        put(NEXT + value, value + 1)
+        put(INNER_JUMP + value, (BODY if value else OUTER_CODE) >> 8)
+        put(OUTER_JUMP + value, (BODY if value else SUCCESS_TRAP) >> 8)
+    for address in range(0x3000, 0x3200):
+        put(address, data(address))
+    put(0x0010, 0x5A)
+    put(0x0020, 0x00, 0x30)
+    put(0x0022, 0xF8, 0x30)
+    put(0x0030, 0x00, 0x04)
+    put(0x00FF, 0x40)
+    put(0x0000, 0x31)
+    put(INNER, 0x00)
+    put(OUTER, 0x80)
+
+    outer = Code(OUTER_CODE)
+    outer.count(OUTER)
+    outer.jump(OUTER_JUMP, OUTER)
+
+    c = Code(BODY)
+    c.op("sei")
+    c.op("cli")
+
+    def check_a(expected):
+        c.op("sta_zp", SCRATCH)
+        c.check(expected)
+
+    # Immediate loads
+    c.op("lda#", 0xA5)
+    check_a(0xA5)
+    c.op("ldx#", 0x10)
+    c.op("stx_zp", SCRATCH)
+    c.check(0x10)
+    c.op("ldy#", 0x20)
+    c.op("sty_zp", SCRATCH)
+    c.check(0x20)
+
+    # Zero page, with indexed addresses wrapping inside page zero
+    c.op("lda_zp", 0x10)
+    check_a(0x5A)
+    c.op("ldx#", 0x20)
+    c.op("lda_zpx", 0xF0)
+    check_a(0x5A)
+    c.op("ldy#", 0x20)
+    c.op("ldx_zpy", 0xF0)
+    c.op("stx_zp", SCRATCH)
+    c.check(0x5A)
+    c.op("ldx#", 0x20)
+    c.op("ldy_zpx", 0xF0)
+    c.op("sty_zp", SCRATCH)
+    c.check(0x5A)
+    c.op("ldx_zp", 0x10)
+    c.op("stx_zp", SCRATCH)
+    c.check(0x5A)
+    c.op("ldy_zp", 0x10)
+    c.op("sty_zp", SCRATCH)
+    c.check(0x5A)
+
+    # Absolute and absolute indexed, within a page and across one
+    c.op("lda_abs", 0x3005)
+    check_a(data(0x3005))
+    c.op("ldx#", 0x04)
+    c.op("lda_absx", 0x3010)
+    check_a(data(0x3014))
+    c.op("ldx#", 0x10)
+    c.op("lda_absx", 0x30F8)
+    check_a(data(0x3108))
+    c.op("ldy#", 0x10)
+    c.op("lda_absy", 0x30F8)
+    check_a(data(0x3108))
+    c.op("ldy#", 0x05)
+    c.op("ldx_absy", 0x30FE)
+    c.op("stx_zp", SCRATCH)
+    c.check(data(0x3103))
+    c.op("ldx#", 0x09)
+    c.op("ldy_absx", 0x30FA)
+    c.op("sty_zp", SCRATCH)
+    c.check(data(0x3103))
+    c.op("ldx_abs", 0x3033)
+    c.op("stx_zp", SCRATCH)
+    c.check(data(0x3033))
+    c.op("ldy_abs", 0x3044)
+    c.op("sty_zp", SCRATCH)
+    c.check(data(0x3044))
+
+    # Indirect: the ($F0,X) pointer at $FF wraps to $00 for its high byte
+    c.op("ldx#", 0x0F)
+    c.op("lda_indx", 0xF0)
+    check_a(data(0x3140))
+    c.op("ldy#", 0x07)
+    c.op("lda_indy", 0x20)
+    check_a(data(0x3007))
+    c.op("ldy#", 0x10)
+    c.op("lda_indy", 0x22)
+    check_a(data(0x3108))
+
+    # Stores, read back through a different addressing mode
+    c.op("lda#", 0xC3)
+    c.op("ldx#", 0x10)
+    c.op("sta_absx", 0x0400)
+    c.op("lda_abs", 0x0410)
+    check_a(0xC3)
+    c.op("lda#", 0x12)
+    c.op("ldy#", 0xF0)
+    c.op("sta_absy", 0x0410)
+    c.op("ldx#", 0x00)
+    c.op("lda_absx", 0x0500)
+    check_a(0x12)
+    c.op("lda#", 0x3C)
+    c.op("ldy#", 0x21)
+    c.op("sta_indy", 0x30)
+    c.op("ldx#", 0x21)
+    c.op("lda_absx", 0x0400)
+    check_a(0x3C)
+    c.op("lda#", 0x99)
+    c.op("ldx#", 0x0F)
+    c.op("sta_indx", 0xF0)
+    c.op("lda_abs", 0x3140)
+    check_a(0x99)
+    c.op("lda#", data(0x3140))
+    c.op("sta_abs", 0x3140)
+    c.op("lda#", 0x44)
+    c.op("ldx#", 0x30)
+    c.op("sta_zpx", 0x10)
+    c.op("ldy_zp", 0x40)
+    c.op("sty_zp", SCRATCH)
+    c.check(0x44)
+    c.op("ldx#", 0x77)
+    c.op("ldy#", 0x10)
+    c.op("stx_zpy", 0x31)
+    c.op("lda_zp", 0x41)
+    check_a(0x77)
+    c.op("ldy#", 0x66)
+    c.op("ldx#", 0x12)
+    c.op("sty_zpx", 0x30)
+    c.op("lda_zp", 0x42)
+    check_a(0x66)
+    c.op("ldx#", 0x81)
+    c.op("stx_abs", 0x0600)
+    c.op("ldy#", 0x82)
+    c.op("sty_abs", 0x0601)
+    c.op("lda_abs", 0x0600)
+    check_a(0x81)
+    c.op("lda_abs", 0x0601)
+    check_a(0x82)
+
+    c.count(INNER)
+    c.jump(INNER_JUMP, INNER)
+    assert c.pc < PASS_STUB
+
+
+def hex_records():
+    lines = []
+    addresses = sorted(memory)
+    run = []
+    for address in addresses:
+        if run and (address != run[0] + len(run) or len(run) == 16 or address & 0xF == 0):
+            lines.append(record(run[0], [memory[a] for a in range(run[0], run[0] + len(run))]))
+            run = []
+        run.append(address)
+    if run:
+        lines.append(record(run[0], [memory[a] for a in range(run[0], run[0] + len(run))]))
+    lines.append(":00000001FF")
+    return lines
+
+
+def record(address, payload):
+    fields = [len(payload), address >> 8, address & 0xFF, 0x00] + payload
+    checksum = -sum(fields) & 0xFF
+    return ":" + "".join("%02X" % b for b in fields + [checksum])
+
+
+build()
+sys.stdout.write("\n".join(hex_records()) + "\n")
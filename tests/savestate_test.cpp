@@ -0,0 +1,179 @@
+#include <cpu6502/machine.hpp>
+#include <cpu6502/savestate.hpp>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+std::string TempPath(const std::string &name) { return ::testing::TempDir() + name; }
+
+std::vector<char> ReadFile(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+void WriteFile(const std::string &path, const std::vector<char> &bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// LDA #$00 at $8000 (sets Z), then LDX #$80 (sets N) when run further.
+void PrepareMachine(Machine &machine) {
+    machine.memory.WriteWord(0xFFFC, 0x8000);
+    machine.memory.WriteByte(0x8000, 0xA9);
+    machine.memory.WriteByte(0x8001, 0x00);
+    machine.memory.WriteByte(0x8002, 0xA2);
+    machine.memory.WriteByte(0x8003, 0x80);
+    machine.memory.WriteByte(0x0042, 0x17);
+    machine.memory.WriteByte(0x1234, 0x56);
+    machine.cpu.Reset();
+    machine.cpu.Execute(2);
+    machine.cpu.Y = 0x33;
+}
+} // namespace
+
+TEST(SaveStateTest, RoundTripRestoresRegistersAndMemory) {
+    Machine machine;
+    PrepareMachine(machine);
+    const std::string path = TempPath("roundtrip.s65");
+    SaveState::Save(path, machine.cpu, machine.memory);
+
+    Machine restored;
+    restored.memory.WriteByte(0x5000, 0xEE);
+    SaveState::Load(path, restored.cpu, restored.memory);
+
+    EXPECT_EQ(restored.cpu.PC, machine.cpu.PC);
+    EXPECT_EQ(restored.cpu.SP, machine.cpu.SP);
+    EXPECT_EQ(restored.cpu.A, 0x00);
+    EXPECT_EQ(restored.cpu.Y, 0x33);
+    EXPECT_EQ(restored.cpu.cycles, machine.cpu.cycles);
+    EXPECT_EQ(restored.memory.ReadByte(0x0042), 0x17);
+    EXPECT_EQ(restored.memory.ReadByte(0x1234), 0x56);
+    EXPECT_EQ(restored.memory.ReadByte(0x5000), 0x00);
+
+    // Flags are only observable through the file, so saving the restored machine must give identical bytes.
+    const std::string again = TempPath("roundtrip_again.s65");
+    SaveState::Save(again, restored.cpu, restored.memory);
+    EXPECT_EQ(ReadFile(again), ReadFile(path));
+
+    restored.cpu.Execute(2);
+    machine.cpu.Execute(2);
+    EXPECT_EQ(restored.cpu.X, 0x80);
+    EXPECT_EQ(restored.cpu.PC, machine.cpu.PC);
+}
+
+TEST(SaveStateTest, RoundTripRestoresInterruptLines) {
+    Machine machine;
+    PrepareMachine(machine);
+    machine.memory.WriteWord(0xFFFA, 0x9100);
+    machine.cpu.SetIRQ(true);
+    machine.cpu.TriggerNMI();
+    const std::string path = TempPath("lines.s65");
+    SaveState::Save(path, machine.cpu, machine.memory);
+
+    Machine restored;
+    SaveState::Load(path, restored.cpu, restored.memory);
+    const std::string again = TempPath("lines_again.s65");
+    SaveState::Save(again, restored.cpu, restored.memory);
+    EXPECT_EQ(ReadFile(again), ReadFile(path));
+
+    // The NMI is taken first and masks the held IRQ.
+    restored.cpu.Execute(7);
+    EXPECT_EQ(restored.cpu.PC, 0x9100);
+}
+
+TEST(SaveStateTest, VersionOneFilesLoadWithNoInterruptPending) {
+    Machine machine;
+    PrepareMachine(machine);
+    machine.cpu.SetIRQ(true);
+    machine.cpu.TriggerNMI();
+    const std::string path = TempPath("version1.s65");
+    SaveState::Save(path, machine.cpu, machine.memory);
+    std::vector<char> old = ReadFile(path);
+    old[4] = 1;
+    WriteFile(path, old);
+
+    Machine restored;
+    restored.cpu.SetIRQ(true);
+    SaveState::Load(path, restored.cpu, restored.memory);
+    restored.cpu.Execute(2);
+    EXPECT_EQ(restored.cpu.X, 0x80);
+    EXPECT_EQ(restored.cpu.PC, 0x8004);
+}
+
+TEST(SaveStateTest, AllZeroPagesAreNotStored) {
+    Machine machine;
+    machine.memory.WriteByte(0x0300, 0x01);
+    machine.memory.WriteByte(0x03FF, 0x02);
+    machine.memory.WriteByte(0xC000, 0x03);
+    const std::string path = TempPath("sparse.s65");
+    SaveState::Save(path, machine.cpu, machine.memory);
+
+    EXPECT_EQ(ReadFile(path).size(), (1 + 2) * PAGE_BYTES);
+}
+
+TEST(SaveStateTest, WritesAfterLoadStayOutOfTheFileAndOtherLoads) {
+    Machine machine;
+    PrepareMachine(machine);
+    const std::string path = TempPath("private.s65");
+    SaveState::Save(path, machine.cpu, machine.memory);
+    const std::vector<char> saved = ReadFile(path);
+
+    Machine first;
+    Machine second;
+    SaveState::Load(path, first.cpu, first.memory);
+    SaveState::Load(path, second.cpu, second.memory);
+    first.memory.WriteByte(0x1234, 0x99);
+    first.memory.WriteByte(0x1235, 0x98);
+
+    const Machine fork = first.Fork();
+    first.memory.WriteByte(0x1234, 0x77);
+
+    EXPECT_EQ(second.memory.ReadByte(0x1234), 0x56);
+    EXPECT_EQ(fork.memory.ReadByte(0x1234), 0x99);
+    EXPECT_EQ(first.memory.ReadByte(0x1234), 0x77);
+    EXPECT_EQ(ReadFile(path), saved);
+}
+
+TEST(SaveStateTest, LoadKeepsHostMappings) {
+    Machine machine;
+    machine.memory.WriteByte(0x2000, 0x11);
+    const std::string path = TempPath("mapped.s65");
+    SaveState::Save(path, machine.cpu, machine.memory);
+
+    Byte host[PAGE_BYTES]{};
+    host[0] = 0x22;
+    Machine target;
+    target.memory.MapRam(0x20, host);
+    SaveState::Load(path, target.cpu, target.memory);
+    EXPECT_EQ(target.memory.ReadByte(0x2000), 0x22);
+
+    target.memory.UnmapPage(0x20);
+    EXPECT_EQ(target.memory.ReadByte(0x2000), 0x11);
+}
+
+TEST(SaveStateTest, RejectsForeignTruncatedAndNewerFiles) {
+    Machine machine;
+    machine.memory.WriteByte(0x0400, 0x01);
+    const std::string path = TempPath("invalid.s65");
+    SaveState::Save(path, machine.cpu, machine.memory);
+    const std::vector<char> saved = ReadFile(path);
+
+    std::vector<char> foreign = saved;
+    foreign[0] = 'X';
+    WriteFile(path, foreign);
+    EXPECT_THROW(SaveState::Load(path, machine.cpu, machine.memory), std::runtime_error);
+
+    std::vector<char> newer = saved;
+    newer[4] = static_cast<char>(SaveState::VERSION + 1);
+    WriteFile(path, newer);
+    EXPECT_THROW(SaveState::Load(path, machine.cpu, machine.memory), std::runtime_error);
+
+    WriteFile(path, std::vector<char>(saved.begin(), saved.end() - 1));
+    EXPECT_THROW(SaveState::Load(path, machine.cpu, machine.memory), std::runtime_error);
+    EXPECT_THROW(SaveState::Load(TempPath("missing.s65"), machine.cpu, machine.memory), std::runtime_error);
+    EXPECT_EQ(machine.memory.ReadByte(0x0400), 0x01);
+}
@@ -0,0 +1,153 @@
+#include <cpu6502/debugger.hpp>
+#include <cpu6502/scheduler.hpp>
+#include <functional>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+// NOPs from $8000, two cycles each.
+void LoadNops(Memory &memory) {
+    memory.WriteWord(0xFFFC, 0x8000);
+    for (u32 addr = 0x8000; addr < 0xFF00; ++addr)
+        memory.WriteByte(static_cast<Word>(addr), 0xEA);
+}
+
+// Schedules an event ten cycles after every write to its page, recording when the write happened.
+class DelayDevice final : public BusDevice {
+public:
+    Scheduler *scheduler = nullptr;
+    std::vector<u64> writes;
+    std::vector<u64> fired;
+
+    Byte Read(Word) override { return 0x00; }
+    void Write(Word, Byte) override {
+        writes.push_back(scheduler->Now());
+        scheduler->ScheduleIn(10, [this](u64) { fired.push_back(scheduler->Now()); });
+    }
+};
+} // namespace
+
+TEST(SchedulerTest, RunsUntilEachEventAndFiresInOrder) {
+    Memory memory;
+    LoadNops(memory);
+    CPU cpu(memory);
+    cpu.Reset();
+    Scheduler scheduler;
+    std::vector<u64> fired;
+    std::vector<u64> seen;
+    for (const u64 when : {25u, 10u, 10u, 40u}) {
+        scheduler.Schedule(when, [&](const u64 due) {
+            fired.push_back(due);
+            seen.push_back(scheduler.Now());
+        });
+    }
+
+    EXPECT_EQ(scheduler.Run(cpu, 30), 30u);
+    EXPECT_EQ(fired, (std::vector<u64>{10, 10, 25}));
+    // NOPs land on even cycles, so the event at 25 fires after the instruction that reaches 26.
+    EXPECT_EQ(seen, (std::vector<u64>{10, 10, 26}));
+    EXPECT_EQ(scheduler.Pending(), 1u);
+    EXPECT_EQ(scheduler.NextEvent(), 40u);
+    EXPECT_EQ(cpu.cycles, 6u + 30u);
+}
+
+TEST(SchedulerTest, PeriodicEventsDoNotDrift) {
+    Memory memory;
+    LoadNops(memory);
+    CPU cpu(memory);
+    cpu.Reset();
+    Scheduler scheduler;
+    std::vector<u64> ticks;
+    std::function<void(u64)> timer = [&](const u64 due) {
+        ticks.push_back(due);
+        scheduler.Schedule(due + 7, timer);
+    };
+    scheduler.Schedule(7, timer);
+
+    scheduler.Run(cpu, 100);
+    ASSERT_EQ(ticks.size(), 14u);
+    for (std::size_t i = 0; i < ticks.size(); ++i)
+        EXPECT_EQ(ticks[i], 7 * (i + 1));
+    EXPECT_EQ(scheduler.NextEvent(), 105u);
+}
+
+TEST(SchedulerTest, CancelledEventsDoNotFire) {
+    Memory memory;
+    LoadNops(memory);
+    CPU cpu(memory);
+    cpu.Reset();
+    Scheduler scheduler;
+    int fired = 0;
+    const Scheduler::EventId first = scheduler.Schedule(10, [&](u64) { ++fired; });
+    const Scheduler::EventId second = scheduler.Schedule(20, [&](u64) { ++fired; });
+    scheduler.Schedule(30, [&](u64) { fired += 10; });
+
+    EXPECT_TRUE(scheduler.Cancel(first));
+    EXPECT_FALSE(scheduler.Cancel(first));
+    EXPECT_EQ(scheduler.NextEvent(), 20u);
+    EXPECT_TRUE(scheduler.Cancel(second));
+    EXPECT_EQ(scheduler.NextEvent(), 30u);
+    scheduler.Run(cpu, 40);
+    EXPECT_EQ(fired, 10);
+    EXPECT_EQ(scheduler.Pending(), 0u);
+    EXPECT_EQ(scheduler.NextEvent(), Scheduler::NO_EVENT);
+}
+
+TEST(SchedulerTest, KeepsCountingWhenTheCPUCycleCounterWraps) {
+    Memory memory;
+    LoadNops(memory);
+    CPU cpu(memory);
+    cpu.Reset();
+    cpu.cycles = 0xFFFFFFF0u;
+    Scheduler scheduler;
+    u64 seen = 0;
+    scheduler.Schedule(0x20, [&](u64) { seen = scheduler.Now(); });
+
+    EXPECT_EQ(scheduler.Run(cpu, 0x40), 0x40u);
+    EXPECT_EQ(seen, 0x20u);
+    EXPECT_EQ(cpu.cycles, 0x30u);
+    EXPECT_EQ(scheduler.Now(), 0x40u);
+}
+
+TEST(SchedulerTest, EventScheduledByADeviceCountsFromTheWriteAndCutsTheSliceShort) {
+    Memory memory;
+    LoadNops(memory);
+    // STA $D000 after two NOPs
+    const Byte store[] = {0x8D, 0x00, 0xD0};
+    memory.WriteBlock(0x8002, store, sizeof(store));
+    Scheduler scheduler;
+    DelayDevice device;
+    device.scheduler = &scheduler;
+    memory.MapDevice(0xD0, 0xD0, &device);
+    CPU cpu(memory);
+    cpu.Reset();
+
+    EXPECT_EQ(scheduler.Run(cpu, 100), 100u);
+    // The store writes in its last cycle, after 7, so the event due at 17 fires after the NOP that reaches 18.
+    EXPECT_EQ(device.writes, (std::vector<u64>{7}));
+    EXPECT_EQ(device.fired, (std::vector<u64>{18}));
+    EXPECT_EQ(scheduler.Now(), 100u);
+}
+
+TEST(SchedulerTest, BreakpointStopsRun) {
+    Memory memory;
+    LoadNops(memory);
+    CPU cpu(memory);
+    Debugger debugger(memory);
+    cpu.SetDebugger(&debugger);
+    debugger.AddBreakpoint(0x8010);
+    cpu.Reset();
+    Scheduler scheduler;
+    int fired = 0;
+    scheduler.Schedule(50, [&](u64) { ++fired; });
+
+    EXPECT_EQ(scheduler.Run(cpu, 100), 32u);
+    EXPECT_EQ(cpu.PC, 0x8010);
+    EXPECT_EQ(debugger.LastStop().kind, StopKind::Breakpoint);
+    EXPECT_EQ(fired, 0);
+
+    // Running again resumes over the breakpoint.
+    EXPECT_EQ(scheduler.Run(cpu, 68), 68u);
+    EXPECT_EQ(scheduler.Now(), 100u);
+    EXPECT_EQ(fired, 1);
+}
@@ -0,0 +1,158 @@
+#include <cpu6502/opcodes.hpp>
+#include <cpu6502/stepped.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+// Every implemented opcode from $8080: SEI, the other opcodes in opcode order with $F8 $30 or $20 as operand bytes,
+// CLI, BRK and RTI. $20 points to $30F8. BRK and interrupts go to an RTI at $9000, and the closing RTI pulls $8080
+// from the stack page, which is filled with $80, so the program loops.
+void LoadEveryOpcode(Memory &memory) {
+    memory.WriteWord(0xFFFC, 0x8080);
+    memory.WriteWord(0xFFFE, 0x9000);
+    memory.WriteWord(0xFFFA, 0x9000);
+    memory.WriteByte(0x9000, 0x40);
+    memory.WriteWord(0x0020, 0x30F8);
+    memory.WriteWord(0x0030, 0x3000);
+    for (u32 addr = 0x0100; addr < 0x0200; ++addr)
+        memory.WriteByte(static_cast<Word>(addr), 0x80);
+    for (u32 addr = 0x3000; addr < 0x3200; ++addr)
+        memory.WriteByte(static_cast<Word>(addr), static_cast<Byte>(addr * 7));
+    std::vector<Byte> program = {0x78};
+    for (u32 code = 0; code < 256; ++code) {
+        const auto opcode = static_cast<Byte>(code);
+        if (!IsImplemented(opcode) || opcode == 0x00 || opcode == 0x40 || opcode == 0x58 || opcode == 0x78)
+            continue;
+        const Byte length = OPCODES[opcode].length;
+        program.push_back(opcode);
+        if (length >= 2)
+            program.push_back(length == 2 ? 0x20 : 0xF8);
+        if (length == 3)
+            program.push_back(0x30);
+    }
+    program.insert(program.end(), {0x58, 0x00, 0xEA, 0x40});
+    memory.WriteBlock(0x8080, program.data(), program.size());
+}
+
+std::vector<BusAccess> StepInstruction(SteppedCPU &stepped) {
+    std::vector<BusAccess> accesses;
+    do
+        accesses.push_back(stepped.Step());
+    while (!stepped.AtInstructionBoundary());
+    return accesses;
+}
+} // namespace
+
+TEST(SteppedCPUTest, MatchesInterpreterOnEveryImplementedOpcode) {
+    Memory reference_memory;
+    LoadEveryOpcode(reference_memory);
+    Memory memory;
+    LoadEveryOpcode(memory);
+    CPU reference(reference_memory);
+    CPU cpu(memory);
+    reference.Reset();
+    cpu.Reset();
+    reference.X = cpu.X = 0x10;
+    reference.Y = cpu.Y = 0x10;
+    SteppedCPU stepped(cpu);
+
+    for (u32 step = 0; step < 500; ++step) {
+        // Interrupts are raised now and then, and the IRQ line is left asserted for a while.
+        if (step % 97 == 40) {
+            reference.TriggerNMI();
+            cpu.TriggerNMI();
+        }
+        if (step % 61 == 7 || step % 61 == 30) {
+            reference.SetIRQ(step % 61 == 7);
+            cpu.SetIRQ(step % 61 == 7);
+        }
+        const Word pc = reference.PC;
+        reference.Execute(1);
+        StepInstruction(stepped);
+        ASSERT_EQ(cpu.PC, reference.PC) << std::hex << pc;
+        ASSERT_EQ(cpu.cycles, reference.cycles) << std::hex << pc;
+        ASSERT_EQ(cpu.A, reference.A) << std::hex << pc;
+        ASSERT_EQ(cpu.X, reference.X) << std::hex << pc;
+        ASSERT_EQ(cpu.Y, reference.Y) << std::hex << pc;
+        ASSERT_EQ(cpu.StatusRegister(), reference.StatusRegister()) << std::hex << pc;
+    }
+    for (u32 addr = 0; addr < MAX_MEM; ++addr)
+        ASSERT_EQ(memory.ReadByte(static_cast<Word>(addr)), reference_memory.ReadByte(static_cast<Word>(addr)));
+}
+
+TEST(SteppedCPUTest, ReportsEveryBusCycle) {
+    Memory memory;
+    memory.WriteWord(0xFFFC, 0x8000);
+    memory.WriteByte(0x3108, 0x5A);
+    // LDA $30F8,X; STA $0200,X
+    const Byte program[] = {0xBD, 0xF8, 0x30, 0x9D, 0x00, 0x02};
+    memory.WriteBlock(0x8000, program, sizeof(program));
+    CPU cpu(memory);
+    cpu.Reset();
+    cpu.X = 0x10;
+    SteppedCPU stepped(cpu);
+
+    std::vector<BusAccess> load = StepInstruction(stepped);
+    ASSERT_EQ(load.size(), 5u);
+    EXPECT_EQ(load[0].op, BusOp::Read);
+    EXPECT_EQ(load[0].address, 0x8000);
+    EXPECT_EQ(load[0].value, 0xBD);
+    EXPECT_EQ(load[2].address, 0x8002);
+    EXPECT_EQ(load[3].op, BusOp::Idle);
+    EXPECT_EQ(load[3].address, 0x3008);
+    EXPECT_EQ(load[4].op, BusOp::Read);
+    EXPECT_EQ(load[4].address, 0x3108);
+    EXPECT_EQ(load[4].value, 0x5A);
+    EXPECT_EQ(cpu.A, 0x5A);
+
+    std::vector<BusAccess> store = StepInstruction(stepped);
+    ASSERT_EQ(store.size(), 5u);
+    EXPECT_EQ(store[3].op, BusOp::Idle);
+    EXPECT_EQ(store[4].op, BusOp::Write);
+    EXPECT_EQ(store[4].address, 0x0210);
+    EXPECT_EQ(store[4].value, 0x5A);
+    EXPECT_EQ(memory.ReadByte(0x0210), 0x5A);
+}
+
+TEST(SteppedCPUTest, BusMasterCanChangeMemoryBetweenCycles) {
+    Memory memory;
+    memory.WriteWord(0xFFFC, 0x8000);
+    memory.WriteByte(0x0200, 0x11);
+    // LDA $0200
+    const Byte program[] = {0xAD, 0x00, 0x02};
+    memory.WriteBlock(0x8000, program, sizeof(program));
+    CPU cpu(memory);
+    cpu.Reset();
+    SteppedCPU stepped(cpu);
+
+    stepped.Step();
+    stepped.Step();
+    stepped.Step();
+    EXPECT_FALSE(stepped.AtInstructionBoundary());
+    // A DMA write that lands after the operand fetch but before the data read.
+    memory.WriteByte(0x0200, 0x42);
+    const BusAccess read = stepped.Step();
+    EXPECT_EQ(read.address, 0x0200);
+    EXPECT_TRUE(stepped.AtInstructionBoundary());
+    EXPECT_EQ(cpu.A, 0x42);
+    EXPECT_EQ(cpu.cycles, 6u + 4u);
+}
+
+TEST(SteppedCPUTest, ExecuteStopsAtInstructionBoundary) {
+    Memory memory;
+    memory.WriteWord(0xFFFC, 0x8000);
+    // LDA #$01; LDA $0200; NOP
+    const Byte program[] = {0xA9, 0x01, 0xAD, 0x00, 0x02, 0xEA};
+    memory.WriteBlock(0x8000, program, sizeof(program));
+    CPU cpu(memory);
+    cpu.Reset();
+    SteppedCPU stepped(cpu);
+
+    stepped.Execute(3);
+    EXPECT_TRUE(stepped.AtInstructionBoundary());
+    EXPECT_EQ(cpu.PC, 0x8005);
+    EXPECT_EQ(cpu.cycles, 6u + 6u);
+    stepped.Execute(2);
+    EXPECT_EQ(cpu.PC, 0x8006);
+    EXPECT_EQ(cpu.cycles, 6u + 8u);
+}
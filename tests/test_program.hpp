@@ -0,0 +1,15 @@
+#ifndef TEST_PROGRAM_HPP
+#define TEST_PROGRAM_HPP
+
+#include <cpu6502/mem.hpp>
+#include <initializer_list>
+
+// Writes bytes from addr and points the reset vector at them.
+inline void LoadProgram(Memory &memory, Word addr, std::initializer_list<Byte> bytes) {
+    memory.WriteByte(0xFFFC, static_cast<Byte>(addr & 0xFF));
+    memory.WriteByte(0xFFFD, static_cast<Byte>(addr >> 8));
+    for (const Byte b : bytes)
+        memory.WriteByte(addr++, b);
+}
+
+#endif // TEST_PROGRAM_HPP
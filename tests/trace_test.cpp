@@ -0,0 +1,75 @@
+#include <cpu6502/trace.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+// LDA #$80; LDX $10; STA $0200; NOP; ... at $8000
+void LoadTraceProgram(Memory &memory) {
+    memory.WriteByte(0xFFFC, 0x00);
+    memory.WriteByte(0xFFFD, 0x80);
+    memory.WriteByte(0x0010, 0x34);
+    const Byte program[] = {0xA9, 0x80, 0xA6, 0x10, 0x8D, 0x00, 0x02, 0xEA, 0xEA, 0xEA};
+    memory.WriteBlock(0x8000, program, sizeof(program));
+}
+} // namespace
+
+TEST(TraceTest, CapacityIsRoundedUpToPowerOfTwo) {
+    const TraceRing ring(5);
+    EXPECT_EQ(ring.Capacity(), 8u);
+    EXPECT_EQ(ring.Size(), 0u);
+    EXPECT_THROW(static_cast<void>(ring.Record(0)), std::out_of_range);
+}
+
+TEST(TraceTest, RecordsEveryInstructionOfTracingCPU) {
+    Memory memory;
+    LoadTraceProgram(memory);
+    TracingCPU cpu(memory);
+    TraceRing ring(16);
+    cpu.SetObserver(&ring);
+    cpu.Reset();
+    cpu.Execute(11);
+
+    ASSERT_EQ(ring.Size(), 4u);
+    EXPECT_EQ(ring.Record(0).pc, 0x8000);
+    EXPECT_EQ(ring.Record(1).opcode, 0xA6);
+    EXPECT_EQ(ring.Record(1).a, 0x80);
+    EXPECT_EQ(ring.Record(2).operand, 0x0200);
+    EXPECT_EQ(ring.Record(2).length, 3);
+    EXPECT_EQ(ring.Record(3).pc, 0x8007);
+    EXPECT_EQ(ring.Record(3).cycles, 15u);
+}
+
+TEST(TraceTest, KeepsOnlyTheNewestRecordsWhenFull) {
+    Memory memory;
+    LoadTraceProgram(memory);
+    TracingCPU cpu(memory);
+    TraceRing ring(2);
+    cpu.SetObserver(&ring);
+    cpu.Reset();
+    cpu.Execute(15);
+
+    EXPECT_EQ(ring.Recorded(), 6u);
+    ASSERT_EQ(ring.Size(), 2u);
+    EXPECT_EQ(ring.Record(0).pc, 0x8008);
+    EXPECT_EQ(ring.Record(1).pc, 0x8009);
+
+    ring.Clear();
+    EXPECT_EQ(ring.Size(), 0u);
+}
+
+TEST(TraceTest, DumpFormatsOldestFirst) {
+    Memory memory;
+    LoadTraceProgram(memory);
+    TracingCPU cpu(memory);
+    TraceRing ring(8);
+    cpu.SetObserver(&ring);
+    cpu.Reset();
+    cpu.Execute(9);
+
+    std::ostringstream out;
+    ring.Dump(out, 2);
+    EXPECT_EQ(out.str(), "8002  A6 10     A:80 X:00 Y:00 SP:FD P:A4 CYC:8\n"
+                         "8004  8D 00 02  A:80 X:34 Y:00 SP:FD P:24 CYC:11\n");
+    EXPECT_EQ(out.flags() & std::ios::basefield, std::ios::dec);
+}
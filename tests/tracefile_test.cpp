@@ -0,0 +1,165 @@
+#include <cpu6502/tracefile.hpp>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+std::string TempPath(const std::string &name) { return ::testing::TempDir() + name; }
+
+// Repeats LDA #i; STA $0300,X; LDX $10; LDY #i; NOP from $8000 up to the top of memory, where PC wraps into
+// zero-filled (BRK) pages.
+void LoadStraightProgram(Memory &memory) {
+    memory.WriteByte(0x0010, 0x05);
+    Word pc = 0x8000;
+    for (Byte i = 0; pc < 0xFFF0; ++i) {
+        const Byte block[] = {0xA9, i, 0x9D, 0x00, 0x03, 0xA6, 0x10, 0xA0, static_cast<Byte>(i ^ 0x80), 0xEA};
+        memory.WriteBlock(pc, block, sizeof(block));
+        pc = static_cast<Word>(pc + sizeof(block));
+    }
+    memory.WriteWord(0xFFFC, 0x8000);
+}
+
+// Keeps a copy of every record and forwards it to the writer.
+class TeeObserver final : public InstructionObserver {
+public:
+    explicit TeeObserver(InstructionObserver &target) : next(target) {}
+
+    void OnInstruction(const InstructionRecord &record) override {
+        records.push_back(record);
+        next.OnInstruction(record);
+    }
+
+    InstructionObserver &next;
+    std::vector<InstructionRecord> records;
+};
+
+std::vector<InstructionRecord> WriteTrace(const std::string &path, const u32 cycles, const std::size_t chunk) {
+    Memory memory;
+    LoadStraightProgram(memory);
+    TracingCPU cpu(memory);
+    TraceFileWriter writer(path, chunk);
+    TeeObserver tee(writer);
+    cpu.SetObserver(&tee);
+    cpu.Reset();
+    cpu.Execute(cycles);
+    writer.Close();
+    return tee.records;
+}
+
+void ExpectSameRecord(const InstructionRecord &actual, const InstructionRecord &expected) {
+    EXPECT_EQ(actual.pc, expected.pc);
+    EXPECT_EQ(actual.operand, expected.operand);
+    EXPECT_EQ(actual.opcode, expected.opcode);
+    EXPECT_EQ(actual.length, expected.length);
+    EXPECT_EQ(actual.a, expected.a);
+    EXPECT_EQ(actual.x, expected.x);
+    EXPECT_EQ(actual.y, expected.y);
+    EXPECT_EQ(actual.sp, expected.sp);
+    EXPECT_EQ(actual.p, expected.p);
+    EXPECT_EQ(actual.cycles, expected.cycles);
+}
+} // namespace
+
+TEST(TraceFileTest, RoundTripsEveryRecordAcrossChunks) {
+    const std::string path = TempPath("roundtrip.s65t");
+    const std::vector<InstructionRecord> expected = WriteTrace(path, 20000, 64);
+
+    TraceFileReader reader(path);
+    ASSERT_EQ(reader.Count(), expected.size());
+    EXPECT_EQ(reader.Chunks(), (expected.size() + 63) / 64);
+    InstructionRecord record{};
+    for (const InstructionRecord &want : expected) {
+        ASSERT_TRUE(reader.Next(record));
+        ExpectSameRecord(record, want);
+        EXPECT_EQ(reader.Cycle(), want.cycles);
+    }
+    EXPECT_FALSE(reader.Next(record));
+}
+
+TEST(TraceFileTest, IsSmallerThanRawRecords) {
+    const std::string path = TempPath("size.s65t");
+    const std::vector<InstructionRecord> expected =
+        WriteTrace(path, 40000, TraceFileWriter::DEFAULT_CHUNK_RECORDS);
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    EXPECT_LT(static_cast<std::size_t>(in.tellg()), expected.size() * sizeof(InstructionRecord) / 3);
+}
+
+TEST(TraceFileTest, SeekCycleFindsFirstInstructionAtOrAfterCycle) {
+    const std::string path = TempPath("seek.s65t");
+    const std::vector<InstructionRecord> expected = WriteTrace(path, 20000, 64);
+
+    TraceFileReader reader(path);
+    InstructionRecord record{};
+    for (const u64 target : {u64{0}, u64{7}, u64{4321}, u64{expected.back().cycles}, u64{12345}}) {
+        reader.SeekCycle(target);
+        std::size_t want = 0;
+        while (expected[want].cycles < target)
+            ++want;
+        for (std::size_t i = want; i < want + 3 && i < expected.size(); ++i) {
+            ASSERT_TRUE(reader.Next(record));
+            ExpectSameRecord(record, expected[i]);
+        }
+    }
+
+    reader.SeekCycle(u64{expected.back().cycles} + 1);
+    EXPECT_FALSE(reader.Next(record));
+}
+
+TEST(TraceFileTest, EncodesJumpsAndExtendsCyclesPast32Bits) {
+    const std::string path = TempPath("jumps.s65t");
+    std::vector<InstructionRecord> expected;
+    {
+        TraceFileWriter writer(path, 4);
+        InstructionRecord record{0xFFF0, 0x1234, 0x20, 3, 1, 2, 3, 0xFD, 0x24, 0xFFFFFFF0u};
+        for (u32 i = 0; i < 10; ++i) {
+            expected.push_back(record);
+            writer.OnInstruction(record);
+            record.pc = static_cast<Word>(record.pc + (i % 2 ? 0x7000 : -0x10));
+            record.sp = static_cast<Byte>(record.sp - 2);
+            record.cycles += 6;
+        }
+        writer.Close();
+    }
+
+    TraceFileReader reader(path);
+    InstructionRecord record{};
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_TRUE(reader.Next(record));
+        ExpectSameRecord(record, expected[i]);
+        EXPECT_EQ(reader.Cycle(), 0xFFFFFFF0u + 6 * u64{i});
+    }
+
+    reader.SeekCycle(u64{1} << 32);
+    ASSERT_TRUE(reader.Next(record));
+    EXPECT_EQ(reader.Cycle(), 0x100000002u);
+    ExpectSameRecord(record, expected[3]);
+}
+
+TEST(TraceFileTest, EmptyTraceHasNoRecords) {
+    const std::string path = TempPath("empty.s65t");
+    TraceFileWriter(path).Close();
+
+    TraceFileReader reader(path);
+    InstructionRecord record{};
+    EXPECT_EQ(reader.Count(), 0u);
+    EXPECT_FALSE(reader.Next(record));
+    reader.SeekCycle(100);
+    EXPECT_FALSE(reader.Next(record));
+}
+
+TEST(TraceFileTest, RejectsMissingAndTruncatedFiles) {
+    EXPECT_THROW(TraceFileReader(TempPath("missing.s65t")), std::runtime_error);
+
+    const std::string path = TempPath("truncated.s65t");
+    WriteTrace(path, 2000, 64);
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    bytes.resize(bytes.size() - 1);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    out.close();
+    EXPECT_THROW(TraceFileReader{path}, std::runtime_error);
+}
@@ -0,0 +1,439 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cpu6502/config.hpp>
+#include <cpu6502/cpu.hpp>
+#include <cpu6502/loader.hpp>
+#if CPU6502_HAVE_GDB_STUB
+#include <cpu6502/gdb_stub.hpp>
+#include <unistd.h>
+#endif
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+const char *const USAGE = R"(Usage: sim6502-run [options]
+
+Runs 6502 jobs headless and writes their final state as JSON.
+
+Job options (on the command line they describe one job, or the defaults for --jobs):
+  --name NAME           label reported for the job (default: the first image)
+  --load PATH[@ADDR]    load an image; raw images go to ADDR (format from the extension: .prg, .hex/.ihx, raw)
+  --poke ADDR=HEX       write hex bytes, e.g. --poke '$8000=a9018d0002'
+  --reset ADDR          set the reset vector
+  --irq ADDR            set the IRQ/BRK vector
+  --nmi ADDR            set the NMI vector
+  --pc ADDR             start at ADDR instead of the reset vector
+  --cycles N            cycle budget (default 1000000)
+  --until-pc ADDR       stop when PC reaches ADDR
+  --trap                stop when an instruction leaves PC unchanged or the next opcode is not implemented
+  --dump ADDR:LEN       include LEN bytes from ADDR in the result
+
+Run options:
+  --jobs FILE           run one job per line of FILE; each line holds job options added to the command line's
+  --threads N           worker threads (default: all hardware threads)
+  --output FILE         write JSON to FILE instead of stdout
+  --gdb ENDPOINT        instead of running the job, serve one GDB remote session on [HOST:]PORT or a Unix socket
+                        path, then report the state the session left
+  --help                show this message
+
+Numbers are decimal, 0x-prefixed or $-prefixed hex. The exit status is 1 when a job fails, 2 on bad arguments.
+)";
+
+struct Load {
+    std::string path;
+    Word base;
+};
+
+struct Poke {
+    Word address;
+    std::vector<Byte> bytes;
+};
+
+struct Range {
+    Word address;
+    Word length;
+};
+
+struct JobSpec {
+    std::string name;
+    std::vector<Load> loads;
+    std::vector<Poke> pokes;
+    std::vector<std::pair<Word, Word>> vectors;
+    bool has_pc = false;
+    Word pc = 0;
+    u32 cycles = 1000000;
+    bool has_until = false;
+    Word until = 0;
+    bool trap = false;
+    std::vector<Range> dumps;
+};
+
+struct JobResult {
+    std::string stop;
+    std::string error;
+    Word PC = 0;
+    Byte SP = 0;
+    Byte A = 0;
+    Byte X = 0;
+    Byte Y = 0;
+    Byte P = 0;
+    u32 cycles = 0;
+    double seconds = 0.0;
+    std::vector<std::vector<Byte>> dumps;
+};
+
+struct Options {
+    JobSpec defaults;
+    std::string jobs_file;
+    unsigned threads = 0;
+    std::string output;
+    std::string gdb;
+};
+
+class UsageError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+u32 ParseNumber(const std::string &text, const u32 limit) {
+    std::size_t used = 0;
+    unsigned long value = 0;
+    try {
+        if (!text.empty() && text[0] == '$') {
+            value = std::stoul(text.substr(1), &used, 16);
+            ++used;
+        } else {
+            value = std::stoul(text, &used, 0);
+        }
+    } catch (const std::logic_error &) {
+        used = 0;
+    }
+    if (text.empty() || used != text.size() || value > limit)
+        throw UsageError("bad number '" + text + "'");
+    return static_cast<u32>(value);
+}
+
+Word ParseAddress(const std::string &text) { return static_cast<Word>(ParseNumber(text, 0xFFFF)); }
+
+// Splits "left<separator>right"; right is empty when the separator is missing and optional.
+std::pair<std::string, std::string> Split(const std::string &text, const char separator, const bool required) {
+    const std::size_t at = text.rfind(separator);
+    if (at == std::string::npos) {
+        if (required)
+            throw UsageError("expected '" + std::string(1, separator) + "' in '" + text + "'");
+        return {text, ""};
+    }
+    return {text.substr(0, at), text.substr(at + 1)};
+}
+
+std::vector<Byte> ParseHexBytes(const std::string &text) {
+    if (text.empty() || text.size() % 2 != 0)
+        throw UsageError("bad hex bytes '" + text + "'");
+    std::vector<Byte> bytes;
+    for (std::size_t i = 0; i < text.size(); i += 2)
+        bytes.push_back(static_cast<Byte>(ParseNumber("$" + text.substr(i, 2), 0xFF)));
+    return bytes;
+}
+
+// Applies one job option at args[i], advancing i past its value. Returns false for options that are not job options.
+bool ParseJobOption(JobSpec &job, const std::vector<std::string> &args, std::size_t &i) {
+    const std::string &option = args[i];
+    auto value = [&]() -> const std::string & {
+        if (i + 1 >= args.size())
+            throw UsageError(option + " needs a value");
+        return args[++i];
+    };
+    if (option == "--name") {
+        job.name = value();
+    } else if (option == "--load") {
+        const auto [path, base] = Split(value(), '@', false);
+        job.loads.push_back({path, base.empty() ? Word{0} : ParseAddress(base)});
+    } else if (option == "--poke") {
+        const auto [address, bytes] = Split(value(), '=', true);
+        Poke poke{ParseAddress(address), ParseHexBytes(bytes)};
+        if (std::size_t{poke.address} + poke.bytes.size() > MAX_MEM)
+            throw UsageError("poke '" + args[i] + "' runs past $FFFF");
+        job.pokes.push_back(std::move(poke));
+    } else if (option == "--reset") {
+        job.vectors.emplace_back(0xFFFC, ParseAddress(value()));
+    } else if (option == "--irq") {
+        job.vectors.emplace_back(0xFFFE, ParseAddress(value()));
+    } else if (option == "--nmi") {
+        job.vectors.emplace_back(0xFFFA, ParseAddress(value()));
+    } else if (option == "--pc") {
+        job.has_pc = true;
+        job.pc = ParseAddress(value());
+    } else if (option == "--cycles") {
+        job.cycles = ParseNumber(value(), 0xFFFFFFFF);
+    } else if (option == "--until-pc") {
+        job.has_until = true;
+        job.until = ParseAddress(value());
+    } else if (option == "--trap") {
+        job.trap = true;
+    } else if (option == "--dump") {
+        const auto [address, length] = Split(value(), ':', true);
+        const Range range{ParseAddress(address), static_cast<Word>(ParseNumber(length, 0xFFFF))};
+        if (static_cast<u32>(range.address) + range.length > MAX_MEM)
+            throw UsageError("dump range '" + args[i] + "' runs past $FFFF");
+        job.dumps.push_back(range);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+Options ParseOptions(const std::vector<std::string> &args) {
+    Options options;
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        if (ParseJobOption(options.defaults, args, i))
+            continue;
+        const std::string &option = args[i];
+        if (i + 1 >= args.size())
+            throw UsageError("unknown option or missing value: " + option);
+        if (option == "--jobs")
+            options.jobs_file = args[++i];
+        else if (option == "--threads")
+            options.threads = ParseNumber(args[++i], 1024);
+        else if (option == "--output")
+            options.output = args[++i];
+        else if (option == "--gdb")
+            options.gdb = args[++i];
+        else
+            throw UsageError("unknown option: " + option);
+    }
+    return options;
+}
+
+// One job per non-empty line that does not start with '#'. Words are separated by whitespace.
+std::vector<JobSpec> ReadJobs(const std::string &path, const JobSpec &defaults) {
+    std::ifstream in(path);
+    if (!in)
+        throw UsageError("cannot read jobs file " + path);
+    std::vector<JobSpec> jobs;
+    std::string line;
+    for (std::size_t number = 1; std::getline(in, line); ++number) {
+        std::istringstream words(line);
+        std::vector<std::string> args{std::istream_iterator<std::string>(words), std::istream_iterator<std::string>()};
+        if (args.empty() || args[0][0] == '#')
+            continue;
+        JobSpec job = defaults;
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            if (!ParseJobOption(job, args, i))
+                throw UsageError(path + ":" + std::to_string(number) + ": unknown job option " + args[i]);
+        }
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
+
+// Runs the job one instruction at a time while a stop condition has to be checked before each instruction.
+std::string Step(CPU &cpu, const Memory &memory, const JobSpec &job) {
+    const u32 start = cpu.cycles;
+    while (cpu.cycles - start < job.cycles) {
+        if (job.has_until && cpu.PC == job.until)
+            return "pc";
+        if (job.trap && !IsImplemented(memory.ReadByte(cpu.PC)))
+            return "trap";
+        const Word pc = cpu.PC;
+        cpu.Execute(1);
+        if (job.trap && cpu.PC == pc)
+            return "trap";
+    }
+    return "cycles";
+}
+
+JobResult RunJob(const JobSpec &job, const std::string &gdb) {
+    JobResult result;
+    const auto memory = std::make_unique<Memory>();
+    try {
+        for (const Load &load : job.loads) {
+            LoadOptions options;
+            options.base = load.base;
+            ImageLoader::LoadFile(*memory, load.path, ImageLoader::FormatForPath(load.path), options);
+        }
+        for (const Poke &poke : job.pokes)
+            memory->WriteBlock(poke.address, poke.bytes.data(), poke.bytes.size());
+    } catch (const std::exception &error) {
+        result.stop = "error";
+        result.error = error.what();
+        return result;
+    }
+    for (const auto &[vector, address] : job.vectors)
+        memory->WriteWord(vector, address);
+
+    CPU cpu(*memory);
+    const auto start = std::chrono::steady_clock::now();
+    cpu.Reset();
+    if (job.has_pc)
+        cpu.PC = job.pc;
+    const u32 first = cpu.cycles;
+    if (!gdb.empty()) {
+#if CPU6502_HAVE_GDB_STUB
+        try {
+            const int listener = GdbStub::Listen(gdb);
+            std::cerr << "sim6502-run: waiting for GDB on " << gdb << '\n';
+            int client = -1;
+            try {
+                client = GdbStub::Accept(listener);
+            } catch (const std::exception &) {
+                close(listener);
+                throw;
+            }
+            close(listener);
+            GdbStub(cpu).Serve(client);
+            result.stop = "gdb";
+        } catch (const std::exception &error) {
+            result.stop = "error";
+            result.error = error.what();
+            return result;
+        }
+#else
+        result.stop = "error";
+        result.error = "the GDB stub is not available on this host";
+        return result;
+#endif
+    } else if (job.has_until || job.trap) {
+        result.stop = Step(cpu, *memory, job);
+    } else {
+        cpu.Execute(job.cycles);
+        result.stop = "cycles";
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    result.PC = cpu.PC;
+    result.SP = static_cast<Byte>(cpu.SP);
+    result.A = cpu.A;
+    result.X = cpu.X;
+    result.Y = cpu.Y;
+    result.P = cpu.StatusRegister();
+    result.cycles = cpu.cycles - first;
+    result.seconds = elapsed.count();
+    for (const Range &range : job.dumps) {
+        std::vector<Byte> bytes(range.length);
+        for (u32 i = 0; i < range.length; ++i)
+            bytes[i] = memory->ReadByte(static_cast<Word>(range.address + i));
+        result.dumps.push_back(std::move(bytes));
+    }
+    return result;
+}
+
+std::string Quote(const std::string &text) {
+    std::string out = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+            out += escape;
+        } else {
+            out += c;
+        }
+    }
+    return out + '"';
+}
+
+double MHz(const u64 cycles, const double seconds) {
+    return seconds > 0.0 ? static_cast<double>(cycles) / seconds / 1e6 : 0.0;
+}
+
+void WriteJson(std::ostream &out, const std::vector<JobSpec> &jobs, const std::vector<JobResult> &results,
+               const unsigned threads, const double seconds) {
+    static const char HEX[] = "0123456789abcdef";
+    u64 total = 0;
+    for (const JobResult &result : results)
+        total += result.cycles;
+    out << "{\n  \"version\": " << Quote(CPU6502_VERSION) << ",\n  \"threads\": " << threads
+        << ",\n  \"wall_seconds\": " << seconds << ",\n  \"emulated_mhz\": " << MHz(total, seconds)
+        << ",\n  \"jobs\": [";
+    for (std::size_t j = 0; j < jobs.size(); ++j) {
+        const JobSpec &job = jobs[j];
+        const JobResult &result = results[j];
+        out << (j ? ",\n" : "\n") << "    {\"name\": " << Quote(job.name) << ", \"stop\": " << Quote(result.stop);
+        if (!result.error.empty()) {
+            out << ", \"error\": " << Quote(result.error) << '}';
+            continue;
+        }
+        out << ",\n     \"registers\": {\"PC\": " << result.PC << ", \"SP\": " << +result.SP << ", \"A\": " << +result.A
+            << ", \"X\": " << +result.X << ", \"Y\": " << +result.Y << ", \"P\": " << +result.P << "},\n"
+            << "     \"cycles\": " << result.cycles << ", \"wall_seconds\": " << result.seconds
+            << ", \"emulated_mhz\": " << MHz(result.cycles, result.seconds) << ",\n     \"memory\": [";
+        for (std::size_t d = 0; d < job.dumps.size(); ++d) {
+            out << (d ? ", " : "") << "{\"address\": " << job.dumps[d].address << ", \"bytes\": \"";
+            for (const Byte byte : result.dumps[d])
+                out << HEX[byte >> 4] << HEX[byte & 0x0F];
+            out << "\"}";
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    std::vector<JobSpec> jobs;
+    Options options;
+    try {
+        const std::vector<std::string> args(argv + 1, argv + argc);
+        if (std::find(args.begin(), args.end(), "--help") != args.end()) {
+            std::cout << USAGE;
+            return 0;
+        }
+        options = ParseOptions(args);
+        if (!options.gdb.empty() && !options.jobs_file.empty())
+            throw UsageError("--gdb serves a single job and cannot be combined with --jobs");
+        if (options.jobs_file.empty())
+            jobs.push_back(options.defaults);
+        else
+            jobs = ReadJobs(options.jobs_file, options.defaults);
+    } catch (const UsageError &error) {
+        std::cerr << "sim6502-run: " << error.what() << "\n\n" << USAGE;
+        return 2;
+    }
+    for (std::size_t j = 0; j < jobs.size(); ++j) {
+        if (jobs[j].name.empty())
+            jobs[j].name = jobs[j].loads.empty() ? "job " + std::to_string(j) : jobs[j].loads.front().path;
+    }
+
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(jobs.size())));
+    std::vector<JobResult> results(jobs.size());
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] {
+        for (std::size_t j = next++; j < jobs.size(); j = next++)
+            results[j] = RunJob(jobs[j], options.gdb);
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread &thread : pool)
+        thread.join();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::ofstream file;
+    if (!options.output.empty()) {
+        file.open(options.output);
+        if (!file) {
+            std::cerr << "sim6502-run: cannot write " << options.output << '\n';
+            return 1;
+        }
+    }
+    WriteJson(options.output.empty() ? std::cout : file, jobs, results, threads, elapsed.count());
+    const bool failed =
+        std::any_of(results.begin(), results.end(), [](const JobResult &result) { return !result.error.empty(); });
+    return failed ? 1 : 0;
+}